@@ -24,12 +24,15 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <getopt.h>
 
 #include <string>
 #include <stack>
+#include <vector>
 #include <memory>
+#include <chrono>
 
 #include "libde265/image.h"
 #include "libde265/fallback-dct.h"
@@ -47,12 +50,15 @@ bool show_help=false;
 bool do_check=false;
 bool do_time=false;
 bool do_eval=false;
+bool do_all=false;
 int  img_width=352;
 int  img_height=288;
 int  nframes=1000;
 int  repeat=10;
 std::string function;
 std::string input_file;
+std::string json_file;
+std::string csv_file;
 
 static struct option long_options[] = {
   {"help",    no_argument,       0, 'H' },
@@ -61,10 +67,13 @@ static struct option long_options[] = {
   {"height",  required_argument, 0, 'h' },
   {"nframes", required_argument, 0, 'n' },
   {"function",required_argument, 0, 'f' },
+  {"all",     no_argument,       0, 'a' },
   {"check",   no_argument,       0, 'c' },
   {"time",    no_argument,       0, 't' },
   {"eval",    no_argument,       0, 'e' },
   {"repeat",  required_argument, 0, 'r' },
+  {"json",    required_argument, 0, 'J' },
+  {"csv",     required_argument, 0, 'C' },
   {0,            0,              0,  0  }
 };
 
@@ -98,12 +107,151 @@ bool DSPFunc::runOnImage(std::shared_ptr<const de265_image> img, bool compareToR
 
 
 
+
+struct FuncResult
+{
+  DSPFunc* func;
+
+  int64_t nBlocks;   // per run over all images
+  double  time;      // seconds for all runs
+  double  refTime;
+  int     nMismatches;
+
+  double nsPerBlock(double t) const { return nBlocks ? t*1e9 / (nBlocks*(double)repeat) : 0; }
+};
+
+
+static bool matches(const char* name, const std::string& pattern)
+{
+  // a trailing '*' matches any suffix
+
+  if (!pattern.empty() && pattern[pattern.size()-1]=='*') {
+    return strncasecmp(name, pattern.c_str(), pattern.size()-1)==0;
+  }
+
+  return strcasecmp(name, pattern.c_str())==0;
+}
+
+
+static double time_runs(DSPFunc* func, std::shared_ptr<const de265_image> img)
+{
+  auto start = std::chrono::steady_clock::now();
+
+  for (int r=0;r<repeat;r++) {
+    func->runOnImage(img, false);
+  }
+
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end-start).count();
+}
+
+
+static const char* check_status(const FuncResult& res)
+{
+  if (!do_check || !res.func->referenceImplementation()) return "none";
+  return res.nMismatches ? "mismatch" : "ok";
+}
+
+
+static FILE* open_output(const std::string& filename)
+{
+  if (filename=="-") return stdout;
+
+  FILE* fh = fopen(filename.c_str(), "w");
+  if (fh==NULL) {
+    fprintf(stderr,"cannot write to file '%s'\n", filename.c_str());
+    exit(10);
+  }
+
+  return fh;
+}
+
+static void close_output(FILE* fh)
+{
+  if (fh != stdout) fclose(fh);
+}
+
+
+static void write_json(const std::vector<FuncResult>& results)
+{
+  FILE* fh = open_output(json_file);
+
+  fprintf(fh,"{\n  \"input\": \"%s\",\n  \"width\": %d,\n  \"height\": %d,\n"
+          "  \"repeat\": %d,\n  \"functions\": [\n",
+          input_file.c_str(), img_width, img_height, repeat);
+
+  for (size_t i=0;i<results.size();i++) {
+    const FuncResult& res = results[i];
+    DSPFunc* ref = res.func->referenceImplementation();
+
+    fprintf(fh,"    { \"function\": \"%s\", \"block_width\": %d, \"block_height\": %d, "
+            "\"blocks\": %lld",
+            res.func->name(), res.func->getBlkWidth(), res.func->getBlkHeight(),
+            (long long)res.nBlocks);
+
+    if (do_time) {
+      fprintf(fh,", \"ns_per_block\": %.2f", res.nsPerBlock(res.time));
+    }
+
+    if (ref) {
+      fprintf(fh,", \"reference\": \"%s\"", ref->name());
+
+      if (do_time) {
+        fprintf(fh,", \"reference_ns_per_block\": %.2f, \"speedup\": %.3f",
+                res.nsPerBlock(res.refTime),
+                res.time>0 ? res.refTime/res.time : 0);
+      }
+    }
+
+    fprintf(fh,", \"check\": \"%s\", \"mismatches\": %d }%s\n",
+            check_status(res), res.nMismatches, i+1<results.size() ? "," : "");
+  }
+
+  fprintf(fh,"  ]\n}\n");
+
+  close_output(fh);
+}
+
+
+static void write_csv(const std::vector<FuncResult>& results)
+{
+  FILE* fh = open_output(csv_file);
+
+  fprintf(fh,"function,block_width,block_height,blocks,ns_per_block,"
+          "reference,reference_ns_per_block,speedup,check,mismatches\n");
+
+  for (size_t i=0;i<results.size();i++) {
+    const FuncResult& res = results[i];
+    DSPFunc* ref = res.func->referenceImplementation();
+
+    fprintf(fh,"%s,%d,%d,%lld,", res.func->name(),
+            res.func->getBlkWidth(), res.func->getBlkHeight(), (long long)res.nBlocks);
+
+    if (do_time) fprintf(fh,"%.2f", res.nsPerBlock(res.time));
+
+    fprintf(fh,",%s,", ref ? ref->name() : "");
+
+    if (do_time && ref) {
+      fprintf(fh,"%.2f,%.3f", res.nsPerBlock(res.refTime),
+              res.time>0 ? res.refTime/res.time : 0);
+    }
+    else {
+      fprintf(fh,",");
+    }
+
+    fprintf(fh,",%s,%d\n", check_status(res), res.nMismatches);
+  }
+
+  close_output(fh);
+}
+
+
 int main(int argc, char** argv)
 {
   while (1) {
     int option_index = 0;
 
-    int c = getopt_long(argc, argv, "Hci:w:h:n:f:ter:", long_options, &option_index);
+    int c = getopt_long(argc, argv, "Hci:w:h:n:f:ater:", long_options, &option_index);
     if (c == -1)
       break;
 
@@ -114,10 +262,13 @@ int main(int argc, char** argv)
     case 'h': img_height=atoi(optarg); break;
     case 'n': nframes=atoi(optarg); break;
     case 'f': function=optarg; break;
+    case 'a': do_all=true; break;
     case 'i': input_file=optarg; break;
     case 't': do_time=true; break;
     case 'e': do_eval=true; break;
     case 'r': repeat=atoi(optarg); break;
+    case 'J': json_file=optarg; break;
+    case 'C': csv_file=optarg; break;
     }
   }
 
@@ -131,9 +282,14 @@ int main(int argc, char** argv)
             "  -w, --width #        input width (default: 352)\n"
             "  -h, --height #       input height (default: 288)\n"
             "  -n, --nframes #      number of frames to process (default: 1000)\n"
-            "  -f, --function NAME  which function to test (see below)\n"
+            "  -f, --function NAME  which function to test (see below),\n"
+            "                       a trailing '*' selects all functions with that prefix\n"
+            "  -a, --all            test all functions (without the *-to-be-implemented placeholders)\n"
             "  -r, --repeat #       number of repetitions for each image (default: 10)\n"
             "  -c, --check          compare function result against its reference code\n"
+            "  -t, --time           measure the time per block of the function and its reference\n"
+            "      --json FILE      write the results as JSON ('-' for stdout)\n"
+            "      --csv FILE       write the results as CSV ('-' for stdout)\n"
             "\n"
             "these functions are known:\n"
             );
@@ -156,64 +312,135 @@ int main(int argc, char** argv)
   }
 
 
-  // --- find DSP function with the given name ---
+  // --- find DSP functions with the given name ---
 
-  if (function.empty()) {
-    fprintf(stderr,"No function specified. Use option '--function'.\n");
+  if (function.empty() && !do_all) {
+    fprintf(stderr,"No function specified. Use option '--function' or '--all'.\n");
     exit(10);
   }
 
-  DSPFunc* algo = NULL;
+  std::vector<FuncResult> results;
+
   for (DSPFunc* f = DSPFunc::first; f ; f=f->next) {
-    if (strcasecmp(f->name(), function.c_str())==0) {
-      algo = f;
-      break;
+    // Placeholders of unimplemented kernels always mismatch, they can only be selected by name.
+    bool placeholder = (strstr(f->name(), "-to-be-implemented") != NULL);
+
+    if ((do_all && !placeholder) || matches(f->name(), function)) {
+      FuncResult res;
+      res.func = f;
+      res.nBlocks = 0;
+      res.time = res.refTime = 0;
+      res.nMismatches = 0;
+
+      results.insert(results.begin(), res);  // registration order is reversed
     }
   }
 
-  if (algo==NULL) {
+  if (results.empty()) {
     fprintf(stderr,"Argument to '--function' invalid. No function with that name.\n");
     exit(10);
   }
 
-  if (do_check && !algo->referenceImplementation()) {
+  const bool single = (results.size()==1);
+
+  if (do_check && single && !results[0].func->referenceImplementation()) {
     fprintf(stderr,"cannot check function result: no reference function defined for the selected function.\n");
     exit(10);
   }
 
 
-  ImageSource_YUV image_source;
-  image_source.set_input_file(input_file.c_str(), img_width, img_height);
+  // --- run each function on all images ---
 
-  int img_counter=0;
+  for (size_t i=0;i<results.size();i++) {
+    FuncResult& res = results[i];
+    DSPFunc* algo = res.func;
+    DSPFunc* ref  = algo->referenceImplementation();
+    const bool check = do_check && ref;
 
-  bool eof = false;
-  for (int f=0; f<nframes ; f++)
-    {
-      std::shared_ptr<de265_image> image(image_source.get_image());
-      if (!image) {
-        eof=true;
-        break;
-      }
+    ImageSource_YUV image_source;
+    image_source.set_input_file(input_file.c_str(), img_width, img_height);
 
-      img_counter++;
+    int img_counter=0;
 
-      if (algo->referenceImplementation()) {
-        algo->referenceImplementation()->prepareNextImage(image);
-      }
+    for (int f=0; f<nframes ; f++)
+      {
+        std::shared_ptr<de265_image> image(image_source.get_image());
+        if (!image) {
+          break;
+        }
+
+        img_counter++;
 
-      if (algo->prepareNextImage(image)) {
-        printf("run %d times on image %d\n",repeat,img_counter);
+        if (ref) {
+          ref->prepareNextImage(image);
+        }
 
-        for (int r=0;r<repeat;r++) {
-          bool success = algo->runOnImage(image, do_check);
-          if (!success) {
-            fprintf(stderr, "computation mismatch to reference implementation...\n");
-            exit(10);
+        if (algo->prepareNextImage(image)) {
+          if (single && !do_time) {
+            printf("run %d times on image %d\n",repeat,img_counter);
+          }
+
+          res.nBlocks += (image->get_width(0) /algo->getBlkWidth()) *
+                         (image->get_height(0)/algo->getBlkHeight());
+
+          if (check) {
+            if (!algo->runOnImage(image, true)) {
+              res.nMismatches++;
+            }
+          }
+
+          if (do_time) {
+            res.time += time_runs(algo, image);
+
+            if (ref) {
+              res.refTime += time_runs(ref, image);
+            }
+          }
+          else {
+            for (int r = (check ? 1 : 0) ; r<repeat ; r++) {
+              algo->runOnImage(image, false);
+            }
           }
         }
       }
+
+    algo->finishImages();
+    if (ref) {
+      ref->finishImages();
+    }
+
+    if (res.nMismatches) {
+      fprintf(stderr, "%s: computation mismatch to reference implementation in %d images\n",
+              algo->name(), res.nMismatches);
     }
 
+    if (do_time) {
+      if (ref) {
+        printf("%-40s %10.1f ns/block   %-40s %10.1f ns/block   speedup %6.2f\n",
+               algo->name(), res.nsPerBlock(res.time),
+               ref->name(), res.nsPerBlock(res.refTime),
+               res.time>0 ? res.refTime/res.time : 0);
+      }
+      else {
+        printf("%-40s %10.1f ns/block\n", algo->name(), res.nsPerBlock(res.time));
+      }
+    }
+    else if (!single && do_check) {
+      printf("%-40s %s\n", algo->name(), check_status(res));
+    }
+
+    fflush(stdout);
+  }
+
+
+  if (!json_file.empty()) write_json(results);
+  if (!csv_file .empty()) write_csv (results);
+
+  for (size_t i=0;i<results.size();i++) {
+    if (results[i].nMismatches) {
+      exit(10);
+    }
+  }
+
   return 0;
 }
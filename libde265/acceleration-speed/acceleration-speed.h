@@ -53,6 +53,7 @@ public:
   virtual DSPFunc* referenceImplementation() const { return NULL; }
 
   virtual bool prepareNextImage(std::shared_ptr<const de265_image>) = 0;
+  virtual void finishImages() { }  // free the image data after the last image
 
   bool runOnImage(std::shared_ptr<const de265_image> img, bool compareToReference);
   virtual bool compareToReferenceImplementation() { return false; }
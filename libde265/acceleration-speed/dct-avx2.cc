@@ -0,0 +1,90 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2015 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "libde265/x86/avx2-dct.h"
+#include "dct.h"
+#include "dct-scalar.h"
+
+
+class DSPFunc_IDCT_AVX2_4x4 : public DSPFunc_IDCT_Base
+{
+public:
+  DSPFunc_IDCT_AVX2_4x4() : DSPFunc_IDCT_Base(4) { }
+
+  virtual const char* name() const { return "IDCT-AVX2-4x4"; }
+
+  virtual DSPFunc* referenceImplementation() const { return &idct_scalar_4x4; }
+
+  virtual void runOnBlock(int x,int y) {
+    memset(out,0,4*4);
+    transform_4x4_add_8_avx2(out, xy2coeff(x,y), 4);
+  }
+};
+
+class DSPFunc_IDCT_AVX2_8x8 : public DSPFunc_IDCT_Base
+{
+public:
+  DSPFunc_IDCT_AVX2_8x8() : DSPFunc_IDCT_Base(8) { }
+
+  virtual const char* name() const { return "IDCT-AVX2-8x8"; }
+
+  virtual DSPFunc* referenceImplementation() const { return &idct_scalar_8x8; }
+
+  virtual void runOnBlock(int x,int y) {
+    memset(out,0,8*8);
+    transform_8x8_add_8_avx2(out, xy2coeff(x,y), 8);
+  }
+};
+
+class DSPFunc_IDCT_AVX2_16x16 : public DSPFunc_IDCT_Base
+{
+public:
+  DSPFunc_IDCT_AVX2_16x16() : DSPFunc_IDCT_Base(16) { }
+
+  virtual const char* name() const { return "IDCT-AVX2-16x16"; }
+
+  virtual DSPFunc* referenceImplementation() const { return &idct_scalar_16x16; }
+
+  virtual void runOnBlock(int x,int y) {
+    memset(out,0,16*16);
+    transform_16x16_add_8_avx2(out, xy2coeff(x,y), 16);
+  }
+};
+
+class DSPFunc_IDCT_AVX2_32x32 : public DSPFunc_IDCT_Base
+{
+public:
+  DSPFunc_IDCT_AVX2_32x32() : DSPFunc_IDCT_Base(32) { }
+
+  virtual const char* name() const { return "IDCT-AVX2-32x32"; }
+
+  virtual DSPFunc* referenceImplementation() const { return &idct_scalar_32x32; }
+
+  virtual void runOnBlock(int x,int y) {
+    memset(out,0,32*32);
+    transform_32x32_add_8_avx2(out, xy2coeff(x,y), 32);
+  }
+};
+
+DSPFunc_IDCT_AVX2_4x4   idct_avx2_4x4;
+DSPFunc_IDCT_AVX2_8x8   idct_avx2_8x8;
+DSPFunc_IDCT_AVX2_16x16 idct_avx2_16x16;
+DSPFunc_IDCT_AVX2_32x32 idct_avx2_32x32;
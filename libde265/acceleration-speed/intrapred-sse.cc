@@ -0,0 +1,69 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2015 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "libde265/x86/sse-intrapred.h"
+#include "intrapred.h"
+
+
+class DSPFunc_IntraPred_SSE : public DSPFunc_IntraPred_Base
+{
+public:
+  DSPFunc_IntraPred_SSE(enum IntraPredKernel k, int size) : DSPFunc_IntraPred_Base("SSE",k,size) { }
+
+  virtual DSPFunc* referenceImplementation() const { return intrapred_scalar(kernel,blkSize); }
+
+protected:
+  virtual void filter(uint8_t* pF, const uint8_t* p, int nT) {
+    intra_prediction_sample_filtering_8_sse(pF,p,nT);
+  }
+
+  virtual void planar(uint8_t* dst, int stride, int nT, int cIdx, const uint8_t* border) {
+    intra_prediction_planar_8_sse(dst,stride,nT,cIdx,border);
+  }
+
+  virtual void DC(uint8_t* dst, int stride, int nT, int cIdx, const uint8_t* border) {
+    intra_prediction_DC_8_sse(dst,stride,nT,cIdx,border);
+  }
+
+  virtual void angular(uint8_t* dst, int stride, int mode, int nT, int cIdx, const uint8_t* border) {
+    intra_prediction_angular_8_sse(dst,stride,false,mode,nT,cIdx,border);
+  }
+};
+
+
+DSPFunc_IntraPred_SSE intrapred_sse_filter_8  (IntraPred_Filter,  8);
+DSPFunc_IntraPred_SSE intrapred_sse_filter_16 (IntraPred_Filter, 16);
+DSPFunc_IntraPred_SSE intrapred_sse_filter_32 (IntraPred_Filter, 32);
+
+DSPFunc_IntraPred_SSE intrapred_sse_planar_4  (IntraPred_Planar,  4);
+DSPFunc_IntraPred_SSE intrapred_sse_planar_8  (IntraPred_Planar,  8);
+DSPFunc_IntraPred_SSE intrapred_sse_planar_16 (IntraPred_Planar, 16);
+DSPFunc_IntraPred_SSE intrapred_sse_planar_32 (IntraPred_Planar, 32);
+
+DSPFunc_IntraPred_SSE intrapred_sse_dc_4  (IntraPred_DC,  4);
+DSPFunc_IntraPred_SSE intrapred_sse_dc_8  (IntraPred_DC,  8);
+DSPFunc_IntraPred_SSE intrapred_sse_dc_16 (IntraPred_DC, 16);
+DSPFunc_IntraPred_SSE intrapred_sse_dc_32 (IntraPred_DC, 32);
+
+DSPFunc_IntraPred_SSE intrapred_sse_angular_4  (IntraPred_Angular,  4);
+DSPFunc_IntraPred_SSE intrapred_sse_angular_8  (IntraPred_Angular,  8);
+DSPFunc_IntraPred_SSE intrapred_sse_angular_16 (IntraPred_Angular, 16);
+DSPFunc_IntraPred_SSE intrapred_sse_angular_32 (IntraPred_Angular, 32);
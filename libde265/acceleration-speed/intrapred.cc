@@ -0,0 +1,167 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2015 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "intrapred.h"
+#include "libde265/fallback-intrapred.h"
+
+
+static const char* kernel_name[4] = { "Filter", "Planar", "DC", "Angular" };
+
+
+DSPFunc_IntraPred_Base::DSPFunc_IntraPred_Base(const char* impl, enum IntraPredKernel k, int size)
+{
+  kernel = k;
+  blkSize = size;
+  border = &border_mem[2*32];
+  nOut = 0;
+
+  char buf[100];
+  sprintf(buf, "IntraPred-%s-%s-%dx%d", kernel_name[k], impl, size, size);
+  funcname = buf;
+}
+
+
+bool DSPFunc_IntraPred_Base::prepareNextImage(std::shared_ptr<const de265_image> img)
+{
+  curr_image = img;
+  return true;
+}
+
+
+void DSPFunc_IntraPred_Base::runOnBlock(int x,int y)
+{
+  const int nT = blkSize;
+
+  const uint8_t* p = curr_image->get_image_plane(0);
+  const int stride = curr_image->get_luma_stride();
+  const int w = curr_image->get_width(0);
+  const int h = curr_image->get_height(0);
+
+  // take reference samples from the image, clamped at the image border
+
+  for (int i=-2*nT ; i<=2*nT ; i++) {
+    int xx = (i>0 ? x+i-1 : x-1);
+    int yy = (i<0 ? y-i-1 : y-1);
+    xx = libde265_max(0, libde265_min(w-1, xx));
+    yy = libde265_max(0, libde265_min(h-1, yy));
+
+    border[i] = p[xx + yy*stride];
+  }
+
+  nOut = 0;
+
+  for (int cIdx=0 ; cIdx<=1 ; cIdx++) {
+    switch (kernel) {
+    case IntraPred_Filter:
+      if (cIdx==0) {
+        uint8_t pF_mem[4*32+1];
+        filter(&pF_mem[2*32], border, nT);
+        memcpy(out[nOut++], pF_mem, 4*nT+1);
+      }
+      break;
+    case IntraPred_Planar:
+      planar(out[nOut++], nT, nT, cIdx, border);
+      break;
+    case IntraPred_DC:
+      DC(out[nOut++], nT, nT, cIdx, border);
+      break;
+    case IntraPred_Angular:
+      for (int mode=2 ; mode<=34 ; mode++) {
+        angular(out[nOut++], nT, mode, nT, cIdx, border);
+      }
+      break;
+    }
+  }
+}
+
+
+bool DSPFunc_IntraPred_Base::compareToReferenceImplementation()
+{
+  DSPFunc_IntraPred_Base* refImpl = dynamic_cast<DSPFunc_IntraPred_Base*>(referenceImplementation());
+
+  int size = (kernel==IntraPred_Filter ? 4*blkSize+1 : blkSize*blkSize);
+
+  for (int i=0;i<nOut;i++)
+    if (memcmp(out[i], refImpl->out[i], size) != 0)
+      return false;
+
+  return true;
+}
+
+
+void DSPFunc_IntraPred_Scalar::filter(uint8_t* pF, const uint8_t* p, int nT)
+{
+  intra_prediction_sample_filtering_8_fallback(pF,p,nT);
+}
+
+void DSPFunc_IntraPred_Scalar::planar(uint8_t* dst, int stride, int nT, int cIdx, const uint8_t* border)
+{
+  intra_prediction_planar_8_fallback(dst,stride,nT,cIdx,border);
+}
+
+void DSPFunc_IntraPred_Scalar::DC(uint8_t* dst, int stride, int nT, int cIdx, const uint8_t* border)
+{
+  intra_prediction_DC_8_fallback(dst,stride,nT,cIdx,border);
+}
+
+void DSPFunc_IntraPred_Scalar::angular(uint8_t* dst, int stride, int mode, int nT, int cIdx,
+                                       const uint8_t* border)
+{
+  intra_prediction_angular_8_fallback(dst,stride,false,mode,nT,cIdx,border);
+}
+
+
+// the filter is only applied for 8x8 and larger blocks
+
+DSPFunc_IntraPred_Scalar intrapred_scalar_filter_8  (IntraPred_Filter,  8);
+DSPFunc_IntraPred_Scalar intrapred_scalar_filter_16 (IntraPred_Filter, 16);
+DSPFunc_IntraPred_Scalar intrapred_scalar_filter_32 (IntraPred_Filter, 32);
+
+DSPFunc_IntraPred_Scalar intrapred_scalar_planar_4  (IntraPred_Planar,  4);
+DSPFunc_IntraPred_Scalar intrapred_scalar_planar_8  (IntraPred_Planar,  8);
+DSPFunc_IntraPred_Scalar intrapred_scalar_planar_16 (IntraPred_Planar, 16);
+DSPFunc_IntraPred_Scalar intrapred_scalar_planar_32 (IntraPred_Planar, 32);
+
+DSPFunc_IntraPred_Scalar intrapred_scalar_dc_4  (IntraPred_DC,  4);
+DSPFunc_IntraPred_Scalar intrapred_scalar_dc_8  (IntraPred_DC,  8);
+DSPFunc_IntraPred_Scalar intrapred_scalar_dc_16 (IntraPred_DC, 16);
+DSPFunc_IntraPred_Scalar intrapred_scalar_dc_32 (IntraPred_DC, 32);
+
+DSPFunc_IntraPred_Scalar intrapred_scalar_angular_4  (IntraPred_Angular,  4);
+DSPFunc_IntraPred_Scalar intrapred_scalar_angular_8  (IntraPred_Angular,  8);
+DSPFunc_IntraPred_Scalar intrapred_scalar_angular_16 (IntraPred_Angular, 16);
+DSPFunc_IntraPred_Scalar intrapred_scalar_angular_32 (IntraPred_Angular, 32);
+
+
+DSPFunc_IntraPred_Scalar* intrapred_scalar(enum IntraPredKernel k, int size)
+{
+  DSPFunc_IntraPred_Scalar* table[4][4] = {
+    { NULL, &intrapred_scalar_filter_8, &intrapred_scalar_filter_16, &intrapred_scalar_filter_32 },
+    { &intrapred_scalar_planar_4,  &intrapred_scalar_planar_8,
+      &intrapred_scalar_planar_16, &intrapred_scalar_planar_32 },
+    { &intrapred_scalar_dc_4,  &intrapred_scalar_dc_8,
+      &intrapred_scalar_dc_16, &intrapred_scalar_dc_32 },
+    { &intrapred_scalar_angular_4,  &intrapred_scalar_angular_8,
+      &intrapred_scalar_angular_16, &intrapred_scalar_angular_32 }
+  };
+
+  return table[k][Log2(size)-2];
+}
@@ -0,0 +1,90 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2015 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ACCELERATION_SPEED_INTRAPRED_H
+#define ACCELERATION_SPEED_INTRAPRED_H
+
+#include "acceleration-speed.h"
+
+
+enum IntraPredKernel {
+  IntraPred_Filter,   // [1 2 1] reference sample smoothing
+  IntraPred_Planar,
+  IntraPred_DC,
+  IntraPred_Angular   // all 33 angular modes
+};
+
+
+/* Predicts each block from reference samples taken out of the input image,
+   once for luma (with the boundary filters) and once for chroma.
+ */
+class DSPFunc_IntraPred_Base : public DSPFunc
+{
+public:
+  DSPFunc_IntraPred_Base(const char* impl, enum IntraPredKernel kernel, int size);
+
+  virtual const char* name() const { return funcname.c_str(); }
+
+  virtual int getBlkWidth()  const { return blkSize; }
+  virtual int getBlkHeight() const { return blkSize; }
+
+  virtual void runOnBlock(int x,int y);
+
+  virtual bool compareToReferenceImplementation();
+  virtual bool prepareNextImage(std::shared_ptr<const de265_image> img);
+
+protected:
+  virtual void filter(uint8_t* pF, const uint8_t* p, int nT) = 0;
+  virtual void planar(uint8_t* dst, int stride, int nT, int cIdx, const uint8_t* border) = 0;
+  virtual void DC(uint8_t* dst, int stride, int nT, int cIdx, const uint8_t* border) = 0;
+  virtual void angular(uint8_t* dst, int stride, int mode, int nT, int cIdx, const uint8_t* border) = 0;
+
+  enum IntraPredKernel kernel;
+  int blkSize;
+
+  std::string funcname;
+  std::shared_ptr<const de265_image> curr_image;
+
+  uint8_t border_mem[4*32+1 + 16];  // overread margin for the SIMD loads
+  uint8_t* border;
+
+  enum { nOutputs = 2*33 };
+  uint8_t out[nOutputs][32*32];
+  int nOut;
+};
+
+
+class DSPFunc_IntraPred_Scalar : public DSPFunc_IntraPred_Base
+{
+public:
+  DSPFunc_IntraPred_Scalar(enum IntraPredKernel k, int size) : DSPFunc_IntraPred_Base("Scalar",k,size) { }
+
+protected:
+  virtual void filter(uint8_t* pF, const uint8_t* p, int nT);
+  virtual void planar(uint8_t* dst, int stride, int nT, int cIdx, const uint8_t* border);
+  virtual void DC(uint8_t* dst, int stride, int nT, int cIdx, const uint8_t* border);
+  virtual void angular(uint8_t* dst, int stride, int mode, int nT, int cIdx, const uint8_t* border);
+};
+
+
+DSPFunc_IntraPred_Scalar* intrapred_scalar(enum IntraPredKernel k, int size);
+
+#endif
@@ -0,0 +1,768 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2015 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "kernels.h"
+#include "libde265/fallback.h"
+
+#ifdef HAVE_SSE4_1
+#include "libde265/x86/sse.h"
+#endif
+
+#ifdef HAVE_ARM
+#include "libde265/arm/arm.h"
+#endif
+
+
+enum { MCStride = 64 };  // MAX_CU_SIZE, as in the decoder
+
+static const int levelScale[] = { 40,45,51,57,64,72 };
+
+
+static uint32_t hash(uint32_t v)
+{
+  v ^= v >> 16;
+  v *= 0x7feb352d;
+  v ^= v >> 15;
+  v *= 0x846ca68b;
+  v ^= v >> 16;
+  return v;
+}
+
+
+// --- output layouts ---
+
+static KernelResult block_result(const KernelInput& in, int bytesPerSample, int stride)
+{
+  KernelResult r;
+  r.bytesPerRow = in.w * bytesPerSample;
+  r.rows        = in.h;
+  r.stride      = stride * bytesPerSample;
+  return r;
+}
+
+
+// The 'add' kernels add their result to the prediction, which we take from the image.
+
+static void copy_prediction(uint8_t* dst, const KernelInput& in)
+{
+  for (int y=0;y<in.h;y++) {
+    memcpy(dst + y*in.w, in.src8 + y*in.srcStride, in.w);
+  }
+}
+
+static void copy_prediction(uint16_t* dst, const KernelInput& in)
+{
+  for (int y=0;y<in.h;y++) {
+    memcpy(dst + y*in.w, in.src16 + y*in.srcStride, in.w*sizeof(uint16_t));
+  }
+}
+
+template <class pixel_t> static const pixel_t* source(const KernelInput& in);
+template <> const uint8_t*  source<uint8_t> (const KernelInput& in) { return in.src8; }
+template <> const uint16_t* source<uint16_t>(const KernelInput& in) { return in.src16; }
+
+template <class pixel_t> static int bit_depth() { return sizeof(pixel_t)==1 ? 8 : 10; }
+
+
+// --- motion compensation ---
+
+template <class pixel_t, int xType, int yType>  // 0: full sample, 1: fractional
+static KernelResult qpel(const acceleration_functions& a, const KernelInput& in, uint8_t* out)
+{
+  ALIGNED_16(int16_t) mcbuffer[MCStride * (MCStride+7)];
+
+  int xFrac = xType ? 1 + in.rnd % 3 : 0;
+  int yFrac = yType ? 1 + (in.rnd>>4) % 3 : 0;
+
+  a.put_hevc_qpel((int16_t*)out, MCStride, source<pixel_t>(in), in.srcStride,
+                  in.w, in.h, mcbuffer, xFrac, yFrac, bit_depth<pixel_t>());
+
+  return block_result(in, 2, MCStride);
+}
+
+template <class pixel_t, int xType, int yType>
+static KernelResult epel(const acceleration_functions& a, const KernelInput& in, uint8_t* out)
+{
+  ALIGNED_16(int16_t) mcbuffer[MCStride * (MCStride+7)];
+
+  int mx = xType ? 1 + in.rnd % 7 : 0;
+  int my = yType ? 1 + (in.rnd>>4) % 7 : 0;
+
+  const void* src = source<pixel_t>(in);
+  int16_t* dst = (int16_t*)out;
+  const int bd = bit_depth<pixel_t>();
+
+  if (xType && yType) {
+    a.put_hevc_epel_hv(dst, MCStride, src, in.srcStride, in.w, in.h, mx,my, mcbuffer, bd);
+  }
+  else if (xType) {
+    a.put_hevc_epel_h (dst, MCStride, src, in.srcStride, in.w, in.h, mx,my, mcbuffer, bd);
+  }
+  else if (yType) {
+    a.put_hevc_epel_v (dst, MCStride, src, in.srcStride, in.w, in.h, mx,my, mcbuffer, bd);
+  }
+  else {
+    a.put_hevc_epel   (dst, MCStride, src, in.srcStride, in.w, in.h, mx,my, mcbuffer, bd);
+  }
+
+  return block_result(in, 2, MCStride);
+}
+
+
+// --- weighted prediction ---
+
+template <class pixel_t>
+static KernelResult pred_unweighted(const acceleration_functions& a, const KernelInput& in, uint8_t* out)
+{
+  a.put_unweighted_pred(out, in.w, in.pred[0], in.predStride, in.w, in.h, bit_depth<pixel_t>());
+  return block_result(in, sizeof(pixel_t), in.w);
+}
+
+template <class pixel_t>
+static KernelResult pred_avg(const acceleration_functions& a, const KernelInput& in, uint8_t* out)
+{
+  a.put_weighted_pred_avg(out, in.w, in.pred[0], in.pred[1], in.predStride, in.w, in.h,
+                          bit_depth<pixel_t>());
+  return block_result(in, sizeof(pixel_t), in.w);
+}
+
+template <class pixel_t>
+static KernelResult pred_weighted(const acceleration_functions& a, const KernelInput& in, uint8_t* out)
+{
+  const int bd = bit_depth<pixel_t>();
+  int log2WD = 14-bd + in.rnd % 8;
+  int w = (int)((in.rnd>>3) & 0xFF) - 128;
+  int o = ((int)((in.rnd>>11) & 0xFF) - 128) << (bd-8);
+
+  a.put_weighted_pred(out, in.w, in.pred[0], in.predStride, in.w, in.h, w,o,log2WD, bd);
+  return block_result(in, sizeof(pixel_t), in.w);
+}
+
+template <class pixel_t>
+static KernelResult pred_bipred(const acceleration_functions& a, const KernelInput& in, uint8_t* out)
+{
+  const int bd = bit_depth<pixel_t>();
+  int log2WD = 14-bd + in.rnd % 8;
+  int w1 = (int)((in.rnd>> 3) & 0xFF) - 128;
+  int o1 = ((int)((in.rnd>>11) & 0xFF) - 128) << (bd-8);
+  int w2 = (int)((in.rnd>>19) & 0xFF) - 128;
+  int o2 = ((int)((in.rnd>>24) & 0xFF) - 128) << (bd-8);
+
+  a.put_weighted_bipred(out, in.w, in.pred[0], in.pred[1], in.predStride, in.w, in.h,
+                        w1,o1, w2,o2, log2WD, bd);
+  return block_result(in, sizeof(pixel_t), in.w);
+}
+
+
+// --- transforms without DCT ---
+
+static KernelResult transform_bypass(const acceleration_functions& a, const KernelInput& in, uint8_t* out)
+{
+  switch (in.rnd % 3) {
+  case 0: a.transform_bypass        ((int32_t*)out, in.coeffs, in.w); break;
+  case 1: a.transform_bypass_rdpcm_v((int32_t*)out, in.coeffs, in.w); break;
+  case 2: a.transform_bypass_rdpcm_h((int32_t*)out, in.coeffs, in.w); break;
+  }
+
+  return block_result(in, 4, in.w);
+}
+
+// transform_skip_8/16 are not used by the decoder anymore and their fallbacks are
+// deprecated (assert). The decoder path is transform_skip_residual + add_residual.
+
+static KernelResult transform_skip_rdpcm(const acceleration_functions& a, const KernelInput& in, uint8_t* out)
+{
+  copy_prediction(out, in);
+
+  if (in.rnd & 1) a.transform_skip_rdpcm_v<uint8_t>(out, in.coeffs, Log2(in.w), in.w, 8);
+  else            a.transform_skip_rdpcm_h<uint8_t>(out, in.coeffs, Log2(in.w), in.w, 8);
+
+  return block_result(in, 1, in.w);
+}
+
+static KernelResult transform_skip_residual(const acceleration_functions& a, const KernelInput& in, uint8_t* out)
+{
+  const int bdShift = 20-8;
+  const int tsShift = 5 + Log2(in.w);
+
+  switch (in.rnd % 3) {
+  case 0: a.transform_skip_residual((int32_t*)out, in.coeffs, in.w, tsShift, bdShift); break;
+  case 1: a.rdpcm_v                ((int32_t*)out, in.coeffs, in.w, tsShift, bdShift); break;
+  case 2: a.rdpcm_h                ((int32_t*)out, in.coeffs, in.w, tsShift, bdShift); break;
+  }
+
+  return block_result(in, 4, in.w);
+}
+
+static KernelResult rotate_coefficients(const acceleration_functions& a, const KernelInput& in, uint8_t* out)
+{
+  memcpy(out, in.coeffs, in.w*in.h*sizeof(int16_t));
+  a.rotate_coefficients((int16_t*)out, in.w);
+  return block_result(in, 2, in.w);
+}
+
+template <class pixel_t>
+static KernelResult add_residual(const acceleration_functions& a, const KernelInput& in, uint8_t* out)
+{
+  pixel_t* dst = (pixel_t*)out;
+  copy_prediction(dst, in);
+
+  a.add_residual<pixel_t>(dst, in.w, in.residual32, in.w, bit_depth<pixel_t>());
+  return block_result(in, sizeof(pixel_t), in.w);
+}
+
+
+// --- inverse transforms ---
+
+static KernelResult idst_residual(const acceleration_functions& a, const KernelInput& in, uint8_t* out)
+{
+  a.transform_idst_4x4((int32_t*)out, in.coeffs, 20-8, 15);
+  return block_result(in, 4, in.w);
+}
+
+static KernelResult idct_residual(const acceleration_functions& a, const KernelInput& in, uint8_t* out)
+{
+  int32_t* dst = (int32_t*)out;
+
+  switch (in.w) {
+  case 4:  a.transform_idct_4x4  (dst, in.coeffs, 20-8, 15); break;
+  case 8:  a.transform_idct_8x8  (dst, in.coeffs, 20-8, 15); break;
+  case 16: a.transform_idct_16x16(dst, in.coeffs, 20-8, 15); break;
+  case 32: a.transform_idct_32x32(dst, in.coeffs, 20-8, 15); break;
+  }
+
+  return block_result(in, 4, in.w);
+}
+
+template <class pixel_t>
+static KernelResult dst_add(const acceleration_functions& a, const KernelInput& in, uint8_t* out)
+{
+  pixel_t* dst = (pixel_t*)out;
+  copy_prediction(dst, in);
+
+  a.transform_4x4_dst_add<pixel_t>(dst, in.coeffs, in.w, bit_depth<pixel_t>());
+  return block_result(in, sizeof(pixel_t), in.w);
+}
+
+template <class pixel_t>
+static KernelResult idct_add(const acceleration_functions& a, const KernelInput& in, uint8_t* out)
+{
+  pixel_t* dst = (pixel_t*)out;
+  copy_prediction(dst, in);
+
+  a.transform_add<pixel_t>(Log2(in.w)-2, dst, in.coeffs, in.w, bit_depth<pixel_t>());
+  return block_result(in, sizeof(pixel_t), in.w);
+}
+
+template <class pixel_t>
+static KernelResult idct_dc_add(const acceleration_functions& a, const KernelInput& in, uint8_t* out)
+{
+  pixel_t* dst = (pixel_t*)out;
+  copy_prediction(dst, in);
+
+  a.transform_dc_add<pixel_t>(Log2(in.w)-2, dst, in.coeffsDC, in.w, bit_depth<pixel_t>());
+  return block_result(in, sizeof(pixel_t), in.w);
+}
+
+template <class pixel_t>
+static KernelResult idct_topleft_add(const acceleration_functions& a, const KernelInput& in, uint8_t* out)
+{
+  pixel_t* dst = (pixel_t*)out;
+  copy_prediction(dst, in);
+
+  a.transform_topleft4x4_add<pixel_t>(Log2(in.w)-2, dst, in.coeffsTopLeft, in.w, bit_depth<pixel_t>());
+  return block_result(in, sizeof(pixel_t), in.w);
+}
+
+
+/* The fused dequantization is optional. Without it, we dequantize like the decoder
+   and use the plain transform, which also serves as the reference. */
+
+static bool has_dequant_add(const acceleration_functions& a, uint8_t*, bool dst4x4, int sizeIdx)
+{
+  if (dst4x4) return a.transform_4x4_dst_dequant_add_8 != NULL;
+  else        return a.transform_dequant_add_8[sizeIdx] != NULL;
+}
+
+static bool has_dequant_add(const acceleration_functions& a, uint16_t*, bool dst4x4, int sizeIdx)
+{
+  if (dst4x4) return a.transform_4x4_dst_dequant_add_16 != NULL;
+  else        return a.transform_dequant_add_16[sizeIdx] != NULL;
+}
+
+template <class pixel_t, bool dst4x4>
+static KernelResult dequant_add(const acceleration_functions& a, const KernelInput& in, uint8_t* out)
+{
+  pixel_t* dst = (pixel_t*)out;
+  copy_prediction(dst, in);
+
+  const int bd = bit_depth<pixel_t>();
+  const int sizeIdx = Log2(in.w)-2;
+
+  int qP = 22 + in.rnd % 12;
+  int fact  = levelScale[qP%6] << (qP/6);
+  int shift = bd + Log2(in.w) - 5 - 4;
+
+  if (has_dequant_add(a, dst, dst4x4, sizeIdx)) {
+    if (dst4x4) a.transform_4x4_dst_dequant_add<pixel_t>(dst, in.levels, in.w, fact, shift, bd);
+    else        a.transform_dequant_add<pixel_t>(sizeIdx, dst, in.levels, in.w, fact, shift, bd);
+  }
+  else {
+    int16_t coeffs[32*32];
+    for (int i=0;i<in.w*in.h;i++) {
+      coeffs[i] = Clip3(-32768,32767, (in.levels[i]*fact + (1<<(shift-1))) >> shift);
+    }
+
+    if (dst4x4) a.transform_4x4_dst_add<pixel_t>(dst, coeffs, in.w, bd);
+    else        a.transform_add<pixel_t>(sizeIdx, dst, coeffs, in.w, bd);
+  }
+
+  return block_result(in, sizeof(pixel_t), in.w);
+}
+
+
+// --- forward transforms ---
+
+static KernelResult fwd_dst(const acceleration_functions& a, const KernelInput& in, uint8_t* out)
+{
+  a.fwd_transform_4x4_dst_8((int16_t*)out, in.residual, in.w);
+  return block_result(in, 2, in.w);
+}
+
+static KernelResult fwd_dct(const acceleration_functions& a, const KernelInput& in, uint8_t* out)
+{
+  a.fwd_transform_8[Log2(in.w)-2]((int16_t*)out, in.residual, in.w);
+  return block_result(in, 2, in.w);
+}
+
+static KernelResult hadamard(const acceleration_functions& a, const KernelInput& in, uint8_t* out)
+{
+  a.hadamard_transform_8[Log2(in.w)-2]((int16_t*)out, in.residual, in.w);
+  return block_result(in, 2, in.w);
+}
+
+
+// --- intra prediction ---
+
+// border with the layout of intra_border_computer, taken from the neighbouring samples
+template <class pixel_t>
+static void intra_border(pixel_t* border, const pixel_t* src, ptrdiff_t stride, int nT)
+{
+  for (int i=-2*nT ; i<=2*nT ; i++) {
+    border[i] = (i>0 ? src[i-1 - stride] : src[-1 + (-i-1)*stride]);
+  }
+}
+
+template <class pixel_t, int mode>  // 0: filter, 1: planar, 2: DC, 3: angular
+static KernelResult intra(const acceleration_functions& a, const KernelInput& in, uint8_t* out)
+{
+  const int nT = in.w;
+
+  pixel_t border_mem[4*32+1 + 2*16];  // overread margin for the SIMD loads
+  pixel_t* border = border_mem + 16 + 2*nT;
+  intra_border(border, source<pixel_t>(in), in.srcStride, nT);
+
+  pixel_t* dst = (pixel_t*)out;
+
+  switch (mode) {
+  case 0:
+    a.intra_prediction_sample_filtering<pixel_t>(dst + 2*nT, border, nT);
+
+    {
+      KernelResult r = { (int)sizeof(pixel_t)*(4*nT+1), 1, (int)sizeof(pixel_t)*(4*nT+1) };
+      return r;
+    }
+  case 1:
+    a.intra_prediction_planar<pixel_t>(dst, nT, nT, 0, border);
+    break;
+  case 2:
+    a.intra_prediction_DC<pixel_t>(dst, nT, nT, 0, border);
+    break;
+  case 3:
+    a.intra_prediction_angular<pixel_t>(dst, nT, bit_depth<pixel_t>(), false,
+                                        2 + in.rnd % 33, nT, 0, border);
+    break;
+  }
+
+  return block_result(in, sizeof(pixel_t), nT);
+}
+
+
+// --- table entries, to detect which kernels have optimized code ---
+
+#define ENTRY(name, expr) \
+  static const void* name(const acceleration_functions& a, int blkSize) { \
+    const int sizeIdx = Log2(blkSize)-2; (void)sizeIdx; return (const void*)(expr); }
+
+ENTRY(entry_qpel_00_8, a.put_hevc_qpel_8[0][0])
+ENTRY(entry_qpel_h_8,  a.put_hevc_qpel_8[1][0])
+ENTRY(entry_qpel_v_8,  a.put_hevc_qpel_8[0][1])
+ENTRY(entry_qpel_hv_8, a.put_hevc_qpel_8[1][1])
+ENTRY(entry_qpel_00_16, a.put_hevc_qpel_16[0][0])
+ENTRY(entry_qpel_h_16,  a.put_hevc_qpel_16[1][0])
+ENTRY(entry_qpel_v_16,  a.put_hevc_qpel_16[0][1])
+ENTRY(entry_qpel_hv_16, a.put_hevc_qpel_16[1][1])
+
+ENTRY(entry_epel_8,    a.put_hevc_epel_8)
+ENTRY(entry_epel_h_8,  a.put_hevc_epel_h_8)
+ENTRY(entry_epel_v_8,  a.put_hevc_epel_v_8)
+ENTRY(entry_epel_hv_8, a.put_hevc_epel_hv_8)
+ENTRY(entry_epel_16,    a.put_hevc_epel_16)
+ENTRY(entry_epel_h_16,  a.put_hevc_epel_h_16)
+ENTRY(entry_epel_v_16,  a.put_hevc_epel_v_16)
+ENTRY(entry_epel_hv_16, a.put_hevc_epel_hv_16)
+
+ENTRY(entry_unweighted_8,  a.put_unweighted_pred_8)
+ENTRY(entry_avg_8,         a.put_weighted_pred_avg_8)
+ENTRY(entry_weighted_8,    a.put_weighted_pred_8)
+ENTRY(entry_bipred_8,      a.put_weighted_bipred_8)
+ENTRY(entry_unweighted_16, a.put_unweighted_pred_16)
+ENTRY(entry_avg_16,        a.put_weighted_pred_avg_16)
+ENTRY(entry_weighted_16,   a.put_weighted_pred_16)
+ENTRY(entry_bipred_16,     a.put_weighted_bipred_16)
+
+ENTRY(entry_bypass,            a.transform_bypass)
+ENTRY(entry_skip_rdpcm_8,      a.transform_skip_rdpcm_v_8)
+ENTRY(entry_skip_residual,     a.transform_skip_residual)
+ENTRY(entry_rotate,            a.rotate_coefficients)
+ENTRY(entry_add_residual_8,    a.add_residual_8)
+ENTRY(entry_add_residual_16,   a.add_residual_16)
+
+ENTRY(entry_idst,     a.transform_idst_4x4)
+ENTRY(entry_idct,     (blkSize==4  ? (const void*)a.transform_idct_4x4 :
+                       blkSize==8  ? (const void*)a.transform_idct_8x8 :
+                       blkSize==16 ? (const void*)a.transform_idct_16x16 :
+                       /* */         (const void*)a.transform_idct_32x32))
+ENTRY(entry_dst_add_8,      a.transform_4x4_dst_add_8)
+ENTRY(entry_dst_add_16,     a.transform_4x4_dst_add_16)
+ENTRY(entry_idct_add_8,     a.transform_add_8[sizeIdx])
+ENTRY(entry_idct_add_16,    a.transform_add_16[sizeIdx])
+ENTRY(entry_dc_add_8,       a.transform_dc_add_8[sizeIdx])
+ENTRY(entry_dc_add_16,      a.transform_dc_add_16[sizeIdx])
+ENTRY(entry_topleft_add_8,  a.transform_topleft4x4_add_8[sizeIdx])
+ENTRY(entry_topleft_add_16, a.transform_topleft4x4_add_16[sizeIdx])
+ENTRY(entry_dst_dequant_add_8,  a.transform_4x4_dst_dequant_add_8)
+ENTRY(entry_dst_dequant_add_16, a.transform_4x4_dst_dequant_add_16)
+ENTRY(entry_dequant_add_8,      a.transform_dequant_add_8[sizeIdx])
+ENTRY(entry_dequant_add_16,     a.transform_dequant_add_16[sizeIdx])
+
+ENTRY(entry_fwd_dst,  a.fwd_transform_4x4_dst_8)
+ENTRY(entry_fwd_dct,  a.fwd_transform_8[sizeIdx])
+ENTRY(entry_hadamard, a.hadamard_transform_8[sizeIdx])
+
+ENTRY(entry_intra_filter_8,  a.intra_prediction_sample_filtering_8)
+ENTRY(entry_intra_planar_8,  a.intra_prediction_planar_8)
+ENTRY(entry_intra_DC_8,      a.intra_prediction_DC_8)
+ENTRY(entry_intra_angular_8, a.intra_prediction_angular_8)
+ENTRY(entry_intra_filter_16,  a.intra_prediction_sample_filtering_16)
+ENTRY(entry_intra_planar_16,  a.intra_prediction_planar_16)
+ENTRY(entry_intra_DC_16,      a.intra_prediction_DC_16)
+ENTRY(entry_intra_angular_16, a.intra_prediction_angular_16)
+
+#undef ENTRY
+
+
+static const int sizesPB[]     = { 4,8,16,32,64, 0 };
+static const int sizesChroma[] = { 4,8,16,32, 0 };
+static const int sizesTB[]     = { 4,8,16,32, 0 };
+static const int sizes4x4[]    = { 4, 0 };
+static const int sizes8to32[]  = { 8,16,32, 0 };
+
+
+static const KernelDescription kernels[] = {
+  { "QpelPixels",       qpel<uint8_t, 0,0>,  entry_qpel_00_8, sizesPB },
+  { "QpelH",            qpel<uint8_t, 1,0>,  entry_qpel_h_8,  sizesPB },
+  { "QpelV",            qpel<uint8_t, 0,1>,  entry_qpel_v_8,  sizesPB },
+  { "QpelHV",           qpel<uint8_t, 1,1>,  entry_qpel_hv_8, sizesPB },
+  { "QpelPixels-10bit", qpel<uint16_t,0,0>,  entry_qpel_00_16, sizesPB },
+  { "QpelH-10bit",      qpel<uint16_t,1,0>,  entry_qpel_h_16,  sizesPB },
+  { "QpelV-10bit",      qpel<uint16_t,0,1>,  entry_qpel_v_16,  sizesPB },
+  { "QpelHV-10bit",     qpel<uint16_t,1,1>,  entry_qpel_hv_16, sizesPB },
+
+  { "EpelPixels",       epel<uint8_t, 0,0>,  entry_epel_8,    sizesChroma },
+  { "EpelH",            epel<uint8_t, 1,0>,  entry_epel_h_8,  sizesChroma },
+  { "EpelV",            epel<uint8_t, 0,1>,  entry_epel_v_8,  sizesChroma },
+  { "EpelHV",           epel<uint8_t, 1,1>,  entry_epel_hv_8, sizesChroma },
+  { "EpelPixels-10bit", epel<uint16_t,0,0>,  entry_epel_16,    sizesChroma },
+  { "EpelH-10bit",      epel<uint16_t,1,0>,  entry_epel_h_16,  sizesChroma },
+  { "EpelV-10bit",      epel<uint16_t,0,1>,  entry_epel_v_16,  sizesChroma },
+  { "EpelHV-10bit",     epel<uint16_t,1,1>,  entry_epel_hv_16, sizesChroma },
+
+  { "PredUnweighted",       pred_unweighted<uint8_t>,  entry_unweighted_8,  sizesPB },
+  { "PredAvg",              pred_avg<uint8_t>,         entry_avg_8,         sizesPB },
+  { "PredWeighted",         pred_weighted<uint8_t>,    entry_weighted_8,    sizesPB },
+  { "PredBiWeighted",       pred_bipred<uint8_t>,      entry_bipred_8,      sizesPB },
+  { "PredUnweighted-10bit", pred_unweighted<uint16_t>, entry_unweighted_16, sizesPB },
+  { "PredAvg-10bit",        pred_avg<uint16_t>,        entry_avg_16,        sizesPB },
+  { "PredWeighted-10bit",   pred_weighted<uint16_t>,   entry_weighted_16,   sizesPB },
+  { "PredBiWeighted-10bit", pred_bipred<uint16_t>,     entry_bipred_16,     sizesPB },
+
+  { "TransformBypass",         transform_bypass,          entry_bypass,        sizesTB },
+  { "TransformSkipRDPCM",      transform_skip_rdpcm,      entry_skip_rdpcm_8,  sizesTB },
+  { "TransformSkipResidual",   transform_skip_residual,   entry_skip_residual, sizesTB },
+  { "RotateCoefficients",      rotate_coefficients,       entry_rotate,        sizesTB },
+  { "AddResidual",             add_residual<uint8_t>,     entry_add_residual_8,  sizesTB },
+  { "AddResidual-10bit",       add_residual<uint16_t>,    entry_add_residual_16, sizesTB },
+
+  { "IDSTResidual",            idst_residual,             entry_idst,          sizes4x4 },
+  { "IDCTResidual",            idct_residual,             entry_idct,          sizesTB },
+  { "IDSTAdd",                 dst_add<uint8_t>,          entry_dst_add_8,     sizes4x4 },
+  { "IDSTAdd-10bit",           dst_add<uint16_t>,         entry_dst_add_16,    sizes4x4 },
+  { "IDCTAdd",                 idct_add<uint8_t>,         entry_idct_add_8,    sizesTB },
+  { "IDCTAdd-10bit",           idct_add<uint16_t>,        entry_idct_add_16,   sizesTB },
+  { "IDCTDCAdd",               idct_dc_add<uint8_t>,      entry_dc_add_8,      sizesTB },
+  { "IDCTDCAdd-10bit",         idct_dc_add<uint16_t>,     entry_dc_add_16,     sizesTB },
+  { "IDCTTopLeftAdd",          idct_topleft_add<uint8_t>, entry_topleft_add_8,  sizesTB },
+  { "IDCTTopLeftAdd-10bit",    idct_topleft_add<uint16_t>,entry_topleft_add_16, sizesTB },
+  { "IDSTDequantAdd",          dequant_add<uint8_t, true>,   entry_dst_dequant_add_8,  sizes4x4 },
+  { "IDSTDequantAdd-10bit",    dequant_add<uint16_t,true>,   entry_dst_dequant_add_16, sizes4x4 },
+  { "IDCTDequantAdd",          dequant_add<uint8_t, false>,  entry_dequant_add_8,      sizesTB },
+  { "IDCTDequantAdd-10bit",    dequant_add<uint16_t,false>,  entry_dequant_add_16,     sizesTB },
+
+  { "FwdDST",                  fwd_dst,                   entry_fwd_dst,       sizes4x4 },
+  { "FwdDCT",                  fwd_dct,                   entry_fwd_dct,       sizesTB },
+  { "Hadamard",                hadamard,                  entry_hadamard,      sizesTB },
+
+  { "IntraFilter",             intra<uint8_t, 0>,         entry_intra_filter_8,   sizes8to32 },
+  { "IntraPlanar",             intra<uint8_t, 1>,         entry_intra_planar_8,   sizesTB },
+  { "IntraDC",                 intra<uint8_t, 2>,         entry_intra_DC_8,       sizesTB },
+  { "IntraAngular",            intra<uint8_t, 3>,         entry_intra_angular_8,  sizesTB },
+  { "IntraFilter-10bit",       intra<uint16_t,0>,         entry_intra_filter_16,  sizes8to32 },
+  { "IntraPlanar-10bit",       intra<uint16_t,1>,         entry_intra_planar_16,  sizesTB },
+  { "IntraDC-10bit",           intra<uint16_t,2>,         entry_intra_DC_16,      sizesTB },
+  { "IntraAngular-10bit",      intra<uint16_t,3>,         entry_intra_angular_16, sizesTB },
+};
+
+
+
+DSPFunc_Kernel::DSPFunc_Kernel(const KernelDescription& d, int size, const char* impl,
+                               const acceleration_functions* a, DSPFunc_Kernel* ref)
+  : desc(d)
+{
+  blkSize = size;
+  accel = a;
+  reference = ref;
+
+  char buf[100];
+  sprintf(buf, "%s-%s-%dx%d", desc.name, impl, size, size);
+  funcname = buf;
+
+  width = height = 0;
+  blksPerRow = 0;
+  paddedStride = 0;
+}
+
+
+bool DSPFunc_Kernel::prepareNextImage(std::shared_ptr<const de265_image> img)
+{
+  width  = img->get_width(0);
+  height = img->get_height(0);
+  blksPerRow = width/blkSize;
+
+  const uint8_t* p = img->get_image_plane(0);
+  const int stride = img->get_luma_stride();
+
+
+  // padded copies of the luma plane in 8 and 10 bit
+
+  paddedStride = width + 2*margin;
+  int paddedHeight = height + 2*margin;
+
+  padded8 .resize(paddedStride * paddedHeight);
+  padded16.resize(paddedStride * paddedHeight);
+
+  for (int y=0;y<paddedHeight;y++)
+    for (int x=0;x<paddedStride;x++) {
+      int xx = libde265_max(0, libde265_min(width -1, x-margin));
+      int yy = libde265_max(0, libde265_min(height-1, y-margin));
+      uint8_t v = p[xx + yy*stride];
+
+      padded8 [x + y*paddedStride] = v;
+      padded16[x + y*paddedStride] = (v<<2) | (v>>6);
+    }
+
+
+  // motion compensated predictions with 14 bit precision, the second one shifted
+
+  for (int i=0;i<2;i++) {
+    pred[i].resize(width*height);
+
+    for (int y=0;y<height;y++)
+      for (int x=0;x<width;x++) {
+        int xx = libde265_min(width-1, x+i);
+        int noise = (int)(hash(x + y*width + i*0x10000) & 63) - 32;
+        pred[i][x+y*width] = (p[xx + y*stride] << 6) + noise;
+      }
+  }
+
+
+  // coefficients and residuals of each block
+
+  const int blksPerCol = height/blkSize;
+  const int nBlks = blksPerRow * blksPerCol;
+  const int n2 = blkSize*blkSize;
+
+  coeffs       .assign(nBlks*n2, 0);
+  coeffsDC     .assign(nBlks*n2, 0);
+  coeffsTopLeft.assign(nBlks*n2, 0);
+  levels       .assign(nBlks*n2, 0);
+  residual     .resize(nBlks*n2);
+  residual32   .resize(nBlks*n2);
+  rnd          .resize(nBlks);
+
+  for (int by=0;by<blksPerCol;by++)
+    for (int bx=0;bx<blksPerRow;bx++) {
+      const int blkIdx = bx + by*blksPerRow;
+      const int x0 = bx*blkSize;
+      const int y0 = by*blkSize;
+      const uint8_t* src = &padded8[(y0+margin)*paddedStride + x0+margin];
+
+      uint32_t h = hash(src[0] + (x0<<8) + (y0<<20));
+      rnd[blkIdx] = h;
+
+      // Coefficients decay with the frequency and stop after a pseudo-random
+      // last position, like in real streams.
+
+      const int last = h % n2;
+
+      for (int v=0;v<blkSize;v++)
+        for (int u=0;u<blkSize;u++) {
+          const int i = u + v*blkSize;
+          const int diff = src[u + v*paddedStride] - src[u+1 + (v+1)*paddedStride];
+
+          residual  [blkIdx*n2 + i] = diff;
+          residual32[blkIdx*n2 + i] = diff;
+
+          if (u+v*blkSize <= last && (hash(h+i) & 3) != 0) {
+            int c = (diff*16) >> ((u+v)/2);
+            coeffs[blkIdx*n2 + i] = c;
+            levels[blkIdx*n2 + i] = diff >> 4;
+
+            if (u<4 && v<4) {
+              coeffsTopLeft[blkIdx*n2 + i] = c;
+            }
+          }
+        }
+
+      coeffsDC[blkIdx*n2] = coeffs[blkIdx*n2];
+    }
+
+  return true;
+}
+
+
+void DSPFunc_Kernel::finishImages()
+{
+  std::vector<uint8_t>().swap(padded8);
+  std::vector<uint16_t>().swap(padded16);
+
+  for (int i=0;i<2;i++) {
+    std::vector<int16_t>().swap(pred[i]);
+  }
+
+  std::vector<int16_t>().swap(coeffs);
+  std::vector<int16_t>().swap(coeffsDC);
+  std::vector<int16_t>().swap(coeffsTopLeft);
+  std::vector<int16_t>().swap(levels);
+  std::vector<int16_t>().swap(residual);
+  std::vector<int32_t>().swap(residual32);
+  std::vector<uint32_t>().swap(rnd);
+}
+
+
+void DSPFunc_Kernel::runOnBlock(int x,int y)
+{
+  const int blkIdx = x/blkSize + (y/blkSize)*blksPerRow;
+  const int n2 = blkSize*blkSize;
+
+  input.w = input.h = blkSize;
+
+  input.src8  = &padded8 [(y+margin)*paddedStride + x+margin];
+  input.src16 = &padded16[(y+margin)*paddedStride + x+margin];
+  input.srcStride = paddedStride;
+
+  input.pred[0] = &pred[0][x+y*width];
+  input.pred[1] = &pred[1][x+y*width];
+  input.predStride = width;
+
+  input.coeffs        = &coeffs       [blkIdx*n2];
+  input.coeffsDC      = &coeffsDC     [blkIdx*n2];
+  input.coeffsTopLeft = &coeffsTopLeft[blkIdx*n2];
+  input.levels        = &levels       [blkIdx*n2];
+  input.residual      = &residual     [blkIdx*n2];
+  input.residual32    = &residual32   [blkIdx*n2];
+  input.rnd           = rnd[blkIdx];
+
+  result = desc.func(*accel, input, out);
+}
+
+
+bool DSPFunc_Kernel::compareToReferenceImplementation()
+{
+  for (int y=0;y<result.rows;y++) {
+    if (memcmp(out + y*result.stride, reference->out + y*result.stride, result.bytesPerRow) != 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+/* Register all kernels. The 'Accel' variant is only registered when the function
+   table of this CPU has optimized code for the kernel.
+ */
+
+static acceleration_functions accel_fallback;
+static acceleration_functions accel_optimized;
+
+static bool register_kernels()
+{
+  init_acceleration_functions_fallback(&accel_fallback);
+
+  // same as base_context::set_acceleration_functions(de265_acceleration_AUTO)
+
+  init_acceleration_functions_fallback(&accel_optimized);
+#ifdef HAVE_SSE4_1
+  init_acceleration_functions_sse(&accel_optimized);
+#endif
+#ifdef HAVE_ARM
+  init_acceleration_functions_arm(&accel_optimized);
+#endif
+
+  for (size_t k=0 ; k<sizeof(kernels)/sizeof(kernels[0]) ; k++) {
+    const KernelDescription& desc = kernels[k];
+
+    for (int s=0 ; desc.sizes[s] ; s++) {
+      const int size = desc.sizes[s];
+
+      DSPFunc_Kernel* ref = new DSPFunc_Kernel(desc, size, "Fallback", &accel_fallback, NULL);
+
+      if (desc.entry(accel_optimized, size) != desc.entry(accel_fallback, size)) {
+        new DSPFunc_Kernel(desc, size, "Accel", &accel_optimized, ref);
+      }
+    }
+  }
+
+  return true;
+}
+
+static bool kernels_registered = register_kernels();
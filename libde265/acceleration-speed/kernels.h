@@ -0,0 +1,143 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2015 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ACCELERATION_SPEED_KERNELS_H
+#define ACCELERATION_SPEED_KERNELS_H
+
+#include "acceleration-speed.h"
+#include "libde265/acceleration.h"
+#include "libde265/util.h"
+
+#include <vector>
+
+
+/* Input data of one block, derived from the input image. The sample pointers
+   point into padded copies of the image, such that filters may read around the
+   block. The coefficient arrays hold blkSize*blkSize values.
+ */
+struct KernelInput
+{
+  int w,h;
+
+  const uint8_t*  src8;    // 8 bit samples
+  const uint16_t* src16;   // 10 bit samples
+  ptrdiff_t       srcStride;
+
+  const int16_t*  pred[2]; // motion compensated predictions with 14 bit precision
+  ptrdiff_t       predStride;
+
+  const int16_t*  coeffs;         // dense coefficients
+  const int16_t*  coeffsDC;       // only the DC coefficient is nonzero
+  const int16_t*  coeffsTopLeft;  // only the top-left 4x4 coefficients are nonzero
+  const int16_t*  levels;         // coefficient levels before dequantization
+  const int16_t*  residual;       // prediction residual for the forward transforms
+  const int32_t*  residual32;     // residual for add_residual()
+
+  uint32_t rnd;  // derived from position and content, used to select fractions, weights, ...
+};
+
+
+/* Where a kernel wrote its result into the output buffer. Only this part is
+   compared against the reference. */
+struct KernelResult
+{
+  int bytesPerRow;
+  int rows;
+  int stride;  // in bytes
+};
+
+
+enum { KernelOutputSize = 64*64*4 };
+
+typedef KernelResult (*KernelFunc)(const acceleration_functions& accel,
+                                   const KernelInput& in, uint8_t* out);
+
+// the table entry used by the kernel, to check whether there is optimized code for it
+typedef const void* (*KernelEntry)(const acceleration_functions& accel, int blkSize);
+
+
+struct KernelDescription
+{
+  const char* name;
+  KernelFunc  func;
+  KernelEntry entry;
+  const int*  sizes;  // list of block sizes, terminated by 0
+};
+
+
+/* Runs one entry of the acceleration_functions table on each block of the input
+   image. Every kernel is registered with the plain C function table ('Fallback')
+   and, if this CPU has optimized code for the entry, with the table that the
+   decoder uses ('Accel'). The 'Fallback' variant is the reference of the
+   'Accel' variant.
+ */
+class DSPFunc_Kernel : public DSPFunc
+{
+public:
+  DSPFunc_Kernel(const KernelDescription& desc, int blkSize, const char* impl,
+                 const acceleration_functions* accel, DSPFunc_Kernel* reference);
+
+  virtual const char* name() const { return funcname.c_str(); }
+
+  virtual int getBlkWidth()  const { return blkSize; }
+  virtual int getBlkHeight() const { return blkSize; }
+
+  virtual void runOnBlock(int x,int y);
+  virtual DSPFunc* referenceImplementation() const { return reference; }
+
+  virtual bool compareToReferenceImplementation();
+  virtual bool prepareNextImage(std::shared_ptr<const de265_image> img);
+  virtual void finishImages();
+
+private:
+  const KernelDescription& desc;
+  int blkSize;
+  std::string funcname;
+
+  const acceleration_functions* accel;
+  DSPFunc_Kernel* reference;
+
+  // image data, see KernelInput
+
+  enum { margin = 80 };
+
+  int width, height;
+  int blksPerRow;
+  int paddedStride;
+
+  std::vector<uint8_t>  padded8;
+  std::vector<uint16_t> padded16;
+  std::vector<int16_t>  pred[2];
+
+  std::vector<int16_t>  coeffs;    // blkSize*blkSize values for each block
+  std::vector<int16_t>  coeffsDC;
+  std::vector<int16_t>  coeffsTopLeft;
+  std::vector<int16_t>  levels;
+  std::vector<int16_t>  residual;
+  std::vector<int32_t>  residual32;
+  std::vector<uint32_t> rnd;       // one value for each block
+
+  KernelInput  input;
+  KernelResult result;
+  ALIGNED_16(uint8_t) out[KernelOutputSize];
+};
+
+#endif
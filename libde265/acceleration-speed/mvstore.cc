@@ -0,0 +1,311 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2015 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "mvstore.h"
+#include "libde265/sps.h"
+
+
+DSPFunc_MotionStore_Base::DSPFunc_MotionStore_Base(const char* impl, bool n)
+{
+  neighbours = n;
+
+  funcname = std::string(neighbours ? "MotionNeighbours-" : "MotionStore-") + impl;
+
+  width = height = 0;
+  lastX = lastY = 0;
+  checksum = 0;
+}
+
+
+static uint32_t hash(uint32_t v)
+{
+  v ^= v >> 16;
+  v *= 0x7feb352d;
+  v ^= v >> 15;
+  v *= 0x846ca68b;
+  v ^= v >> 16;
+  return v;
+}
+
+
+bool DSPFunc_MotionStore_Base::prepareNextImage(std::shared_ptr<const de265_image> img)
+{
+  width  = img->get_width(0);
+  height = img->get_height(0);
+
+  reset(width,height);
+
+
+  // Generate the PB partitioning of all blocks in the order in which
+  // runOnImage() processes them, such that we know the decoded neighbours.
+
+  int blksPerRow = width /64;
+  int blksPerCol = height/64;
+
+  decoded.assign((width/4) * (height/4), false);
+  decodedMotion.resize((width/4) * (height/4));
+  blockPBs.resize(blksPerRow * blksPerCol);
+
+  for (int by=0;by<blksPerCol;by++)
+    for (int bx=0;bx<blksPerRow;bx++) {
+      std::vector<PB>& pbs = blockPBs[bx + by*blksPerRow];
+      pbs.clear();
+
+      generate_partitioning(img.get(), bx*64,by*64, 6, pbs);
+    }
+
+  return true;
+}
+
+
+void DSPFunc_MotionStore_Base::generate_partitioning(const de265_image* img,
+                                                     int x0,int y0,int log2Size,
+                                                     std::vector<PB>& pbs)
+{
+  const uint8_t* p = img->get_image_plane(0);
+  const int stride = img->get_luma_stride();
+
+  uint32_t h = hash(p[x0+y0*stride] + (x0<<8) + (y0<<20) + (log2Size<<29));
+
+  // split with probability 3/4 (64x64), 1/2 (32x32), 1/4 (16x16)
+
+  if (log2Size>3 && (int)(h & 7) < 2*(log2Size-3)) {
+    int half = 1<<(log2Size-1);
+    generate_partitioning(img, x0     ,y0     , log2Size-1, pbs);
+    generate_partitioning(img, x0+half,y0     , log2Size-1, pbs);
+    generate_partitioning(img, x0     ,y0+half, log2Size-1, pbs);
+    generate_partitioning(img, x0+half,y0+half, log2Size-1, pbs);
+    return;
+  }
+
+
+  // part mode
+
+  const int s = 1<<log2Size;
+  const int q = s/4;
+  int rect[2][4];
+  int nPBs = 2;
+
+  int mode = (h>>8) & 7;
+  if (log2Size==3 && mode>=5) {
+    mode = 0;  // no AMP in 8x8 CBs
+  }
+
+  switch (mode) {
+  default: // 2Nx2N
+    rect[0][0]=0; rect[0][1]=0; rect[0][2]=s; rect[0][3]=s; nPBs=1; break;
+  case 3: // 2NxN
+    rect[0][0]=0; rect[0][1]=0;   rect[0][2]=s; rect[0][3]=s/2;
+    rect[1][0]=0; rect[1][1]=s/2; rect[1][2]=s; rect[1][3]=s/2; break;
+  case 4: // Nx2N
+    rect[0][0]=0;   rect[0][1]=0; rect[0][2]=s/2; rect[0][3]=s;
+    rect[1][0]=s/2; rect[1][1]=0; rect[1][2]=s/2; rect[1][3]=s; break;
+  case 5: // 2NxnU
+    rect[0][0]=0; rect[0][1]=0; rect[0][2]=s; rect[0][3]=q;
+    rect[1][0]=0; rect[1][1]=q; rect[1][2]=s; rect[1][3]=s-q; break;
+  case 6: // nLx2N
+    rect[0][0]=0; rect[0][1]=0; rect[0][2]=q;   rect[0][3]=s;
+    rect[1][0]=q; rect[1][1]=0; rect[1][2]=s-q; rect[1][3]=s; break;
+  }
+
+
+  const int gridStride = width/4;
+
+  for (int i=0;i<nPBs;i++) {
+    PB pb;
+    pb.x = x0+rect[i][0];
+    pb.y = y0+rect[i][1];
+    pb.w = rect[i][2];
+    pb.h = rect[i][3];
+
+    // spatial merge candidate positions A1,B1,B0,A0,B2
+
+    int nx[5] = { pb.x-1, pb.x+pb.w-1, pb.x+pb.w, pb.x-1,      pb.x-1 };
+    int ny[5] = { pb.y+pb.h-1, pb.y-1, pb.y-1,    pb.y+pb.h,   pb.y-1 };
+
+    pb.nNeighbours = 0;
+    for (int k=0;k<5;k++) {
+      if (nx[k]>=0 && ny[k]>=0 && nx[k]<width && ny[k]<height &&
+          decoded[(nx[k]>>2) + (ny[k]>>2)*gridStride]) {
+        pb.neighbour[pb.nNeighbours][0] = nx[k];
+        pb.neighbour[pb.nNeighbours][1] = ny[k];
+        pb.nNeighbours++;
+      }
+    }
+
+    // motion, every fourth PB repeats the motion of a neighbour (merge)
+
+    uint32_t hm = hash(h + i);
+
+    if ((hm & 3)==0 && pb.nNeighbours>0) {
+      pb.motion = decodedMotion[(pb.neighbour[0][0]>>2) + (pb.neighbour[0][1]>>2)*gridStride];
+    }
+    else {
+      pb.motion.predFlag[0] = 1;
+      pb.motion.predFlag[1] = (hm>>2) & 1;
+      pb.motion.refIdx[0] = (hm>>3) & 1;
+      pb.motion.refIdx[1] = pb.motion.predFlag[1] ? (hm>>4) & 1 : -1;
+      pb.motion.mv[0].x = (int16_t)(hm>>5)  % 64 - 32;
+      pb.motion.mv[0].y = (int16_t)(hm>>11) % 64 - 32;
+      pb.motion.mv[1].x = pb.motion.predFlag[1] ? (int16_t)(hm>>17) % 64 - 32 : 0;
+      pb.motion.mv[1].y = pb.motion.predFlag[1] ? (int16_t)(hm>>23) % 64 - 32 : 0;
+    }
+
+    for (int y=pb.y;y<pb.y+pb.h;y+=4)
+      for (int x=pb.x;x<pb.x+pb.w;x+=4) {
+        decoded[(x>>2) + (y>>2)*gridStride] = true;
+        decodedMotion[(x>>2) + (y>>2)*gridStride] = pb.motion;
+      }
+
+    pbs.push_back(pb);
+  }
+}
+
+
+void DSPFunc_MotionStore_Base::runOnBlock(int x,int y)
+{
+  lastX = x;
+  lastY = y;
+  checksum = 0;
+
+  // runOnImage() may process the same image several times
+  if (x==0 && y==0) {
+    start_image();
+  }
+
+  const std::vector<PB>& pbs = blockPBs[(x>>6) + (y>>6)*(width/64)];
+
+  for (size_t i=0;i<pbs.size();i++) {
+    const PB& pb = pbs[i];
+
+    store(pb.x,pb.y,pb.w,pb.h, pb.motion);
+
+    if (neighbours) {
+      // collect the candidates with pruning of equal ones, as in the merge list construction
+
+      PBMotion cand[5];
+      int nCand=0;
+
+      for (int k=0;k<pb.nNeighbours;k++) {
+        const PBMotion& mv = fetch(pb.neighbour[k][0], pb.neighbour[k][1]);
+
+        bool redundant = false;
+        for (int c=0;c<nCand;c++) {
+          if (cand[c]==mv) { redundant=true; break; }
+        }
+
+        if (!redundant) {
+          cand[nCand++] = mv;
+        }
+      }
+
+      for (int c=0;c<nCand;c++) {
+        checksum = checksum*31 + (uint16_t)cand[c].mv[0].x + ((uint16_t)cand[c].mv[0].y<<16);
+      }
+    }
+  }
+}
+
+
+bool DSPFunc_MotionStore_Base::compareToReferenceImplementation()
+{
+  DSPFunc_MotionStore_Base* refImpl = dynamic_cast<DSPFunc_MotionStore_Base*>(referenceImplementation());
+
+  if (checksum != refImpl->checksum) {
+    return false;
+  }
+
+  for (int y=lastY;y<lastY+64;y+=4)
+    for (int x=lastX;x<lastX+64;x+=4) {
+      if (!(fetch(x,y) == refImpl->fetch(x,y))) {
+        return false;
+      }
+    }
+
+  return true;
+}
+
+
+void DSPFunc_MotionStore_Replicated::reset(int w,int h)
+{
+  stride = w/4;
+  grid.assign(stride * (h/4), PBMotion());
+}
+
+
+void DSPFunc_MotionStore_Replicated::store(int x,int y,int w,int h, const PBMotion& mv)
+{
+  PBMotion* p = &grid[(x>>2) + (y>>2)*stride];
+
+  for (int pby=0;pby<(h>>2);pby++, p+=stride)
+    for (int pbx=0;pbx<(w>>2);pbx++)
+      {
+        p[pbx] = mv;
+      }
+}
+
+
+class DSPFunc_MotionStore_PBList : public DSPFunc_MotionStore_Base
+{
+public:
+  DSPFunc_MotionStore_PBList(bool neighbours)
+    : DSPFunc_MotionStore_Base("PBList",neighbours) { }
+
+  virtual DSPFunc* referenceImplementation() const;
+
+protected:
+  virtual void reset(int w,int h);
+  virtual void start_image() { img->clear_metadata(); }
+  virtual void store(int x,int y,int w,int h, const PBMotion& mv) { img->set_mv_info(x,y,w,h,mv); }
+  virtual const PBMotion& fetch(int x,int y) const { return img->get_mv_info(x,y); }
+
+  std::shared_ptr<seq_parameter_set> sps;
+  std::shared_ptr<de265_image> img;
+};
+
+
+void DSPFunc_MotionStore_PBList::reset(int w,int h)
+{
+  if (!img || img->get_width(0) != w || img->get_height(0) != h) {
+    sps = std::make_shared<seq_parameter_set>();
+    sps->set_defaults();
+    sps->set_CB_log2size_range(3,6);
+    sps->set_TB_log2size_range(2,5);
+    sps->set_resolution(w,h);
+    sps->compute_derived_values(true);
+
+    img = std::make_shared<de265_image>();
+    img->alloc_image(w,h, de265_chroma_420, sps, true, NULL, 0, NULL, false);
+  }
+}
+
+
+DSPFunc_MotionStore_Replicated motionstore_replicated(false);
+DSPFunc_MotionStore_Replicated motionneighbours_replicated(true);
+DSPFunc_MotionStore_PBList     motionstore_pblist(false);
+DSPFunc_MotionStore_PBList     motionneighbours_pblist(true);
+
+
+DSPFunc* DSPFunc_MotionStore_PBList::referenceImplementation() const
+{
+  if (neighbours) return &motionneighbours_replicated;
+  else            return &motionstore_replicated;
+}
@@ -0,0 +1,98 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2015 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ACCELERATION_SPEED_MVSTORE_H
+#define ACCELERATION_SPEED_MVSTORE_H
+
+#include "acceleration-speed.h"
+#include "libde265/motion.h"
+
+#include <vector>
+
+
+/* Stores the motion of a pseudo-random PB partitioning (derived from the input
+   image) of each 64x64 block, like decode_prediction_unit() does with
+   de265_image::set_mv_info(). The 'Neighbours' variants additionally read the
+   spatial merge candidate positions (A1,B1,B0,A0,B2) of each PB, as far as
+   they are already decoded.
+ */
+class DSPFunc_MotionStore_Base : public DSPFunc
+{
+public:
+  DSPFunc_MotionStore_Base(const char* impl, bool neighbours);
+
+  virtual const char* name() const { return funcname.c_str(); }
+
+  virtual int getBlkWidth()  const { return 64; }
+  virtual int getBlkHeight() const { return 64; }
+
+  virtual void runOnBlock(int x,int y);
+
+  virtual bool compareToReferenceImplementation();
+  virtual bool prepareNextImage(std::shared_ptr<const de265_image> img);
+
+protected:
+  virtual void reset(int w,int h) = 0;
+  virtual void start_image() { }
+  virtual void store(int x,int y,int w,int h, const PBMotion& mv) = 0;
+  virtual const PBMotion& fetch(int x,int y) const = 0;
+
+  struct PB {
+    uint16_t x,y;
+    uint8_t  w,h;
+    uint8_t  nNeighbours;
+    uint16_t neighbour[5][2]; // decoded candidate positions
+    PBMotion motion;
+  };
+
+  void generate_partitioning(const de265_image* img, int x0,int y0,int log2Size,
+                             std::vector<PB>& pbs);
+
+  bool neighbours;
+
+  std::string funcname;
+
+  int width, height;
+  std::vector<std::vector<PB> > blockPBs;  // PB list of each 64x64 block
+  std::vector<bool>     decoded;           // 4x4 grids, used while generating
+  std::vector<PBMotion> decodedMotion;
+
+  int lastX, lastY;
+  uint32_t checksum;
+};
+
+
+class DSPFunc_MotionStore_Replicated : public DSPFunc_MotionStore_Base
+{
+public:
+  DSPFunc_MotionStore_Replicated(bool neighbours)
+    : DSPFunc_MotionStore_Base("Replicated",neighbours) { }
+
+protected:
+  virtual void reset(int w,int h);
+  virtual void store(int x,int y,int w,int h, const PBMotion& mv);
+  virtual const PBMotion& fetch(int x,int y) const { return grid[(x>>2) + (y>>2)*stride]; }
+
+  std::vector<PBMotion> grid;
+  int stride;
+};
+
+#endif
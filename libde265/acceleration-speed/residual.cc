@@ -0,0 +1,197 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2015 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "residual.h"
+#include "libde265/slice.h"
+
+
+DSPFunc_Residual_Base::DSPFunc_Residual_Base(const char* impl, int log2size, bool c)
+{
+  log2TrafoSize = log2size;
+  chroma = c;
+
+  char buf[100];
+  sprintf(buf, "Residual-%s-%s-%dx%d", impl, chroma ? "Chroma" : "Luma",
+          1<<log2size, 1<<log2size);
+  funcname = buf;
+}
+
+
+bool DSPFunc_Residual_Base::prepareNextImage(std::shared_ptr<const de265_image> img)
+{
+  if (!curr_image) {
+    // we need the context index tables
+    de265_init();
+  }
+
+  curr_image = img;
+
+
+  // Generate CABAC data from the image content. Image samples alone have far too
+  // little entropy, hence we use them to seed a simple xorshift generator.
+
+  const uint8_t* p = img->get_image_plane(0);
+  const int stride = img->get_luma_stride();
+
+  uint32_t seed = 2463534242u;
+  for (int y=0;y<img->get_height(0);y++)
+    for (int x=0;x<img->get_width(0);x++) {
+      seed = seed*31 + p[x+y*stride];
+    }
+
+  for (int i=0;i<bitstreamSize;i++) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    bitstream[i] = seed >> 24;
+  }
+  memset(bitstream+bitstreamSize, 0, CABAC_DECODER_PADDING);
+
+  initialize_CABAC_models(initialModels, 0, 22 + (seed & 15));
+
+  return true;
+}
+
+
+void DSPFunc_Residual_Base::runOnBlock(int x,int y)
+{
+  const int nT = 1<<log2TrafoSize;
+
+  const uint8_t* p = curr_image->get_image_plane(0);
+  const int stride = curr_image->get_luma_stride();
+
+  uint32_t seed = p[x+y*stride] + (x<<8) + (y<<20);
+  seed = seed*1664525 + 1013904223;
+
+  // Start somewhere in the bitstream data. A valid CABAC stream starts with an
+  // offset smaller than the initial range. From then on, every bit sequence
+  // decodes to valid symbols.
+
+  const int length = 4*nT*nT;
+  int start = (seed>>4) % (bitstreamSize - 2*length);
+  while (bitstream[start] >= 0x80 && start < bitstreamSize-length) {
+    start++;
+  }
+
+  context_model model[CONTEXT_MODEL_TABLE_LENGTH];
+  memcpy(model, initialModels, sizeof(model));
+
+  CABAC_decoder decoder;
+  init_CABAC_decoder(&decoder, bitstream+start, length, true);
+  init_CABAC_decoder_2(&decoder);
+
+
+  // scanIdx!=0 only occurs for 4x4 and 8x8 blocks
+
+  const int nScans = (log2TrafoSize<=3 ? 3 : 1);
+  const int nSubBlocks = 1<<(2*(log2TrafoSize-2));
+
+  for (int scanIdx=0;scanIdx<nScans;scanIdx++) {
+    seed = seed*1664525 + 1013904223;
+    int lastSubBlock = (seed>>8) % nSubBlocks;
+    int lastScanPos  = (seed>>24) & 15;
+
+    nCoeff[scanIdx] = parse(&decoder, model, scanIdx, lastSubBlock, lastScanPos,
+                            coeffList[scanIdx], coeffPos[scanIdx]);
+  }
+}
+
+
+bool DSPFunc_Residual_Base::compareToReferenceImplementation()
+{
+  DSPFunc_Residual_Base* refImpl = dynamic_cast<DSPFunc_Residual_Base*>(referenceImplementation());
+
+  const int nScans = (log2TrafoSize<=3 ? 3 : 1);
+
+  for (int s=0;s<nScans;s++) {
+    if (nCoeff[s] != refImpl->nCoeff[s] ||
+        memcmp(coeffList[s], refImpl->coeffList[s], nCoeff[s]*sizeof(int16_t)) != 0 ||
+        memcmp(coeffPos[s],  refImpl->coeffPos[s],  nCoeff[s]*sizeof(int16_t)) != 0)
+      return false;
+  }
+
+  return true;
+}
+
+
+int DSPFunc_Residual_Generic::parse(CABAC_decoder* decoder, context_model* model, int scanIdx,
+                                    int lastSubBlock, int lastScanPos,
+                                    int16_t* coeffList, int16_t* coeffPos)
+{
+  return decode_residual_coefficients_generic(decoder, model, log2TrafoSize, chroma ? 1 : 0,
+                                              scanIdx, lastSubBlock, lastScanPos,
+                                              true, false, NULL,
+                                              coeffList, coeffPos);
+}
+
+
+class DSPFunc_Residual_Table : public DSPFunc_Residual_Base
+{
+public:
+  DSPFunc_Residual_Table(int log2TrafoSize, bool chroma)
+    : DSPFunc_Residual_Base("Table",log2TrafoSize,chroma) { }
+
+  virtual DSPFunc* referenceImplementation() const {
+    return residual_generic(log2TrafoSize, chroma);
+  }
+
+protected:
+  virtual int parse(CABAC_decoder* decoder, context_model* model, int scanIdx,
+                    int lastSubBlock, int lastScanPos,
+                    int16_t* coeffList, int16_t* coeffPos) {
+    return residual_coefficients_parser[log2TrafoSize-2][scanIdx][chroma](decoder, model,
+                                                                          lastSubBlock, lastScanPos,
+                                                                          true,
+                                                                          coeffList, coeffPos);
+  }
+};
+
+
+DSPFunc_Residual_Generic residual_generic_luma_4   (2, false);
+DSPFunc_Residual_Generic residual_generic_luma_8   (3, false);
+DSPFunc_Residual_Generic residual_generic_luma_16  (4, false);
+DSPFunc_Residual_Generic residual_generic_luma_32  (5, false);
+DSPFunc_Residual_Generic residual_generic_chroma_4 (2, true);
+DSPFunc_Residual_Generic residual_generic_chroma_8 (3, true);
+DSPFunc_Residual_Generic residual_generic_chroma_16(4, true);
+DSPFunc_Residual_Generic residual_generic_chroma_32(5, true);
+
+DSPFunc_Residual_Table residual_table_luma_4   (2, false);
+DSPFunc_Residual_Table residual_table_luma_8   (3, false);
+DSPFunc_Residual_Table residual_table_luma_16  (4, false);
+DSPFunc_Residual_Table residual_table_luma_32  (5, false);
+DSPFunc_Residual_Table residual_table_chroma_4 (2, true);
+DSPFunc_Residual_Table residual_table_chroma_8 (3, true);
+DSPFunc_Residual_Table residual_table_chroma_16(4, true);
+DSPFunc_Residual_Table residual_table_chroma_32(5, true);
+
+
+DSPFunc_Residual_Generic* residual_generic(int log2TrafoSize, bool chroma)
+{
+  DSPFunc_Residual_Generic* table[2][4] = {
+    { &residual_generic_luma_4,   &residual_generic_luma_8,
+      &residual_generic_luma_16,  &residual_generic_luma_32 },
+    { &residual_generic_chroma_4,  &residual_generic_chroma_8,
+      &residual_generic_chroma_16, &residual_generic_chroma_32 }
+  };
+
+  return table[chroma][log2TrafoSize-2];
+}
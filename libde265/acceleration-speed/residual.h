@@ -0,0 +1,87 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2015 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef ACCELERATION_SPEED_RESIDUAL_H
+#define ACCELERATION_SPEED_RESIDUAL_H
+
+#include "acceleration-speed.h"
+#include "libde265/cabac.h"
+#include "libde265/contextmodel.h"
+
+
+/* Parses the coefficients of one transform block (all allowed scan orders)
+   from pseudo-random CABAC data derived from the input image. This measures
+   the residual_coding() coefficient loop without the rest of the decoder.
+ */
+class DSPFunc_Residual_Base : public DSPFunc
+{
+public:
+  DSPFunc_Residual_Base(const char* impl, int log2TrafoSize, bool chroma);
+
+  virtual const char* name() const { return funcname.c_str(); }
+
+  virtual int getBlkWidth()  const { return 1<<log2TrafoSize; }
+  virtual int getBlkHeight() const { return 1<<log2TrafoSize; }
+
+  virtual void runOnBlock(int x,int y);
+
+  virtual bool compareToReferenceImplementation();
+  virtual bool prepareNextImage(std::shared_ptr<const de265_image> img);
+
+protected:
+  virtual int parse(CABAC_decoder* decoder, context_model* model, int scanIdx,
+                    int lastSubBlock, int lastScanPos,
+                    int16_t* coeffList, int16_t* coeffPos) = 0;
+
+  int  log2TrafoSize;
+  bool chroma;
+
+  std::string funcname;
+  std::shared_ptr<const de265_image> curr_image;
+
+  enum { bitstreamSize = 65536 };
+  uint8_t bitstream[bitstreamSize + CABAC_DECODER_PADDING];
+
+  context_model initialModels[CONTEXT_MODEL_TABLE_LENGTH];
+
+  int     nCoeff[3];
+  int16_t coeffList[3][32*32];
+  int16_t coeffPos [3][32*32];
+};
+
+
+class DSPFunc_Residual_Generic : public DSPFunc_Residual_Base
+{
+public:
+  DSPFunc_Residual_Generic(int log2TrafoSize, bool chroma)
+    : DSPFunc_Residual_Base("Generic",log2TrafoSize,chroma) { }
+
+protected:
+  virtual int parse(CABAC_decoder* decoder, context_model* model, int scanIdx,
+                    int lastSubBlock, int lastScanPos,
+                    int16_t* coeffList, int16_t* coeffPos);
+};
+
+
+DSPFunc_Residual_Generic* residual_generic(int log2TrafoSize, bool chroma);
+
+#endif
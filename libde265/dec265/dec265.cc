@@ -33,11 +33,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <limits>
+#include <algorithm>
 #include <getopt.h>
 #ifdef HAVE_MALLOC_H
 #include <malloc.h>
 #endif
 #include <signal.h>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #ifndef _MSC_VER
 #include <sys/time.h>
@@ -82,6 +88,14 @@ int highestTID = 100;
 int verbosity=0;
 int disable_deblocking=0;
 int disable_sao=0;
+int huge_pages=de265_huge_pages_none;
+int memory_limit_MB=0;
+int stage_timing=0;
+int pipeline_status=0;
+int picture_stats=0;
+const char* trace_filename=NULL;
+struct de265_memory_usage peak_memory;
+struct de265_pipeline_status max_pipeline_status;
 
 static struct option long_options[] = {
   {"quiet",      no_argument,       0, 'q' },
@@ -104,11 +118,77 @@ static struct option long_options[] = {
   {"verbose",    no_argument,       0, 'v' },
   {"disable-deblocking", no_argument, &disable_deblocking, 1 },
   {"disable-sao",        no_argument, &disable_sao, 1 },
+  {"huge-pages",  required_argument, 0, 'H' },
+  {"memory-limit", required_argument, 0, 'M' },
+  {"stage-timing",       no_argument, &stage_timing, 1 },
+  {"pipeline-status",    no_argument, &pipeline_status, 1 },
+  {"picture-stats",      no_argument, &picture_stats, 1 },
+  {"trace",        required_argument, 0, 'R' },
   {0,         0,                 0,  0 }
 };
 
 
 
+static void update_max_pipeline_status(de265_decoder_context* ctx)
+{
+  struct de265_pipeline_status status;
+  de265_get_pipeline_status(ctx, &status);
+
+  struct de265_pipeline_status& m = max_pipeline_status;
+  m.input_NAL_units = std::max(m.input_NAL_units, status.input_NAL_units);
+  m.input_bytes     = std::max(m.input_bytes,     status.input_bytes);
+  m.image_units     = std::max(m.image_units,     status.image_units);
+  m.reorder_buffer  = std::max(m.reorder_buffer,  status.reorder_buffer);
+  m.output_queue    = std::max(m.output_queue,    status.output_queue);
+  m.dpb_pictures    = std::max(m.dpb_pictures,    status.dpb_pictures);
+  m.threads_busy    = std::max(m.threads_busy,    status.threads_busy);
+  m.threads_blocked = std::max(m.threads_blocked, status.threads_blocked);
+  m.tasks_queued    = std::max(m.tasks_queued,    status.tasks_queued);
+}
+
+
+static void print_picture_stats(const de265_image* img)
+{
+  static int picture_nr=0;
+
+  struct de265_picture_stats stats;
+  de265_get_image_stats(img, &stats);
+
+  int nPUs = (stats.num_skip_PUs + stats.num_merge_PUs +
+              stats.num_AMVP_PUs + stats.num_intra_PUs);
+  if (nPUs==0) nPUs=1;
+
+  fprintf(stderr,"picture %4d  slices I/P/B: %d/%d/%d  bytes: %7lld  "
+          "CUs 8/16/32/64: %d/%d/%d/%d  "
+          "PUs skip/merge/AMVP/intra: %.1f%%/%.1f%%/%.1f%%/%.1f%%  QP: %.2f  time: %.3f ms\n",
+          picture_nr++,
+          stats.num_I_slices, stats.num_P_slices, stats.num_B_slices,
+          (long long)stats.slice_data_bytes,
+          stats.num_CUs[0], stats.num_CUs[1], stats.num_CUs[2], stats.num_CUs[3],
+          stats.num_skip_PUs  * 100.0 / nPUs,
+          stats.num_merge_PUs * 100.0 / nPUs,
+          stats.num_AMVP_PUs  * 100.0 / nPUs,
+          stats.num_intra_PUs * 100.0 / nPUs,
+          stats.average_QP,
+          stats.decode_time_ns / 1000000.0);
+
+  // only with bit accounting
+
+  double bits[de265_num_bit_categories];
+  if (de265_get_image_bits(img, bits) == 0) {
+    static const char* names[de265_num_bit_categories] = {
+      "SAO", "split", "CU", "intra", "merge", "motion", "MVD", "TT", "dQP", "residual", "PCM", "other"
+    };
+
+    fprintf(stderr,"     bits:");
+    for (int i=0;i<de265_num_bit_categories;i++) {
+      fprintf(stderr," %s:%.0f", names[i], bits[i]);
+    }
+    fprintf(stderr,"\n");
+  }
+}
+
+
 static void write_picture(const de265_image* img)
 {
   static FILE* fh = NULL;
@@ -366,131 +446,306 @@ bool output_image(const de265_image* img)
 }
 
 
+/* Quality measurement (-m) runs on a separate thread, such that decoding continues
+   while the metrics are computed. The decoded planes are copied into a job, which is
+   queued for the measurement thread. After each picture, that thread already reads
+   the next reference frame. When MAX_MEASURE_QUEUE pictures are waiting, the decoder
+   waits for the measurement. The results are printed by the main thread, such that
+   they do not interleave with its other output.
+ */
+
+#define MAX_MEASURE_QUEUE 4
+
+struct measure_job
+{
+  int framenr;
+  int width[3], height[3];
+  std::vector<uint8_t> planes[3];  // decoded picture without stride padding
+};
+
+struct measure_result
+{
+  int framenr;
+  double psnr[3];
+  double ssim;
+};
+
+static std::thread              measure_thread;
+static std::mutex               measure_mutex;
+static std::condition_variable  measure_cond;
+static std::deque<measure_job*> measure_queue;
+static std::vector<measure_job*> measure_free_jobs;
+static std::deque<measure_result> measure_results;
+static bool                     measure_eof=false;
+
 static double mse_y=0.0, mse_cb=0.0, mse_cr=0.0;
 static int    mse_frames=0;
 
 static double ssim_y=0.0;
 static int    ssim_frames=0;
 
-void measure(const de265_image* img)
+
+static void measure(const measure_job* job, const uint8_t* ref)
 {
+  const int width  = job->width[0];
+  const int height = job->height[0];
+
   // --- compute PSNR ---
 
-  int width  = de265_get_image_width(img,0);
-  int height = de265_get_image_height(img,0);
+  double img_mse[3];
+  size_t refOffset=0;
 
-  uint8_t* p = (uint8_t*)malloc(width*height*3/2);
-  if (p == NULL) {
-    return;
+  for (int c=0;c<3;c++) {
+    img_mse[c] = MSE(&job->planes[c][0], job->width[c], ref+refOffset, job->width[c],
+                     job->width[c], job->height[c]);
+    refOffset += job->width[c]*job->height[c];
   }
 
-  size_t toread = width*height*3/2;
-  if (fread(p,1,toread,reference_file) != toread) {
-    free(p);
-    return;
-  }
+  mse_frames++;
 
-  int stride, cstride;
-  const uint8_t* yptr  = de265_get_image_plane(img,0, &stride);
-  const uint8_t* cbptr = de265_get_image_plane(img,1, &cstride);
-  const uint8_t* crptr = de265_get_image_plane(img,2, &cstride);
+  mse_y  += img_mse[0];
+  mse_cb += img_mse[1];
+  mse_cr += img_mse[2];
 
-  double img_mse_y  = MSE( yptr,  stride, p, width,   width, height);
-  double img_mse_cb = MSE(cbptr, cstride, p+width*height,      width/2, width/2,height/2);
-  double img_mse_cr = MSE(crptr, cstride, p+width*height*5/4,  width/2, width/2,height/2);
 
-  mse_frames++;
+  // --- compute SSIM ---
+
+  double ssimSum = ::SSIM(&job->planes[0][0], width, ref, width, width, height);
 
-  mse_y  += img_mse_y;
-  mse_cb += img_mse_cb;
-  mse_cr += img_mse_cr;
+#if HAVE_VIDEOGFX
+  if (show_psnr_map || show_ssim_map) {
+    Bitmap<Pixel> ref_bm, coded;
+    ref_bm.Create(width, height); // reference image
+    coded .Create(width, height); // coded image
+
+    for (int y=0;y<height;y++) {
+      memcpy(coded[y],  &job->planes[0][y*width], width);
+      memcpy(ref_bm[y], ref + y*width, width);
+    }
 
+    // display PSNR error map
 
+    if (show_psnr_map) {
+      static X11Win win;
+      static bool first=true;
 
-  // --- compute SSIM ---
+      if (first) {
+        first=false;
+        win.Create(width, height, "psnr output");
+      }
+
+      Bitmap<Pixel> error_map = CalcErrorMap(ref_bm, coded, TransferCurve_Sqrt);
+      win.Display(MakeImage(error_map));
+    }
 
-  double ssimSum = 0.0;
 
-#if HAVE_VIDEOGFX
-  Bitmap<Pixel> ref, coded;
-  ref  .Create(width, height); // reference image
-  coded.Create(width, height); // coded image
+    // display SSIM error map
 
-  const uint8_t* data;
-  data = de265_get_image_plane(img,0,&stride);
+    if (show_ssim_map) {
+      videogfx::SSIM ssimAlgo;
+      Bitmap<float> ssim = ssimAlgo.calcSSIM(ref_bm,coded);
 
-  for (int y=0;y<height;y++) {
-    memcpy(coded[y], data + y*stride, width);
-    memcpy(ref[y],   p    + y*stride, width);
+      Bitmap<Pixel> ssimMap;
+      ssimMap.Create(width,height);
+
+      for (int y=0;y<height;y++)
+        for (int x=0;x<width;x++)
+          {
+            float v = ssim[y][x];
+            v = v*v;
+            v = 255*v; //pow(v, 20);
+
+            //assert(v<=255.0);
+            ssimMap[y][x] = v;
+          }
+
+      static X11Win win;
+      static bool first=true;
+
+      if (first) {
+        first=false;
+        win.Create(width, height, "ssim output");
+      }
+
+      win.Display(MakeImage(ssimMap));
+    }
+  }
+#endif
+
+  ssim_frames++;
+  ssim_y += ssimSum;
+
+  measure_result result;
+  result.framenr = job->framenr;
+  result.ssim    = ssimSum;
+  for (int c=0;c<3;c++) {
+    result.psnr[c] = PSNR(img_mse[c]);
   }
 
-  SSIM ssimAlgo;
-  Bitmap<float> ssim = ssimAlgo.calcSSIM(ref,coded);
+  std::unique_lock<std::mutex> lock(measure_mutex);
+  measure_results.push_back(result);
+}
+
 
-  Bitmap<Pixel> ssimMap;
-  ssimMap.Create(width,height);
+static void measure_main()
+{
+  std::vector<uint8_t> ref;
+  bool refValid=false;
+  bool refEOF=false;
 
-  for (int y=0;y<height;y++)
-    for (int x=0;x<width;x++)
-      {
-        float v = ssim[y][x];
-        ssimSum += v;
-        v = v*v;
-        v = 255*v; //pow(v, 20);
+  for (;;) {
+    measure_job* job;
 
-        //assert(v<=255.0);
-        ssimMap[y][x] = v;
+    {
+      std::unique_lock<std::mutex> lock(measure_mutex);
+      while (measure_queue.empty() && !measure_eof) {
+        measure_cond.wait(lock);
       }
 
-  ssimSum /= width*height;
+      if (measure_queue.empty()) {
+        break;
+      }
+
+      job = measure_queue.front();
+    }
+
+    size_t size=0;
+    for (int c=0;c<3;c++) {
+      size += job->width[c]*job->height[c];
+    }
 
+    // the picture size changed, read the frame again with the new size
 
-  Bitmap<Pixel> error_map = CalcErrorMap(ref, coded, TransferCurve_Sqrt);
+    if (refValid && ref.size() != size) {
+      fseek(reference_file, -(long)ref.size(), SEEK_CUR);
+      refValid = false;
+    }
+
+    if (!refValid && !refEOF) {
+      ref.resize(size);
+      refValid = (fread(&ref[0],1,size,reference_file) == size);
+      refEOF = !refValid;
+    }
 
+    if (refValid) {
+      measure(job, &ref[0]);
+      refValid = false;
+    }
 
-  // display PSNR error map
+    {
+      std::unique_lock<std::mutex> lock(measure_mutex);
+      measure_queue.pop_front();
+      measure_free_jobs.push_back(job);
+    }
+    measure_cond.notify_all();
 
-  if (show_psnr_map) {
-    static X11Win win;
-    static bool first=true;
+    // read ahead while the next picture is decoded
 
-    if (first) {
-      first=false;
-      win.Create(de265_get_image_width(img,0),
-                 de265_get_image_height(img,0),
-                 "psnr output");
+    if (!refEOF) {
+      refValid = (fread(&ref[0],1,size,reference_file) == size);
+      refEOF = !refValid;
     }
+  }
+}
 
-    win.Display(MakeImage(error_map));
+
+static bool start_measurement()
+{
+  reference_file = fopen(reference_filename, "rb");
+  if (reference_file==NULL) {
+    fprintf(stderr,"cannot open reference file %s!\n", reference_filename);
+    return false;
   }
 
+  measure_thread = std::thread(measure_main);
+  return true;
+}
+
+
+// Prints the results that are available so far.
 
-  // display SSIM error map
+static void print_measurements()
+{
+  std::deque<measure_result> results;
+
+  {
+    std::unique_lock<std::mutex> lock(measure_mutex);
+    results.swap(measure_results);
+  }
 
-  if (show_ssim_map) {
-    static X11Win win;
-    static bool first=true;
+  for (size_t i=0;i<results.size();i++) {
+    const measure_result& r = results[i];
+    printf("%5d   %6f %6f %6f %6f\n",
+           r.framenr, r.psnr[0], r.psnr[1], r.psnr[2], r.ssim);
+  }
+}
 
-    if (first) {
-      first=false;
-      win.Create(de265_get_image_width(img,0),
-                 de265_get_image_height(img,0),
-                 "ssim output");
+
+static void queue_measurement(const de265_image* img)
+{
+  measure_job* job;
+
+  {
+    std::unique_lock<std::mutex> lock(measure_mutex);
+    while (measure_queue.size() >= MAX_MEASURE_QUEUE) {
+      measure_cond.wait(lock);
     }
 
-    win.Display(MakeImage(ssimMap));
+    if (measure_free_jobs.empty()) {
+      job = new measure_job;
+    }
+    else {
+      job = measure_free_jobs.back();
+      measure_free_jobs.pop_back();
+    }
   }
-#endif
 
-  ssim_frames++;
-  ssim_y += ssimSum;
+  job->framenr = framecnt;
+
+  for (int c=0;c<3;c++) {
+    int stride;
+    const uint8_t* p = de265_get_image_plane(img,c, &stride);
+
+    int w = de265_get_image_width(img,c);
+    int h = de265_get_image_height(img,c);
+
+    job->width[c]  = w;
+    job->height[c] = h;
+    job->planes[c].resize(w*h);
+
+    for (int y=0;y<h;y++) {
+      memcpy(&job->planes[c][y*w], p + y*stride, w);
+    }
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(measure_mutex);
+    measure_queue.push_back(job);
+  }
+  measure_cond.notify_all();
+}
 
-  printf("%5d   %6f %6f %6f %6f\n",
-         framecnt,
-         PSNR(img_mse_y), PSNR(img_mse_cb), PSNR(img_mse_cr),
-         ssimSum);
 
-  free(p);
+// Waits until all queued pictures are measured.
+
+static void finish_measurement()
+{
+  {
+    std::unique_lock<std::mutex> lock(measure_mutex);
+    measure_eof = true;
+  }
+  measure_cond.notify_all();
+
+  measure_thread.join();
+
+  print_measurements();
+
+  for (size_t i=0;i<measure_free_jobs.size();i++) {
+    delete measure_free_jobs[i];
+  }
+  measure_free_jobs.clear();
+
+  fclose(reference_file);
 }
 
 
@@ -589,6 +844,9 @@ int main(int argc, char** argv)
     case 'e': show_psnr_map=true; break;
     case 'T': highestTID=atoi(optarg); break;
     case 'v': verbosity++; break;
+    case 'H': huge_pages=atoi(optarg); break;
+    case 'M': memory_limit_MB=atoi(optarg); break;
+    case 'R': trace_filename=optarg; break;
     }
   }
 
@@ -621,6 +879,13 @@ int main(int argc, char** argv)
     fprintf(stderr,"  -T, --highest-TID select highest temporal sublayer to decode\n");
     fprintf(stderr,"      --disable-deblocking   disable deblocking filter\n");
     fprintf(stderr,"      --disable-sao          disable sample-adaptive offset filter\n");
+    fprintf(stderr,"      --huge-pages N         picture memory: 0 - normal, 1 - transparent huge pages,\n"
+                   "                             2 - explicit huge pages\n");
+    fprintf(stderr,"      --memory-limit MB      limit the decoder memory\n");
+    fprintf(stderr,"      --stage-timing         show the decoding time of each decoder stage\n");
+    fprintf(stderr,"      --pipeline-status      show queue depths and stall counters of the decoder\n");
+    fprintf(stderr,"      --picture-stats        show decoding statistics of each output picture\n");
+    fprintf(stderr,"      --trace FILE           write a timeline of the worker threads (Chrome trace JSON)\n");
     fprintf(stderr,"  -h, --help        show help\n");
 
     exit(show_help ? 0 : 5);
@@ -637,6 +902,14 @@ int main(int argc, char** argv)
   de265_set_parameter_bool(ctx, DE265_DECODER_PARAM_DISABLE_DEBLOCKING, disable_deblocking);
   de265_set_parameter_bool(ctx, DE265_DECODER_PARAM_DISABLE_SAO, disable_sao);
 
+  de265_set_parameter_int(ctx, DE265_DECODER_PARAM_PLANE_POOL_HUGE_PAGES, huge_pages);
+  de265_set_parameter_bool(ctx, DE265_DECODER_PARAM_STAGE_TIMING, stage_timing);
+  de265_set_parameter_bool(ctx, DE265_DECODER_PARAM_TASK_TRACE, trace_filename != NULL);
+
+  if (memory_limit_MB > 0) {
+    de265_set_memory_limit(ctx, memory_limit_MB * (int64_t)1024*1024);
+  }
+
   if (dump_headers) {
     de265_set_parameter_int(ctx, DE265_DECODER_PARAM_DUMP_SPS_HEADERS, 1);
     de265_set_parameter_int(ctx, DE265_DECODER_PARAM_DUMP_VPS_HEADERS, 1);
@@ -664,11 +937,6 @@ int main(int argc, char** argv)
   de265_set_limit_TID(ctx, highestTID);
 
 
-  if (measure_quality) {
-    reference_file = fopen(reference_filename, "rb");
-  }
-
-
   FILE* fh;
   if (strcmp(argv[optind],"-")==0) {
     fh = stdin;
@@ -682,6 +950,12 @@ int main(int argc, char** argv)
     exit(10);
   }
 
+  if (measure_quality) {
+    if (!start_measurement()) {
+      exit(10);
+    }
+  }
+
   FILE* bytestream_fh = NULL;
 
   if (write_bytestream) {
@@ -695,39 +969,79 @@ int main(int argc, char** argv)
 
   int pos=0;
 
+  // Input that was rejected with DE265_ERROR_INPUT_QUEUE_FULL is kept and pushed
+  // again after decoding. (Re-reading it with fseek() would not work for stdin.)
+
+  uint8_t* pendingNAL = NULL;
+  int      pendingNALSize = 0;
+  uint8_t  chunk[BUFFER_SIZE];
+  int      pendingChunkSize = 0;
+
   while (!stop)
     {
       //tid = (framecnt/1000) & 1;
       //de265_set_limit_TID(ctx, tid);
 
       if (nal_input) {
-        uint8_t len[4];
-        int n = fread(len,1,4,fh);
-        int length = (len[0]<<24) + (len[1]<<16) + (len[2]<<8) + len[3];
+        uint8_t* buf;
+        int n;
+
+        if (pendingNAL) {
+          buf = pendingNAL;
+          n   = pendingNALSize;
+        }
+        else {
+          uint8_t len[4];
+          n = fread(len,1,4,fh);
+          int length = (len[0]<<24) + (len[1]<<16) + (len[2]<<8) + len[3];
+
+          buf = (uint8_t*)malloc(length);
+          n = fread(buf,1,length,fh);
+
+          if (write_bytestream) {
+            uint8_t sc[3] = { 0,0,1 };
+            fwrite(sc ,1,3,bytestream_fh);
+            fwrite(buf,1,n,bytestream_fh);
+          }
+        }
 
-        uint8_t* buf = (uint8_t*)malloc(length);
-        n = fread(buf,1,length,fh);
         err = de265_push_NAL(ctx, buf,n,  pos, (void*)1);
 
-        if (write_bytestream) {
-          uint8_t sc[3] = { 0,0,1 };
-          fwrite(sc ,1,3,bytestream_fh);
-          fwrite(buf,1,n,bytestream_fh);
+        if (err == DE265_ERROR_INPUT_QUEUE_FULL) {
+          // decode the queued data first and push this NAL again
+          pendingNAL = buf;
+          pendingNALSize = n;
+        }
+        else {
+          free(buf);
+          pendingNAL = NULL;
+          pos+=n;
         }
-
-        free(buf);
-        pos+=n;
       }
       else {
         // read a chunk of input data
-        uint8_t buf[BUFFER_SIZE];
-        int n = fread(buf,1,BUFFER_SIZE,fh);
+        int n;
+        if (pendingChunkSize) {
+          n = pendingChunkSize;
+        }
+        else {
+          n = fread(chunk,1,BUFFER_SIZE,fh);
+        }
 
         // decode input data
         if (n) {
-          err = de265_push_data(ctx, buf, n, pos, (void*)2);
-          if (err != DE265_OK) {
-            break;
+          err = de265_push_data(ctx, chunk, n, pos, (void*)2);
+          if (err == DE265_ERROR_INPUT_QUEUE_FULL) {
+            // decode the queued data first and push this chunk again
+            pendingChunkSize = n;
+            n = 0;
+          }
+          else {
+            pendingChunkSize = 0;
+
+            if (err != DE265_OK) {
+              break;
+            }
           }
         }
 
@@ -746,7 +1060,7 @@ int main(int argc, char** argv)
 
       // printf("pending data: %d\n", de265_get_number_of_input_bytes_pending(ctx));
 
-      if (feof(fh)) {
+      if (feof(fh) && pendingNAL==NULL && pendingChunkSize==0) {
         err = de265_flush_data(ctx); // indicate end of stream
         stop = true;
       }
@@ -762,11 +1076,19 @@ int main(int argc, char** argv)
           // decode some more
 
           err = de265_decode(ctx, &more);
+
+          if (pipeline_status) {
+            update_max_pipeline_status(ctx);
+          }
+
           if (err != DE265_OK) {
             // if (quiet<=1) fprintf(stderr,"ERROR: %s\n", de265_get_error_text(err));
 
-            if (check_hash && err == DE265_ERROR_CHECKSUM_MISMATCH)
+            if (check_hash && err == DE265_ERROR_CHECKSUM_MISMATCH) {
+              if (quiet<=1) fprintf(stderr,"checksum mismatch in picture POC=%d\n",
+                                    de265_get_checksum_mismatch_POC(ctx));
               stop = 1;
+            }
             more = 0;
             break;
           }
@@ -776,7 +1098,20 @@ int main(int argc, char** argv)
           const de265_image* img = de265_get_next_picture(ctx);
           if (img) {
             if (measure_quality) {
-              measure(img);
+              queue_measurement(img);
+              print_measurements();
+            }
+
+            if (picture_stats) {
+              print_picture_stats(img);
+            }
+
+            if (verbosity>0) {
+              struct de265_memory_usage usage;
+              de265_get_memory_usage(ctx, &usage);
+              if (usage.total > peak_memory.total) {
+                peak_memory = usage;
+              }
             }
 
             stop = output_image(img);
@@ -797,6 +1132,8 @@ int main(int argc, char** argv)
         }
     }
 
+  free(pendingNAL);  // if decoding was stopped early
+
   fclose(fh);
 
   if (write_bytestream) {
@@ -804,13 +1141,92 @@ int main(int argc, char** argv)
   }
 
   if (measure_quality) {
+    finish_measurement();
+
     printf("#total  %6f %6f %6f %6f\n",
            PSNR(mse_y /mse_frames),
            PSNR(mse_cb/mse_frames),
            PSNR(mse_cr/mse_frames),
            ssim_y/ssim_frames);
+  }
+
+  if (verbosity>0) {
+    struct de265_plane_pool_statistics pool;
+    de265_get_plane_pool_statistics(ctx, &pool);
+
+    fprintf(stderr,"plane pool: %d buffers (%.1f MB), %llu hits, %llu misses\n",
+            pool.buffers, pool.bytes/(1024.0*1024.0),
+            (unsigned long long)pool.hits, (unsigned long long)pool.misses);
+
+    struct de265_object_pool_statistics objects;
+    de265_get_object_pool_statistics(ctx, &objects);
 
-    fclose(reference_file);
+    fprintf(stderr,"object pool: %llu allocations, %llu reuses\n",
+            (unsigned long long)objects.allocations, (unsigned long long)objects.reuses);
+
+    const double MB = 1024.0*1024.0;
+    fprintf(stderr,"peak memory: %.1f MB (pictures %.1f, plane pool %.1f, metadata %.1f, "
+            "input %.1f, objects %.1f)\n",
+            peak_memory.total/MB, peak_memory.picture_planes/MB, peak_memory.plane_pool/MB,
+            peak_memory.metadata/MB, peak_memory.input_queue/MB, peak_memory.decoder_objects/MB);
+  }
+
+  if (stage_timing) {
+    struct de265_decoder_stats stats;
+    de265_get_stats(ctx, &stats);
+
+    const struct { const char* name; int64_t ns; } stages[] = {
+      { "NAL parsing",      stats.nal_parsing },
+      { "slice headers",    stats.slice_header },
+      { "CTU parsing",      stats.ctu_parsing },
+      { "inter prediction", stats.inter_prediction },
+      { "residual",         stats.residual },
+      { "intra prediction", stats.intra_prediction },
+      { "deblocking",       stats.deblocking },
+      { "SAO",              stats.sao },
+      { "hash check",       stats.hash_check },
+      { "total",            stats.total }
+    };
+
+    fprintf(stderr,"decoding time per stage (all threads):\n");
+    for (size_t i=0;i<sizeof(stages)/sizeof(stages[0]);i++) {
+      fprintf(stderr,"  %-16s %10.2f ms  %5.1f%%\n", stages[i].name, stages[i].ns*1e-6,
+              stats.total ? stages[i].ns*100.0/stats.total : 0.0);
+    }
+  }
+
+  if (pipeline_status) {
+    struct de265_pipeline_status status;
+    de265_get_pipeline_status(ctx, &status);
+
+    const struct de265_pipeline_status& m = max_pipeline_status;
+    fprintf(stderr,"pipeline status (maximum while decoding):\n"
+            "  input queue      %d NALs, %d bytes\n"
+            "  image units      %d\n"
+            "  reorder buffer   %d\n"
+            "  output queue     %d\n"
+            "  DPB pictures     %d\n"
+            "  threads          %d busy, %d blocked of %d, %d tasks queued\n",
+            m.input_NAL_units, m.input_bytes, m.image_units, m.reorder_buffer,
+            m.output_queue, m.dpb_pictures,
+            m.threads_busy, m.threads_blocked, status.worker_threads, m.tasks_queued);
+
+    fprintf(stderr,"stalls:\n"
+            "  waiting for input        %lld times\n"
+            "  image buffer full        %lld times\n"
+            "  no output picture        %lld times\n"
+            "  blocked tasks            %lld times, %.2f ms\n"
+            "  main thread waiting      %.2f ms\n",
+            (long long)status.waiting_for_input, (long long)status.image_buffer_full,
+            (long long)status.output_empty, (long long)status.blocked_waits,
+            status.blocked_time_ns*1e-6, status.main_wait_time_ns*1e-6);
+  }
+
+  if (trace_filename) {
+    de265_error traceErr = de265_write_task_trace(ctx, trace_filename);
+    if (traceErr != DE265_OK) {
+      fprintf(stderr,"cannot write trace: %s\n", de265_get_error_text(traceErr));
+    }
   }
 
   de265_free_decoder(ctx);
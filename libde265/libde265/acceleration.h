@@ -185,6 +185,69 @@ struct acceleration_functions
   template <class pixel_t> void transform_4x4_dst_add(pixel_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth) const;
   template <class pixel_t> void transform_add(int sizeIdx, pixel_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth) const;
 
+  // Sparse coefficient blocks: 'dc' requires all coefficients except coeffs[0] to be zero,
+  // 'topleft4x4' (index 1-3 for 8x8 to 32x32) requires all coefficients outside of the
+  // top-left 4x4 to be zero. 'coeffs' is the full nT x nT block in both cases.
+
+  void (*transform_dc_add_8[4])(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
+  void (*transform_topleft4x4_add_8[4])(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
+
+  void (*transform_dc_add_16[4])(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+  void (*transform_topleft4x4_add_16[4])(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+
+  template <class pixel_t> void transform_dc_add(int sizeIdx, pixel_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth) const;
+  template <class pixel_t> void transform_topleft4x4_add(int sizeIdx, pixel_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth) const;
+
+  // Fused dequantization (flat scaling list) + iDST/iDCT + add. 'levels' are the parsed
+  // coefficient levels, dequantized as Clip3(-32768,32767, (level*fact + (1<<(shift-1))) >> shift).
+  // These are optional (NULL when not available), callers dequantize and use transform_add() then.
+
+  void (*transform_4x4_dst_dequant_add_8)(uint8_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                          int fact, int shift);
+  void (*transform_dequant_add_8[4])(uint8_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                     int fact, int shift);
+
+  void (*transform_4x4_dst_dequant_add_16)(uint16_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                           int fact, int shift, int bit_depth);
+  void (*transform_dequant_add_16[4])(uint16_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                      int fact, int shift, int bit_depth);
+
+  template <class pixel_t> bool has_transform_dequant_add() const;
+  template <class pixel_t> void transform_4x4_dst_dequant_add(pixel_t *dst, const int16_t *levels, ptrdiff_t stride, int fact, int shift, int bit_depth) const;
+  template <class pixel_t> void transform_dequant_add(int sizeIdx, pixel_t *dst, const int16_t *levels, ptrdiff_t stride, int fact, int shift, int bit_depth) const;
+
+
+
+  // --- intra prediction ---
+
+  // 'border' points to the top-left corner sample of the 4*nT+1 reference samples
+  // (top row at border[1..2nT], left column at border[-1..-2nT]), see intra_border_computer.
+
+  void (*intra_prediction_sample_filtering_8)(uint8_t* pF, const uint8_t* p, int nT); // [1 2 1]
+  void (*intra_prediction_planar_8)(uint8_t* dst, ptrdiff_t dstStride, int nT, int cIdx,
+                                    const uint8_t* border);
+  void (*intra_prediction_DC_8)(uint8_t* dst, ptrdiff_t dstStride, int nT, int cIdx,
+                                const uint8_t* border);
+  void (*intra_prediction_angular_8)(uint8_t* dst, ptrdiff_t dstStride,
+                                     bool disableIntraBoundaryFilter, int intraPredMode,
+                                     int nT, int cIdx, const uint8_t* border);
+
+  void (*intra_prediction_sample_filtering_16)(uint16_t* pF, const uint16_t* p, int nT);
+  void (*intra_prediction_planar_16)(uint16_t* dst, ptrdiff_t dstStride, int nT, int cIdx,
+                                     const uint16_t* border);
+  void (*intra_prediction_DC_16)(uint16_t* dst, ptrdiff_t dstStride, int nT, int cIdx,
+                                 const uint16_t* border);
+  void (*intra_prediction_angular_16)(uint16_t* dst, ptrdiff_t dstStride, int bit_depth,
+                                      bool disableIntraBoundaryFilter, int intraPredMode,
+                                      int nT, int cIdx, const uint16_t* border);
+
+  template <class pixel_t> void intra_prediction_sample_filtering(pixel_t* pF, const pixel_t* p, int nT) const;
+  template <class pixel_t> void intra_prediction_planar(pixel_t* dst, ptrdiff_t dstStride, int nT, int cIdx, const pixel_t* border) const;
+  template <class pixel_t> void intra_prediction_DC(pixel_t* dst, ptrdiff_t dstStride, int nT, int cIdx, const pixel_t* border) const;
+  template <class pixel_t> void intra_prediction_angular(pixel_t* dst, ptrdiff_t dstStride, int bit_depth,
+                                                         bool disableIntraBoundaryFilter, int intraPredMode,
+                                                         int nT, int cIdx, const pixel_t* border) const;
+
 
 
   // --- forward transforms ---
@@ -353,7 +416,34 @@ template <> inline void acceleration_functions::transform_4x4_dst_add<uint16_t>(
 template <> inline void acceleration_functions::transform_add<uint8_t>(int sizeIdx, uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth) const { transform_add_8[sizeIdx](dst,coeffs,stride); }
 template <> inline void acceleration_functions::transform_add<uint16_t>(int sizeIdx, uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth) const { transform_add_16[sizeIdx](dst,coeffs,stride,bit_depth); }
 
+template <> inline void acceleration_functions::transform_dc_add<uint8_t>(int sizeIdx, uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth) const { transform_dc_add_8[sizeIdx](dst,coeffs,stride); }
+template <> inline void acceleration_functions::transform_dc_add<uint16_t>(int sizeIdx, uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth) const { transform_dc_add_16[sizeIdx](dst,coeffs,stride,bit_depth); }
+
+template <> inline void acceleration_functions::transform_topleft4x4_add<uint8_t>(int sizeIdx, uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth) const { transform_topleft4x4_add_8[sizeIdx](dst,coeffs,stride); }
+template <> inline void acceleration_functions::transform_topleft4x4_add<uint16_t>(int sizeIdx, uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth) const { transform_topleft4x4_add_16[sizeIdx](dst,coeffs,stride,bit_depth); }
+
+template <> inline bool acceleration_functions::has_transform_dequant_add<uint8_t>() const { return transform_dequant_add_8[0] != NULL; }
+template <> inline bool acceleration_functions::has_transform_dequant_add<uint16_t>() const { return transform_dequant_add_16[0] != NULL; }
+
+template <> inline void acceleration_functions::transform_4x4_dst_dequant_add<uint8_t>(uint8_t *dst, const int16_t *levels, ptrdiff_t stride, int fact, int shift, int bit_depth) const { transform_4x4_dst_dequant_add_8(dst,levels,stride,fact,shift); }
+template <> inline void acceleration_functions::transform_4x4_dst_dequant_add<uint16_t>(uint16_t *dst, const int16_t *levels, ptrdiff_t stride, int fact, int shift, int bit_depth) const { transform_4x4_dst_dequant_add_16(dst,levels,stride,fact,shift,bit_depth); }
+
+template <> inline void acceleration_functions::transform_dequant_add<uint8_t>(int sizeIdx, uint8_t *dst, const int16_t *levels, ptrdiff_t stride, int fact, int shift, int bit_depth) const { transform_dequant_add_8[sizeIdx](dst,levels,stride,fact,shift); }
+template <> inline void acceleration_functions::transform_dequant_add<uint16_t>(int sizeIdx, uint16_t *dst, const int16_t *levels, ptrdiff_t stride, int fact, int shift, int bit_depth) const { transform_dequant_add_16[sizeIdx](dst,levels,stride,fact,shift,bit_depth); }
+
 template <> inline void acceleration_functions::add_residual(uint8_t *dst,  ptrdiff_t stride, const int32_t* r, int nT, int bit_depth) const { add_residual_8(dst,stride,r,nT,bit_depth); }
 template <> inline void acceleration_functions::add_residual(uint16_t *dst, ptrdiff_t stride, const int32_t* r, int nT, int bit_depth) const { add_residual_16(dst,stride,r,nT,bit_depth); }
 
+template <> inline void acceleration_functions::intra_prediction_sample_filtering<uint8_t>(uint8_t* pF, const uint8_t* p, int nT) const { intra_prediction_sample_filtering_8(pF,p,nT); }
+template <> inline void acceleration_functions::intra_prediction_sample_filtering<uint16_t>(uint16_t* pF, const uint16_t* p, int nT) const { intra_prediction_sample_filtering_16(pF,p,nT); }
+
+template <> inline void acceleration_functions::intra_prediction_planar<uint8_t>(uint8_t* dst, ptrdiff_t dstStride, int nT, int cIdx, const uint8_t* border) const { intra_prediction_planar_8(dst,dstStride,nT,cIdx,border); }
+template <> inline void acceleration_functions::intra_prediction_planar<uint16_t>(uint16_t* dst, ptrdiff_t dstStride, int nT, int cIdx, const uint16_t* border) const { intra_prediction_planar_16(dst,dstStride,nT,cIdx,border); }
+
+template <> inline void acceleration_functions::intra_prediction_DC<uint8_t>(uint8_t* dst, ptrdiff_t dstStride, int nT, int cIdx, const uint8_t* border) const { intra_prediction_DC_8(dst,dstStride,nT,cIdx,border); }
+template <> inline void acceleration_functions::intra_prediction_DC<uint16_t>(uint16_t* dst, ptrdiff_t dstStride, int nT, int cIdx, const uint16_t* border) const { intra_prediction_DC_16(dst,dstStride,nT,cIdx,border); }
+
+template <> inline void acceleration_functions::intra_prediction_angular<uint8_t>(uint8_t* dst, ptrdiff_t dstStride, int bit_depth, bool disableIntraBoundaryFilter, int intraPredMode, int nT, int cIdx, const uint8_t* border) const { assert(bit_depth==8); intra_prediction_angular_8(dst,dstStride,disableIntraBoundaryFilter,intraPredMode,nT,cIdx,border); }
+template <> inline void acceleration_functions::intra_prediction_angular<uint16_t>(uint16_t* dst, ptrdiff_t dstStride, int bit_depth, bool disableIntraBoundaryFilter, int intraPredMode, int nT, int cIdx, const uint16_t* border) const { intra_prediction_angular_16(dst,dstStride,bit_depth,disableIntraBoundaryFilter,intraPredMode,nT,cIdx,border); }
+
 #endif
@@ -58,4 +58,46 @@ class alloc_pool
   void add_memory_block();
 };
 
+
+/* Keeps objects that are no longer used for later reuse, such that the per-picture
+   objects of the decoder do not have to be allocated again for each picture.
+   get() returns NULL when the list is empty, the caller then creates a new object.
+   The objects in the list are deleted with the list. Not thread-safe.
+ */
+template <class T> class free_list
+{
+ public:
+  ~free_list() {
+    for (size_t i=0;i<mFree.size();i++) {
+      delete mFree[i];
+    }
+  }
+
+  T* get() {
+    if (mFree.empty()) {
+      return NULL;
+    }
+
+    T* obj = mFree.back();
+    mFree.pop_back();
+    return obj;
+  }
+
+  void put(T* obj) { mFree.push_back(obj); }
+
+  size_t size() const { return mFree.size(); }
+  const T* at(size_t i) const { return mFree[i]; }
+
+  // delete all objects in the list
+  void clear() {
+    for (size_t i=0;i<mFree.size();i++) {
+      delete mFree[i];
+    }
+    mFree.clear();
+  }
+
+ private:
+  std::vector<T*> mFree;
+};
+
 #endif
@@ -25,11 +25,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <string.h>
 
 #define INITIAL_CABAC_BUFFER_CAPACITY 4096
 
 
-static const uint8_t LPS_table[64][4] =
+const uint8_t LPS_table[64][4] =
   {
     { 128, 176, 208, 240},
     { 128, 167, 197, 227},
@@ -97,7 +98,8 @@ static const uint8_t LPS_table[64][4] =
     {   2,   2,   2,   2}
   };
 
-static const uint8_t renorm_table[32] =
+// indexed with range>>3, no renormalization is needed for range >= 256
+const uint8_t renorm_table[64] =
   {
     6,  5,  4,  4,
     3,  3,  3,  3,
@@ -106,10 +108,18 @@ static const uint8_t renorm_table[32] =
     1,  1,  1,  1,
     1,  1,  1,  1,
     1,  1,  1,  1,
-    1,  1,  1,  1
+    1,  1,  1,  1,
+    0,  0,  0,  0,
+    0,  0,  0,  0,
+    0,  0,  0,  0,
+    0,  0,  0,  0,
+    0,  0,  0,  0,
+    0,  0,  0,  0,
+    0,  0,  0,  0,
+    0,  0,  0,  0
   };
 
-static const uint8_t next_state_MPS[64] =
+const uint8_t next_state_MPS[64] =
   {
     1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,
     17,18,19,20,21,22,23,24,25,26,27,28,29,30,31,32,
@@ -117,7 +127,7 @@ static const uint8_t next_state_MPS[64] =
     49,50,51,52,53,54,55,56,57,58,59,60,61,62,62,63
   };
 
-static const uint8_t next_state_LPS[64] =
+const uint8_t next_state_LPS[64] =
   {
     0,0,1,2,2,4,4,5,6,7,8,9,9,11,11,12,
     13,13,15,15,16,16,18,18,19,19,21,21,22,22,23,24,
@@ -129,185 +139,138 @@ static const uint8_t next_state_LPS[64] =
 
 
 
-#ifdef DE265_LOG_TRACE
-int logcnt=1;
+#ifdef DE265_BIT_ACCOUNTING
+const uint16_t log2_range_table[512] =
+  {
+       0,   0, 256, 406, 512, 594, 662, 719, 768, 812, 850, 886, 918, 947, 975,1000,
+    1024,1046,1068,1087,1106,1124,1142,1158,1174,1189,1203,1217,1231,1244,1256,1268,
+    1280,1291,1302,1313,1324,1334,1343,1353,1362,1372,1380,1389,1398,1406,1414,1422,
+    1430,1437,1445,1452,1459,1466,1473,1480,1487,1493,1500,1506,1512,1518,1524,1530,
+    1536,1542,1547,1553,1558,1564,1569,1574,1580,1585,1590,1595,1599,1604,1609,1614,
+    1618,1623,1628,1632,1636,1641,1645,1649,1654,1658,1662,1666,1670,1674,1678,1682,
+    1686,1690,1693,1697,1701,1705,1708,1712,1715,1719,1722,1726,1729,1733,1736,1739,
+    1743,1746,1749,1752,1756,1759,1762,1765,1768,1771,1774,1777,1780,1783,1786,1789,
+    1792,1795,1798,1801,1803,1806,1809,1812,1814,1817,1820,1822,1825,1828,1830,1833,
+    1836,1838,1841,1843,1846,1848,1851,1853,1855,1858,1860,1863,1865,1867,1870,1872,
+    1874,1877,1879,1881,1884,1886,1888,1890,1892,1895,1897,1899,1901,1903,1905,1908,
+    1910,1912,1914,1916,1918,1920,1922,1924,1926,1928,1930,1932,1934,1936,1938,1940,
+    1942,1944,1946,1947,1949,1951,1953,1955,1957,1959,1961,1962,1964,1966,1968,1970,
+    1971,1973,1975,1977,1978,1980,1982,1984,1985,1987,1989,1990,1992,1994,1995,1997,
+    1999,2000,2002,2004,2005,2007,2008,2010,2012,2013,2015,2016,2018,2020,2021,2023,
+    2024,2026,2027,2029,2030,2032,2033,2035,2036,2038,2039,2041,2042,2044,2045,2047,
+    2048,2049,2051,2052,2054,2055,2057,2058,2059,2061,2062,2064,2065,2066,2068,2069,
+    2070,2072,2073,2074,2076,2077,2078,2080,2081,2082,2084,2085,2086,2088,2089,2090,
+    2092,2093,2094,2095,2097,2098,2099,2100,2102,2103,2104,2105,2107,2108,2109,2110,
+    2111,2113,2114,2115,2116,2117,2119,2120,2121,2122,2123,2125,2126,2127,2128,2129,
+    2130,2132,2133,2134,2135,2136,2137,2138,2140,2141,2142,2143,2144,2145,2146,2147,
+    2148,2150,2151,2152,2153,2154,2155,2156,2157,2158,2159,2160,2161,2162,2164,2165,
+    2166,2167,2168,2169,2170,2171,2172,2173,2174,2175,2176,2177,2178,2179,2180,2181,
+    2182,2183,2184,2185,2186,2187,2188,2189,2190,2191,2192,2193,2194,2195,2196,2197,
+    2198,2199,2200,2201,2202,2203,2203,2204,2205,2206,2207,2208,2209,2210,2211,2212,
+    2213,2214,2215,2216,2217,2217,2218,2219,2220,2221,2222,2223,2224,2225,2226,2226,
+    2227,2228,2229,2230,2231,2232,2233,2233,2234,2235,2236,2237,2238,2239,2240,2240,
+    2241,2242,2243,2244,2245,2246,2246,2247,2248,2249,2250,2251,2251,2252,2253,2254,
+    2255,2256,2256,2257,2258,2259,2260,2260,2261,2262,2263,2264,2264,2265,2266,2267,
+    2268,2268,2269,2270,2271,2272,2272,2273,2274,2275,2276,2276,2277,2278,2279,2279,
+    2280,2281,2282,2282,2283,2284,2285,2286,2286,2287,2288,2289,2289,2290,2291,2292,
+    2292,2293,2294,2295,2295,2296,2297,2297,2298,2299,2300,2300,2301,2302,2303,2303
+  };
 #endif
 
-void init_CABAC_decoder(CABAC_decoder* decoder, uint8_t* bitstream, int length)
+
+
+void init_CABAC_decoder(CABAC_decoder* decoder, uint8_t* bitstream, int length,
+                        bool padded)
 {
   assert(length >= 0);
 
   decoder->bitstream_start = bitstream;
   decoder->bitstream_curr  = bitstream;
   decoder->bitstream_end   = bitstream+length;
+
+  // Without padding, a wide refill must not read beyond the end of the data.
+  if (padded)           { decoder->bitstream_fast_end = bitstream+length; }
+  else if (length >= 8) { decoder->bitstream_fast_end = bitstream+length-7; }
+  else                  { decoder->bitstream_fast_end = bitstream; }
+
+  decoder->value = 0;
+  decoder->range = 0;
+  decoder->bits_left = 0;
+  decoder->zero_bits = 0;
+
+#ifdef DE265_BIT_ACCOUNTING
+  decoder->bit_category = de265_bits_other;
+  memset(decoder->bits, 0, sizeof(decoder->bits));
+#endif
 }
 
 void init_CABAC_decoder_2(CABAC_decoder* decoder)
 {
-  int length = decoder->bitstream_end - decoder->bitstream_curr;
+  // restart at the byte following the last bit of the previous offset (byte alignment)
+  decoder->bitstream_curr = get_CABAC_bitstream_position(decoder);
 
   decoder->range = 510;
-  decoder->bits_needed = 8;
-
   decoder->value = 0;
+  decoder->bits_left = -9;
+  decoder->zero_bits = 0;
 
-  if (length>0) { decoder->value  = (*decoder->bitstream_curr++) << 8;  decoder->bits_needed-=8; }
-  if (length>1) { decoder->value |= (*decoder->bitstream_curr++);       decoder->bits_needed-=8; }
+  refill_CABAC_decoder(decoder);
 
-  logtrace(LogCABAC,"[%3d] init_CABAC_decode_2 r:%x v:%x\n", logcnt, decoder->range, decoder->value);
+  logtrace(LogCABAC,"init_CABAC_decode_2 r:%x v:%x\n", decoder->range,
+           (uint32_t)(decoder->value >> decoder->bits_left));
 }
 
 
-int  decode_CABAC_bit(CABAC_decoder* decoder, context_model* model)
+uint8_t* get_CABAC_bitstream_position(const CABAC_decoder* decoder)
 {
-  logtrace(LogCABAC,"[%3d] decodeBin r:%x v:%x state:%d\n",logcnt,decoder->range, decoder->value, model->state);
-
-  int decoded_bit;
-  int LPS = LPS_table[model->state][ ( decoder->range >> 6 ) - 4 ];
-  decoder->range -= LPS;
-
-  uint32_t scaled_range = decoder->range << 7;
+  uint8_t* position = decoder->bitstream_curr;
 
-  logtrace(LogCABAC,"[%3d] sr:%x v:%x\n",logcnt,scaled_range, decoder->value);
-
-  if (decoder->value < scaled_range)
-    {
-      logtrace(LogCABAC,"[%3d] MPS\n",logcnt);
-
-      // MPS path
-
-      decoded_bit = model->MPSbit;
-      model->state = next_state_MPS[model->state];
-
-      if (scaled_range < ( 256 << 7 ) )
-        {
-          // scaled range, highest bit (15) not set
-
-          decoder->range = scaled_range >> 6; // shift range by one bit
-          decoder->value <<= 1;               // shift value by one bit
-          decoder->bits_needed++;
-
-          if (decoder->bits_needed == 0)
-            {
-              decoder->bits_needed = -8;
-              if (decoder->bitstream_curr < decoder->bitstream_end)
-                { decoder->value |= *decoder->bitstream_curr++; }
-            }
-        }
-    }
-  else
-    {
-      logtrace(LogCABAC,"[%3d] LPS\n",logcnt);
-      //printf("%d %d\n", model->state, 0);
-
-      // LPS path
-
-      decoder->value = (decoder->value - scaled_range);
-
-      int num_bits = renorm_table[ LPS >> 3 ];
-      decoder->value <<= num_bits;
-      decoder->range   = LPS << num_bits;  /* this is always >= 0x100 except for state 63,
-                                              but state 63 is never used */
-
-      int num_bitsTab = renorm_table[ LPS >> 3 ];
-
-      assert(num_bits == num_bitsTab);
-
-      decoded_bit      = 1 - model->MPSbit;
-
-      if (model->state==0) { model->MPSbit = 1-model->MPSbit; }
-      model->state = next_state_LPS[model->state];
-
-      decoder->bits_needed += num_bits;
-
-      if (decoder->bits_needed >= 0)
-        {
-          logtrace(LogCABAC,"bits_needed: %d\n", decoder->bits_needed);
-          if (decoder->bitstream_curr < decoder->bitstream_end)
-            { decoder->value |= (*decoder->bitstream_curr++) << decoder->bits_needed; }
-
-          decoder->bits_needed -= 8;
-        }
-    }
+  int lookahead = decoder->bits_left - decoder->zero_bits;
+  if (lookahead > 0) {
+    position -= lookahead>>3;
+  }
 
-  logtrace(LogCABAC,"[%3d] -> bit %d  r:%x v:%x\n", logcnt, decoded_bit, decoder->range, decoder->value);
-#ifdef DE265_LOG_TRACE
-  logcnt++;
-#endif
+  // with padding, wide refills may have read a few zero bytes beyond the end
+  if (position > decoder->bitstream_end) {
+    position = decoder->bitstream_end;
+  }
 
-  return decoded_bit;
+  return position;
 }
 
-int  decode_CABAC_term_bit(CABAC_decoder* decoder)
-{
-  logtrace(LogCABAC,"CABAC term: range=%x\n", decoder->range);
-
-  decoder->range -= 2;
-  uint32_t scaledRange = decoder->range << 7;
-
-  if (decoder->value >= scaledRange)
-    {
-      return 1;
-    }
-  else
-    {
-      // there is a while loop in the standard, but it will always be executed only once
-
-      if (scaledRange < (256<<7))
-        {
-          decoder->range = scaledRange >> 6;
-          decoder->value *= 2;
 
-          decoder->bits_needed++;
-          if (decoder->bits_needed==0)
-            {
-              decoder->bits_needed = -8;
-
-              if (decoder->bitstream_curr < decoder->bitstream_end) {
-                decoder->value += (*decoder->bitstream_curr++);
-              }
-            }
-        }
+void set_CABAC_bitstream_position(CABAC_decoder* decoder, uint8_t* position)
+{
+  assert(position >= decoder->bitstream_start &&
+         position <= decoder->bitstream_end);
 
-      return 0;
-    }
+  decoder->bitstream_curr = position;
+  decoder->bits_left = 0;
+  decoder->zero_bits = 0;
 }
 
 
-
-int  decode_CABAC_bypass(CABAC_decoder* decoder)
+void refill_CABAC_decoder_slow(CABAC_decoder* decoder)
 {
-  logtrace(LogCABAC,"[%3d] bypass r:%x v:%x\n",logcnt,decoder->range, decoder->value);
+  // Bits beyond the end of the bitstream are read as zeros. Count them so that
+  // we can still compute the byte position in get_CABAC_bitstream_position().
 
-  decoder->value <<= 1;
-  decoder->bits_needed++;
+  if (decoder->zero_bits > decoder->bits_left) {
+    decoder->zero_bits = (decoder->bits_left > 0 ? decoder->bits_left : 0);
+  }
 
-  if (decoder->bits_needed >= 0)
-    {
-      if (decoder->bitstream_end > decoder->bitstream_curr) {
-        decoder->bits_needed = -8;
-        decoder->value |= *decoder->bitstream_curr++;
-      }
-    }
+  for (int i=0;i<6;i++) {
+    decoder->value <<= 8;
 
-  int bit;
-  uint32_t scaled_range = decoder->range << 7;
-  if (decoder->value >= scaled_range)
-    {
-      decoder->value -= scaled_range;
-      bit=1;
+    if (decoder->bitstream_curr < decoder->bitstream_end) {
+      decoder->value |= *decoder->bitstream_curr++;
     }
-  else
-    {
-      bit=0;
+    else {
+      decoder->zero_bits += 8;
     }
+  }
 
-  logtrace(LogCABAC,"[%3d] -> bit %d  r:%x v:%x\n", logcnt, bit, decoder->range, decoder->value);
-#ifdef DE265_LOG_TRACE
-  logcnt++;
-#endif
-
-  return bit;
+  decoder->bits_left += 48;
 }
 
 
@@ -336,73 +299,6 @@ int  decode_CABAC_TU(CABAC_decoder* decoder, int cMax, context_model* model)
 }
 
 
-int  decode_CABAC_FL_bypass_parallel(CABAC_decoder* decoder, int nBits)
-{
-  logtrace(LogCABAC,"[%3d] bypass group r:%x v:%x (nBits=%d)\n",logcnt,
-           decoder->range, decoder->value, nBits);
-
-  decoder->value <<= nBits;
-  decoder->bits_needed+=nBits;
-
-  if (decoder->bits_needed >= 0)
-    {
-      if (decoder->bitstream_end > decoder->bitstream_curr) {
-        int input = *decoder->bitstream_curr++;
-        input <<= decoder->bits_needed;
-
-        decoder->bits_needed -= 8;
-        decoder->value |= input;
-      }
-    }
-
-  uint32_t scaled_range = decoder->range << 7;
-  int value = decoder->value / scaled_range;
-  if (unlikely(value>=(1<<nBits))) { value=(1<<nBits)-1; } // may happen with broken bitstreams
-  decoder->value -= value * scaled_range;
-
-  logtrace(LogCABAC,"[%3d] -> value %d  r:%x v:%x\n", logcnt+nBits-1,
-           value, decoder->range, decoder->value);
-
-#ifdef DE265_LOG_TRACE
-  logcnt+=nBits;
-#endif
-
-  return value;
-}
-
-
-int  decode_CABAC_FL_bypass(CABAC_decoder* decoder, int nBits)
-{
-  int value=0;
-
-  if (likely(nBits<=8)) {
-    if (nBits==0) {
-      return 0;
-    }
-    // we could use decode_CABAC_bypass() for a single bit, but this seems to be slower
-#if 0
-    else if (nBits==1) {
-      value = decode_CABAC_bypass(decoder);
-    }
-#endif
-    else {
-      value = decode_CABAC_FL_bypass_parallel(decoder,nBits);
-    }
-  }
-  else {
-    value = decode_CABAC_FL_bypass_parallel(decoder,8);
-    nBits-=8;
-
-    while (nBits--) {
-      value <<= 1;
-      value |= decode_CABAC_bypass(decoder);
-    }
-  }
-  logtrace(LogCABAC,"      -> FL: %d\n", value);
-
-  return value;
-}
-
 int  decode_CABAC_TR_bypass(CABAC_decoder* decoder, int cRiceParam, int cTRMax)
 {
   int prefix = decode_CABAC_TU_bypass(decoder, cTRMax>>cRiceParam);
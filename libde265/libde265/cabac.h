@@ -23,32 +23,239 @@
 
 #include <stdint.h>
 #include "contextmodel.h"
+#include "util.h"
 
 
+/* The decoder keeps a 64-bit window of the bitstream in 'value'. The top bits
+   form the 9-bit arithmetic decoder offset, 'bits_left' look-ahead bits are
+   below it. Whenever fewer than 8 look-ahead bits remain, six bytes are
+   shifted in at once.
+
+   When the input buffer is padded (at least CABAC_DECODER_PADDING zero bytes
+   readable after its end), refills are single unaligned loads up to the very
+   end of the data. Otherwise, the last bytes are read one at a time.
+ */
+
+#define CABAC_DECODER_PADDING 8
+
+
+/* With DE265_BIT_ACCOUNTING, the decoder sums the bits spent on each bin into
+   the category set with set_CABAC_bit_category(). For a context-coded bin, this
+   is log2 of the range before the bin over the range of the decoded symbol,
+   bypass bins count as one bit. The sums are fixed-point with CABAC_BIT_SHIFT
+   fractional bits. Without DE265_BIT_ACCOUNTING, none of this is compiled in.
+ */
+
+#define CABAC_BIT_SHIFT 8
+
 typedef struct {
   uint8_t* bitstream_start;
   uint8_t* bitstream_curr;
   uint8_t* bitstream_end;
+  uint8_t* bitstream_fast_end; // wide refills can be used below this position
 
+  uint64_t value;
   uint32_t range;
-  uint32_t value;
-  int16_t  bits_needed;
+  int16_t  bits_left;  // look-ahead bits in 'value' below the offset
+  int16_t  zero_bits;  // how many of the look-ahead bits are past the end of the bitstream
+
+#ifdef DE265_BIT_ACCOUNTING
+  int      bit_category;
+  uint32_t bits[de265_num_bit_categories];
+#endif
 } CABAC_decoder;
 
 
-void init_CABAC_decoder(CABAC_decoder* decoder, uint8_t* bitstream, int length);
+void init_CABAC_decoder(CABAC_decoder* decoder, uint8_t* bitstream, int length,
+                        bool padded=false);
 void init_CABAC_decoder_2(CABAC_decoder* decoder);
-int  decode_CABAC_bit(CABAC_decoder* decoder, context_model* model);
-int  decode_CABAC_TU(CABAC_decoder* decoder, int cMax, context_model* model);
-int  decode_CABAC_term_bit(CABAC_decoder* decoder);
 
-int  decode_CABAC_bypass(CABAC_decoder* decoder);
+// Position of the first byte that is not part of the arithmetic decoder offset yet.
+uint8_t* get_CABAC_bitstream_position(const CABAC_decoder* decoder);
+
+// Continue decoding at another byte position (e.g. after PCM samples). Call init_CABAC_decoder_2() afterwards.
+void set_CABAC_bitstream_position(CABAC_decoder* decoder, uint8_t* position);
+
+void refill_CABAC_decoder_slow(CABAC_decoder* decoder);
+
+int  decode_CABAC_TU(CABAC_decoder* decoder, int cMax, context_model* model);
 int  decode_CABAC_TU_bypass(CABAC_decoder* decoder, int cMax);
-int  decode_CABAC_FL_bypass(CABAC_decoder* decoder, int nBits);
 int  decode_CABAC_TR_bypass(CABAC_decoder* decoder, int cRiceParam, int cTRMax);
 int  decode_CABAC_EGk_bypass(CABAC_decoder* decoder, int k);
 
 
+extern const uint8_t LPS_table[64][4];
+extern const uint8_t renorm_table[64];
+extern const uint8_t next_state_MPS[64];
+extern const uint8_t next_state_LPS[64];
+
+#ifdef DE265_BIT_ACCOUNTING
+extern const uint16_t log2_range_table[512];  // log2(range) << CABAC_BIT_SHIFT
+
+#define CABAC_ACCOUNT_BITS(decoder, n)  ((decoder)->bits[(decoder)->bit_category] += (n))
+#else
+#define CABAC_ACCOUNT_BITS(decoder, n)
+#endif
+
+static inline void set_CABAC_bit_category(CABAC_decoder* decoder, enum de265_bit_category c)
+{
+#ifdef DE265_BIT_ACCOUNTING
+  decoder->bit_category = c;
+#endif
+}
+
+
+static inline void refill_CABAC_decoder(CABAC_decoder* decoder)
+{
+  if (decoder->bitstream_curr < decoder->bitstream_fast_end) {
+    const uint8_t* p = decoder->bitstream_curr;
+
+    // big-endian load, compilers turn this into a single load and byte swap
+    uint64_t bytes = (((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) |
+                      ((uint64_t)p[2] << 40) | ((uint64_t)p[3] << 32) |
+                      ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) |
+                      ((uint64_t)p[6] <<  8) | ((uint64_t)p[7]));
+
+    decoder->value = (decoder->value << 48) | (bytes >> 16);
+    decoder->bitstream_curr += 6;
+    decoder->bits_left += 48;
+  }
+  else {
+    refill_CABAC_decoder_slow(decoder);
+  }
+}
+
+
+// Bits consumed by the arithmetic decoder so far, up to a constant offset.
+// Unlike bitstream_curr, this does not advance in refill steps.
+
+static inline int64_t CABAC_bit_position(const CABAC_decoder* decoder)
+{
+  return (int64_t)(decoder->bitstream_curr - decoder->bitstream_start)*8
+    + decoder->zero_bits - decoder->bits_left;
+}
+
+
+static inline int decode_CABAC_bit(CABAC_decoder* decoder, context_model* model)
+{
+  int state = model->state;
+  uint32_t LPS   = LPS_table[state][ ( decoder->range >> 6 ) - 4 ];
+  uint32_t range = decoder->range - LPS;
+
+  uint64_t scaled_range = (uint64_t)range << decoder->bits_left;
+
+  // Select the MPS or LPS path without branching. The MPS/LPS decision is
+  // hardly predictable, the refill below is.
+
+  int isLPS = (decoder->value >= scaled_range);
+  uint64_t mask = -(uint64_t)isLPS;
+
+  decoder->value -= scaled_range & mask;
+  range ^= (range ^ LPS) & (uint32_t)mask;
+
+  CABAC_ACCOUNT_BITS(decoder, log2_range_table[decoder->range] - log2_range_table[range]);
+
+  int decoded_bit = model->MPSbit ^ isLPS;
+  model->MPSbit ^= (isLPS & (state==0));
+  model->state  = isLPS ? next_state_LPS[state] : next_state_MPS[state];
+
+  int num_bits = renorm_table[ range >> 3 ];
+  decoder->range = range << num_bits;
+  decoder->bits_left -= num_bits;
+
+  if (decoder->bits_left < 8) {
+    refill_CABAC_decoder(decoder);
+  }
+
+  return decoded_bit;
+}
+
+static inline int decode_CABAC_term_bit(CABAC_decoder* decoder)
+{
+  CABAC_ACCOUNT_BITS(decoder, log2_range_table[decoder->range]);
+
+  decoder->range -= 2;
+  uint64_t scaled_range = (uint64_t)decoder->range << decoder->bits_left;
+
+  if (decoder->value >= scaled_range) {
+    CABAC_ACCOUNT_BITS(decoder, -log2_range_table[2]);  // the arithmetic code ends here
+    return 1;
+  }
+
+  CABAC_ACCOUNT_BITS(decoder, -log2_range_table[decoder->range]);
+
+  // there is a while loop in the standard, but it will always be executed only once
+
+  if (decoder->range < 256) {
+    decoder->range <<= 1;
+    decoder->bits_left--;
+
+    if (decoder->bits_left < 8) {
+      refill_CABAC_decoder(decoder);
+    }
+  }
+
+  return 0;
+}
+
+static inline int decode_CABAC_bypass(CABAC_decoder* decoder)
+{
+  CABAC_ACCOUNT_BITS(decoder, 1<<CABAC_BIT_SHIFT);
+
+  decoder->bits_left--;
+
+  uint64_t scaled_range = (uint64_t)decoder->range << decoder->bits_left;
+
+  int bit = (decoder->value >= scaled_range);
+  decoder->value -= scaled_range & -(uint64_t)bit;
+
+  if (decoder->bits_left < 8) {
+    refill_CABAC_decoder(decoder);
+  }
+
+  return bit;
+}
+
+// decode up to 8 bypass bins at once
+static inline int decode_CABAC_FL_bypass_parallel(CABAC_decoder* decoder, int nBits)
+{
+  CABAC_ACCOUNT_BITS(decoder, nBits<<CABAC_BIT_SHIFT);
+
+  decoder->bits_left -= nBits;
+
+  uint32_t offset = (uint32_t)(decoder->value >> decoder->bits_left);
+  uint32_t value = offset / decoder->range;
+  if (unlikely(value>=(1U<<nBits))) { value=(1<<nBits)-1; } // may happen with broken bitstreams
+
+  decoder->value -= (uint64_t)(value * decoder->range) << decoder->bits_left;
+
+  if (decoder->bits_left < 8) {
+    refill_CABAC_decoder(decoder);
+  }
+
+  return value;
+}
+
+static inline int decode_CABAC_FL_bypass(CABAC_decoder* decoder, int nBits)
+{
+  if (likely(nBits<=8)) {
+    if (nBits==0) {
+      return 0;
+    }
+
+    return decode_CABAC_FL_bypass_parallel(decoder,nBits);
+  }
+
+  int value=0;
+  while (nBits>8) {
+    value = (value<<8) | decode_CABAC_FL_bypass_parallel(decoder,8);
+    nBits-=8;
+  }
+
+  return (value<<nBits) | decode_CABAC_FL_bypass_parallel(decoder,nBits);
+}
+
+
 // ---------------------------------------------------------------------------
 
 class CABAC_encoder
@@ -92,6 +92,10 @@ LIBDE265_API const char* de265_get_error_text(de265_error err)
 
   case DE265_ERROR_WAITING_FOR_INPUT_DATA:
     return "no more input data, decoder stalled";
+  case DE265_ERROR_INPUT_QUEUE_FULL:
+    return "memory limit reached, decode the queued input data first";
+  case DE265_ERROR_CANNOT_WRITE_FILE:
+    return "cannot write file";
   case DE265_ERROR_CANNOT_PROCESS_SEI:
     return "SEI data cannot be processed";
   case DE265_ERROR_PARAMETER_PARSING:
@@ -325,6 +329,11 @@ LIBDE265_API de265_error de265_push_data(de265_decoder_context* de265ctx,
   //printf("push data (size %d)\n",len);
   //dumpdata(data8,16);
 
+  if (ctx->input_blocked_by_memory_limit()) {
+    return DE265_ERROR_INPUT_QUEUE_FULL;
+  }
+
+  stage_timer timer(ctx->main_timing, STAGE_NAL_PARSING);
   return ctx->nal_parser.push_data(data,len,pts,user_data);
 }
 
@@ -339,6 +348,11 @@ LIBDE265_API de265_error de265_push_NAL(de265_decoder_context* de265ctx,
   //printf("push NAL (size %d)\n",len);
   //dumpdata(data8,16);
 
+  if (ctx->input_blocked_by_memory_limit()) {
+    return DE265_ERROR_INPUT_QUEUE_FULL;
+  }
+
+  stage_timer timer(ctx->main_timing, STAGE_NAL_PARSING);
   return ctx->nal_parser.push_NAL(data,len,pts,user_data);
 }
 
@@ -411,6 +425,7 @@ LIBDE265_API const struct de265_image* de265_peek_next_picture(de265_decoder_con
     return img;
   }
   else {
+    ctx->num_output_empty++;
     return NULL;
   }
 }
@@ -480,6 +495,13 @@ LIBDE265_API de265_error de265_get_warning(de265_decoder_context* de265ctx)
   return ctx->get_warning();
 }
 
+LIBDE265_API int de265_get_checksum_mismatch_POC(de265_decoder_context* de265ctx)
+{
+  decoder_context* ctx = (decoder_context*)de265ctx;
+
+  return ctx->hash_mismatch_POC;
+}
+
 LIBDE265_API void de265_set_parameter_bool(de265_decoder_context* de265ctx, enum de265_param param, int value)
 {
   decoder_context* ctx = (decoder_context*)de265ctx;
@@ -502,6 +524,23 @@ LIBDE265_API void de265_set_parameter_bool(de265_decoder_context* de265ctx, enum
       ctx->param_disable_sao = !!value;
       break;
 
+    case DE265_DECODER_PARAM_KEEP_FULL_MOTION_INFO:
+      ctx->param_keep_full_motion_info = !!value;
+      break;
+
+    case DE265_DECODER_PARAM_STAGE_TIMING:
+      ctx->param_stage_timing = !!value;
+      ctx->main_timing.enabled = !!value;
+      break;
+
+    case DE265_DECODER_PARAM_TASK_TRACE:
+      ctx->param_task_trace = !!value;
+      break;
+
+    case DE265_DECODER_PARAM_CTB_COST:
+      ctx->param_ctb_cost = !!value;
+      break;
+
       /*
     case DE265_DECODER_PARAM_DISABLE_MC_RESIDUAL_IDCT:
       ctx->param_disable_mc_residual_idct = !!value;
@@ -545,6 +584,10 @@ LIBDE265_API void de265_set_parameter_int(de265_decoder_context* de265ctx, enum
       ctx->set_acceleration_functions((enum de265_acceleration)value);
       break;
 
+    case DE265_DECODER_PARAM_PLANE_POOL_HUGE_PAGES:
+      ctx->plane_pool.set_huge_pages((enum de265_huge_pages)value);
+      break;
+
     default:
       assert(false);
       break;
@@ -572,6 +615,18 @@ LIBDE265_API int de265_get_parameter_bool(de265_decoder_context* de265ctx, enum
     case DE265_DECODER_PARAM_DISABLE_SAO:
       return ctx->param_disable_sao;
 
+    case DE265_DECODER_PARAM_KEEP_FULL_MOTION_INFO:
+      return ctx->param_keep_full_motion_info;
+
+    case DE265_DECODER_PARAM_STAGE_TIMING:
+      return ctx->param_stage_timing;
+
+    case DE265_DECODER_PARAM_TASK_TRACE:
+      return ctx->param_task_trace;
+
+    case DE265_DECODER_PARAM_CTB_COST:
+      return ctx->param_ctb_cost;
+
       /*
     case DE265_DECODER_PARAM_DISABLE_MC_RESIDUAL_IDCT:
       return ctx->param_disable_mc_residual_idct;
@@ -686,6 +741,72 @@ LIBDE265_API const struct de265_image_allocation *de265_get_default_image_alloca
   return &de265_image::default_image_allocation;
 }
 
+LIBDE265_API void de265_get_plane_pool_statistics(de265_decoder_context* de265ctx,
+                                                  struct de265_plane_pool_statistics* stats)
+{
+  decoder_context* ctx = (decoder_context*)de265ctx;
+
+  ctx->plane_pool.get_statistics(stats);
+}
+
+LIBDE265_API void de265_get_object_pool_statistics(de265_decoder_context* de265ctx,
+                                                   struct de265_object_pool_statistics* stats)
+{
+  decoder_context* ctx = (decoder_context*)de265ctx;
+
+  stats->allocations = ctx->num_object_allocations;
+  stats->reuses      = ctx->num_object_reuses;
+}
+
+LIBDE265_API void de265_get_memory_usage(de265_decoder_context* de265ctx,
+                                         struct de265_memory_usage* usage)
+{
+  decoder_context* ctx = (decoder_context*)de265ctx;
+
+  ctx->get_memory_usage(usage);
+}
+
+LIBDE265_API void de265_set_memory_limit(de265_decoder_context* de265ctx, int64_t bytes)
+{
+  decoder_context* ctx = (decoder_context*)de265ctx;
+
+  ctx->set_memory_limit(bytes);
+}
+
+LIBDE265_API void de265_get_stats(de265_decoder_context* de265ctx,
+                                  struct de265_decoder_stats* stats)
+{
+  decoder_context* ctx = (decoder_context*)de265ctx;
+
+  ctx->get_stats(stats);
+}
+
+LIBDE265_API void de265_get_pipeline_status(de265_decoder_context* de265ctx,
+                                            struct de265_pipeline_status* status)
+{
+  decoder_context* ctx = (decoder_context*)de265ctx;
+
+  ctx->get_pipeline_status(status);
+}
+
+LIBDE265_API de265_error de265_write_task_trace(de265_decoder_context* de265ctx,
+                                                const char* filename)
+{
+  decoder_context* ctx = (decoder_context*)de265ctx;
+
+  FILE* fh = fopen(filename, "wb");
+  if (fh==NULL) {
+    return DE265_ERROR_CANNOT_WRITE_FILE;
+  }
+
+  bool success = ctx->trace.write_chrome_trace(fh);
+  if (fclose(fh) != 0) {
+    success = false;
+  }
+
+  return success ? DE265_OK : DE265_ERROR_CANNOT_WRITE_FILE;
+}
+
 LIBDE265_API de265_PTS de265_get_image_PTS(const struct de265_image* img)
 {
   return img->pts;
@@ -713,6 +834,135 @@ LIBDE265_API void de265_get_image_NAL_header(const struct de265_image* img,
   if (nuh_temporal_id) *nuh_temporal_id = img->nal_hdr.nuh_temporal_id;
 }
 
+LIBDE265_API int de265_get_image_prediction_blocks(const struct de265_image* img,
+                                                   struct de265_prediction_block* out_blocks,
+                                                   int max_blocks)
+{
+  if (!img->has_full_motion_info()) {
+    return -1;
+  }
+
+  const seq_parameter_set& sps = img->get_sps();
+
+  int nBlocks = 0;
+
+  for (int ctb=0; ctb < img->number_of_ctbs(); ctb++) {
+    const PB_info* list = img->get_PB_list(ctb);
+    int nPBs = img->get_num_PBs(ctb);
+
+    int xCtb = (ctb % sps.PicWidthInCtbsY) << sps.Log2CtbSizeY;
+    int yCtb = (ctb / sps.PicWidthInCtbsY) << sps.Log2CtbSizeY;
+
+    for (int i=0; i<nPBs; i++, nBlocks++) {
+      if (nBlocks >= max_blocks) {
+        continue;
+      }
+
+      const PB_info& pb = list[i];
+      de265_prediction_block& out = out_blocks[nBlocks];
+
+      out.x = xCtb + pb.x;
+      out.y = yCtb + pb.y;
+      out.width  = pb.width;
+      out.height = pb.height;
+
+      for (int l=0;l<2;l++) {
+        out.predFlag[l] = pb.motion.predFlag[l];
+        out.refIdx[l]   = pb.motion.refIdx[l];
+        out.mv[l][0]    = pb.motion.mv[l].x;
+        out.mv[l][1]    = pb.motion.mv[l].y;
+      }
+    }
+  }
+
+  return nBlocks;
+}
+
+LIBDE265_API int de265_get_image_ctb_costs(const struct de265_image* img,
+                                           struct de265_ctb_cost* out_costs,
+                                           int max_ctbs, int* out_width_in_ctbs)
+{
+  if (!img->has_ctb_costs()) {
+    return -1;
+  }
+
+  if (out_width_in_ctbs) {
+    *out_width_in_ctbs = img->get_sps().PicWidthInCtbsY;
+  }
+
+  int nCtbs = img->number_of_ctbs();
+
+  for (int ctb=0; ctb < nCtbs && ctb < max_ctbs; ctb++) {
+    out_costs[ctb] = img->get_ctb_cost(ctb);
+  }
+
+  return nCtbs;
+}
+
+LIBDE265_API void de265_get_image_stats(const struct de265_image* img,
+                                        struct de265_picture_stats* out_stats)
+{
+  const picture_stats& stats = img->stats;
+
+  out_stats->num_I_slices = stats.num_slices[SLICE_TYPE_I];
+  out_stats->num_P_slices = stats.num_slices[SLICE_TYPE_P];
+  out_stats->num_B_slices = stats.num_slices[SLICE_TYPE_B];
+  out_stats->slice_data_bytes = stats.slice_data_bytes;
+
+  for (int i=0;i<4;i++) {
+    out_stats->num_CUs[i] = stats.num_CUs[i];
+  }
+
+  out_stats->num_skip_PUs  = stats.num_PUs_skip;
+  out_stats->num_merge_PUs = stats.num_PUs_merge;
+  out_stats->num_AMVP_PUs  = stats.num_PUs_AMVP;
+  out_stats->num_intra_PUs = stats.num_PUs_intra;
+
+  out_stats->average_QP = stats.area ? stats.QP_area_sum / (double)stats.area : 0.0;
+  out_stats->decode_time_ns = stats.decode_time_ns;
+}
+
+LIBDE265_API int de265_get_image_CU_bits(const struct de265_image* img, int x, int y,
+                                         double out_bits[de265_num_bit_categories],
+                                         int* out_x0, int* out_y0, int* out_log2CbSize)
+{
+#ifdef DE265_BIT_ACCOUNTING
+  int x0,y0;
+  const CU_bits* cu = img->find_CU_bits(x,y, &x0,&y0);
+  if (cu==NULL) {
+    return -1;
+  }
+
+  for (int i=0;i<de265_num_bit_categories;i++) {
+    out_bits[i] = cu->bits[i] / (double)(1<<CABAC_BIT_SHIFT);
+  }
+
+  if (out_x0) *out_x0 = x0;
+  if (out_y0) *out_y0 = y0;
+  if (out_log2CbSize) *out_log2CbSize = cu->log2CbSize;
+
+  return 0;
+#else
+  return -1;
+#endif
+}
+
+
+LIBDE265_API int de265_get_image_bits(const struct de265_image* img,
+                                      double out_bits[de265_num_bit_categories])
+{
+#ifdef DE265_BIT_ACCOUNTING
+  for (int i=0;i<de265_num_bit_categories;i++) {
+    out_bits[i] = img->stats.bits[i] / (double)(1<<CABAC_BIT_SHIFT);
+  }
+
+  return 0;
+#else
+  return -1;
+#endif
+}
+
+
 LIBDE265_API int de265_get_image_full_range_flag(const struct de265_image* img)
 {
   return img->get_sps().vui.video_full_range_flag;
@@ -99,6 +99,8 @@ typedef enum {
   DE265_ERROR_NO_INITIAL_SLICE_HEADER=16,
   DE265_ERROR_PREMATURE_END_OF_SLICE=17,
   DE265_ERROR_UNSPECIFIED_DECODING_ERROR=18,
+  DE265_ERROR_INPUT_QUEUE_FULL=19,
+  DE265_ERROR_CANNOT_WRITE_FILE=20,
 
   // --- errors that should become obsolete in later libde265 versions ---
 
@@ -192,6 +194,99 @@ LIBDE265_API int de265_get_image_transfer_characteristics(const struct de265_ima
 LIBDE265_API int de265_get_image_matrix_coefficients(const struct de265_image*);
 
 
+/* Inter prediction blocks of a decoded picture. */
+struct de265_prediction_block
+{
+  uint32_t x,y;          // position in luma samples
+  uint8_t  width,height;
+
+  uint8_t  predFlag[2];  // which of the reference lists L0/L1 are used
+  int8_t   refIdx[2];    // index into the slice's reference picture list
+  int16_t  mv[2][2];     // motion vectors [list][x/y] in quarter samples
+};
+
+/* Copy up to 'max_blocks' prediction blocks of the picture to 'out_blocks' (CTBs in
+   raster order, decoding order within each CTB) and return the total number of blocks.
+   Call with max_blocks=0 to get the count only.
+   Requires DE265_DECODER_PARAM_KEEP_FULL_MOTION_INFO, otherwise -1 is returned.
+ */
+LIBDE265_API int de265_get_image_prediction_blocks(const struct de265_image*,
+                                                   struct de265_prediction_block* out_blocks,
+                                                   int max_blocks);
+
+
+/* Decoding cost of one CTB, as a measure where the decoder spends its time. */
+struct de265_ctb_cost
+{
+  uint32_t bits;             // CABAC bits consumed by the CTB syntax
+  uint32_t time_ns;          // time for parsing and reconstructing the CTB (without in-loop filters)
+  uint32_t num_TUs;          // number of transform units
+  uint32_t num_coefficients; // number of non-zero transform coefficients
+};
+
+/* Copy up to 'max_ctbs' CTB costs of the picture to 'out_costs' (in raster order) and
+   return the number of CTBs. The width of the picture in CTBs is returned in
+   'out_width_in_ctbs' (may be NULL).
+   Requires DE265_DECODER_PARAM_CTB_COST, otherwise -1 is returned.
+ */
+LIBDE265_API int de265_get_image_ctb_costs(const struct de265_image*,
+                                           struct de265_ctb_cost* out_costs,
+                                           int max_ctbs, int* out_width_in_ctbs);
+
+
+/* Statistics of a decoded picture, collected while decoding. */
+struct de265_picture_stats
+{
+  int     num_I_slices, num_P_slices, num_B_slices;  // slice segments
+  int64_t slice_data_bytes;  // size of the slice segment NAL units
+  int     num_CUs[4];        // coding units of size 8x8, 16x16, 32x32, 64x64
+  int     num_skip_PUs;      // prediction units coded in skip mode
+  int     num_merge_PUs;     // merge mode (without skip)
+  int     num_AMVP_PUs;      // explicitly coded motion vectors
+  int     num_intra_PUs;
+  double  average_QP;        // luma QP, averaged over the picture area
+  int64_t decode_time_ns;    // wall-clock time for decoding the slices and filtering the picture
+};
+
+LIBDE265_API void de265_get_image_stats(const struct de265_image*, struct de265_picture_stats*);
+
+
+/* Syntax element categories of the bit accounting. */
+enum de265_bit_category
+{
+  de265_bits_SAO,
+  de265_bits_CU_split,       // split_cu_flag
+  de265_bits_CU_header,      // transquant bypass, skip flag, prediction mode, partitioning, PCM flag
+  de265_bits_intra_mode,     // luma and chroma intra prediction modes
+  de265_bits_merge,          // merge flag and index
+  de265_bits_motion_info,    // inter prediction direction, reference indices, MV predictor flags
+  de265_bits_MVD,
+  de265_bits_transform_tree, // rqt_root_cbf, transform split flags, CBFs
+  de265_bits_delta_QP,       // including the chroma QP offsets
+  de265_bits_residual,       // residual coding, transform skip, RDPCM and cross-component prediction
+  de265_bits_PCM,            // PCM samples
+  de265_bits_other,          // end of slice segment / substream
+  de265_num_bit_categories
+};
+
+/* Bits spent on each syntax category by the coding unit that covers the luma
+   position (x,y). The CABAC bits are estimated from the arithmetic decoder range
+   for each bin. SAO parameters and split flags count for the next CU in decoding order.
+   The CU position and size is returned in 'out_x0', 'out_y0' and 'out_log2CbSize' (may be NULL).
+   Only available when libde265 was built with bit accounting (DE265_BIT_ACCOUNTING).
+   Returns -1 without bit accounting or when no CU has been decoded at this position.
+ */
+LIBDE265_API int de265_get_image_CU_bits(const struct de265_image*, int x, int y,
+                                         double out_bits[de265_num_bit_categories],
+                                         int* out_x0, int* out_y0, int* out_log2CbSize);
+
+/* Bits spent on each syntax category in the whole picture.
+   Returns -1 without bit accounting (see de265_get_image_CU_bits()).
+ */
+LIBDE265_API int de265_get_image_bits(const struct de265_image*,
+                                      double out_bits[de265_num_bit_categories]);
+
+
 /* === decoder === */
 
 typedef void de265_decoder_context; // private structure
@@ -228,6 +323,8 @@ LIBDE265_API LIBDE265_DEPRECATED de265_error de265_decode_data(de265_decoder_con
    The PTS is assigned to all NALs whose start-code 0x000001 is contained in the data.
    The bytestream must contain all stuffing-bytes.
    This function only pushes data into the decoder, nothing will be decoded.
+   Returns DE265_ERROR_INPUT_QUEUE_FULL if the data was not taken because of
+   the memory limit (see de265_set_memory_limit()).
 */
 LIBDE265_API de265_error de265_push_data(de265_decoder_context*, const void* data, int length,
                                          de265_PTS pts, void* user_data);
@@ -301,6 +398,11 @@ LIBDE265_API void de265_release_next_picture(de265_decoder_context*);
 
 LIBDE265_API de265_error de265_get_warning(de265_decoder_context*);
 
+/* POC of the picture that failed the SEI hash check. With worker threads, the hash is
+   checked in the background and DE265_ERROR_CHECKSUM_MISMATCH is returned while later
+   pictures are decoded. Only valid after this error was returned. */
+LIBDE265_API int de265_get_checksum_mismatch_POC(de265_decoder_context*);
+
 
 enum de265_image_format {
   de265_image_format_mono8    = 1,
@@ -348,6 +450,131 @@ LIBDE265_API const struct de265_image_allocation *de265_get_default_image_alloca
 LIBDE265_API void de265_set_image_plane(struct de265_image* img, int cIdx, void* mem, int stride, void *userdata);
 
 
+/* The default allocation functions take the sample planes from a pool in the decoder
+   context. Planes of released pictures are kept in the pool and are handed out again
+   to the next picture with the same plane size. */
+
+struct de265_plane_pool_statistics
+{
+  uint64_t hits;    // plane requests served from the pool
+  uint64_t misses;  // plane requests that required a new allocation
+  int      buffers; // number of buffers currently owned by the pool (in use and free)
+  int64_t  bytes;   // memory size of these buffers
+};
+
+LIBDE265_API void de265_get_plane_pool_statistics(de265_decoder_context*,
+                                                  struct de265_plane_pool_statistics*);
+
+
+/* The decoder's per-picture bookkeeping objects (image units, slice units,
+   slice headers, and decoding tasks) are also recycled. */
+
+struct de265_object_pool_statistics
+{
+  uint64_t allocations; // objects that had to be allocated
+  uint64_t reuses;      // objects taken from the free lists
+};
+
+LIBDE265_API void de265_get_object_pool_statistics(de265_decoder_context*,
+                                                   struct de265_object_pool_statistics*);
+
+
+/* --- memory usage ---
+
+   Breakdown of the memory held by the decoder, in bytes. */
+
+struct de265_memory_usage
+{
+  int64_t picture_planes;  // sample data of the pictures in the DPB and the SAO output buffers
+  int64_t plane_pool;      // unused sample buffers kept for reuse
+  int64_t metadata;        // block metadata of the pictures (modes, motion, ...)
+  int64_t input_queue;     // NAL data waiting for decoding and unused NAL buffers
+  int64_t decoder_objects; // image units, slice units (incl. thread contexts), tasks, headers
+  int64_t total;
+};
+
+LIBDE265_API void de265_get_memory_usage(de265_decoder_context*, struct de265_memory_usage*);
+
+/* Set a memory budget for the decoder (0 = unlimited, the default).
+   While the decoder uses more than this, it frees all cached buffers and recycled
+   objects, keeps the DPB at the size required by the stream, and de265_push_data() /
+   de265_push_NAL() return DE265_ERROR_INPUT_QUEUE_FULL without taking the data as long
+   as there are complete NALs to decode. Call de265_decode() and push the data again.
+   This is a soft limit: memory required for decoding the stream is always allocated.
+ */
+LIBDE265_API void de265_set_memory_limit(de265_decoder_context*, int64_t bytes);
+
+
+/* --- decoding time per stage ---
+
+   Requires DE265_DECODER_PARAM_STAGE_TIMING, otherwise all times are zero.
+   Times are in nanoseconds, summed over all threads since the start of decoding.
+   Waiting for other threads is not included. */
+
+struct de265_decoder_stats
+{
+  int64_t nal_parsing;      // NAL splitting, parameter sets, SEIs
+  int64_t slice_header;     // slice header and picture setup
+  int64_t ctu_parsing;      // CABAC decoding of the CTUs (without the following three stages)
+  int64_t inter_prediction; // motion vector derivation and motion compensation
+  int64_t residual;         // dequantization, inverse transform, adding the residual
+  int64_t intra_prediction;
+  int64_t deblocking;
+  int64_t sao;
+  int64_t hash_check;       // suffix SEIs, i.e. the decoded picture hash check
+  int64_t total;            // sum of the above
+};
+
+LIBDE265_API void de265_get_stats(de265_decoder_context*, struct de265_decoder_stats*);
+
+
+/* --- pipeline status ---
+
+   Queue depths and worker thread states at the time of the call, and counters
+   since the start of decoding, to find out whether decoding is limited by the
+   input, the parsing in the main thread, the worker threads, or the output.
+   Call from the thread that calls de265_decode(). */
+
+struct de265_pipeline_status
+{
+  // current state
+
+  int input_NAL_units;     // NAL units waiting at the decoder input
+  int input_bytes;         // bytes of these NAL units
+  int image_units;         // pictures whose slices are being decoded
+  int reorder_buffer;      // decoded pictures waiting for their output position
+  int output_queue;        // pictures ready for de265_get_next_picture()
+  int dpb_pictures;        // all pictures in the DPB, including reference pictures
+
+  int worker_threads;
+  int threads_busy;        // executing a task, including the blocked threads
+  int threads_blocked;     // waiting for the progress of another task
+  int threads_idle;
+  int tasks_queued;        // waiting for a free worker thread
+
+  // counters
+
+  int64_t waiting_for_input; // de265_decode() returned DE265_ERROR_WAITING_FOR_INPUT_DATA
+  int64_t image_buffer_full; // de265_decode() returned DE265_ERROR_IMAGE_BUFFER_FULL
+  int64_t output_empty;      // de265_peek_next_picture() returned NULL
+  int64_t blocked_waits;     // number of times a task was blocked
+  int64_t blocked_time_ns;   // total time of all tasks in blocked state
+  int64_t main_wait_time_ns; // time the main thread waited for the worker threads to finish a picture
+};
+
+LIBDE265_API void de265_get_pipeline_status(de265_decoder_context*, struct de265_pipeline_status*);
+
+
+/* --- worker thread timeline ---
+
+   Requires DE265_DECODER_PARAM_TASK_TRACE, otherwise the trace is empty. Writes the start and end of each task
+   executed by the worker threads, and the times in which the tasks were blocked
+   waiting for other tasks, in the Chrome trace-event JSON format (view with
+   chrome://tracing or https://ui.perfetto.dev). Can be called at any time. */
+
+LIBDE265_API de265_error de265_write_task_trace(de265_decoder_context*, const char* filename);
+
+
 /* --- frame dropping API ---
 
    To limit decoding to a maximum temporal layer (TID), use de265_set_limit_TID().
@@ -387,9 +614,23 @@ enum de265_param {
   DE265_DECODER_PARAM_SUPPRESS_FAULTY_PICTURES=6, // (bool)  do not output frames with decoding errors, default: no (output all images)
 
   DE265_DECODER_PARAM_DISABLE_DEBLOCKING=7,   // (bool)  disable deblocking
-  DE265_DECODER_PARAM_DISABLE_SAO=8           // (bool)  disable SAO filter
+  DE265_DECODER_PARAM_DISABLE_SAO=8,          // (bool)  disable SAO filter
   //DE265_DECODER_PARAM_DISABLE_MC_RESIDUAL_IDCT=9,     // (bool)  disable decoding of IDCT residuals in MC blocks
   //DE265_DECODER_PARAM_DISABLE_INTRA_RESIDUAL_IDCT=10  // (bool)  disable decoding of IDCT residuals in MC blocks
+
+  DE265_DECODER_PARAM_PLANE_POOL_HUGE_PAGES=11, // (int)  enum de265_huge_pages, default: none
+  //DE265_DECODER_PARAM_TILED_METADATA=12,   // (bool)  replaced by the compile-time option DE265_TILED_METADATA
+  DE265_DECODER_PARAM_KEEP_FULL_MOTION_INFO=13, // (bool)  keep the 4x4 motion grid of decoded pictures (e.g. for visualization), default: no
+  DE265_DECODER_PARAM_STAGE_TIMING=14,       // (bool)  measure the decoding time per stage (see de265_get_stats()), default: no
+  DE265_DECODER_PARAM_TASK_TRACE=15,         // (bool)  record the timeline of the worker threads (see de265_write_task_trace()), set before de265_start_worker_threads(), default: no
+  DE265_DECODER_PARAM_CTB_COST=16            // (bool)  record the decoding cost of each CTB (see de265_get_image_ctb_costs()), default: no
+};
+
+// memory backing of the picture sample planes
+enum de265_huge_pages {
+  de265_huge_pages_none = 0,
+  de265_huge_pages_transparent = 1, // advise the kernel to use transparent huge pages
+  de265_huge_pages_explicit = 2     // use MAP_HUGETLB, fall back to transparent huge pages
 };
 
 // sorted such that a large ID includes all optimizations from lower IDs
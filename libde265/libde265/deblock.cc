@@ -894,23 +894,6 @@ void edge_filtering_chroma_CTB(de265_image* img, bool vertical, int xCtb,int yCt
 }
 
 
-
-class thread_task_deblock_CTBRow : public thread_task
-{
-public:
-  struct de265_image* img;
-  int  ctb_y;
-  bool vertical;
-
-  virtual void work();
-  virtual std::string name() const {
-    char buf[100];
-    sprintf(buf,"deblock-%d",ctb_y);
-    return buf;
-  }
-};
-
-
 void thread_task_deblock_CTBRow::work()
 {
   state = Running;
@@ -955,6 +938,10 @@ void thread_task_deblock_CTBRow::work()
 
   //printf("deblock %d to %d orientation: %d\n",first,last,vertical);
 
+  stage_timing timing;
+  timing.enabled = img->decctx->param_stage_timing;
+  stage_timer timer(timing, STAGE_DEBLOCKING);
+
   bool deblocking_enabled;
 
   // first pass: check edge flags and whether we have to deblock
@@ -979,6 +966,9 @@ void thread_task_deblock_CTBRow::work()
     }
   }
 
+  timer.stop();
+  img->decctx->add_stage_timing(timing);
+
   for (int x=0;x<=rightCtb;x++) {
     const int CtbWidth = img->get_sps().PicWidthInCtbsY;
     img->ctb_progress[x+ctb_y*CtbWidth].set_progress(finalProgress);
@@ -1003,7 +993,7 @@ void add_deblocking_tasks(image_unit* imgunit)
     {
       for (int y=0;y<img->get_sps().PicHeightInCtbsY;y++)
         {
-          thread_task_deblock_CTBRow* task = new thread_task_deblock_CTBRow;
+          thread_task_deblock_CTBRow* task = ctx->alloc_task(ctx->deblock_task_pool);
 
           task->img   = img;
           task->ctb_y = y;
@@ -55,6 +55,13 @@ extern void thread_decode_slice_segment(void* d);
 
 
 thread_context::thread_context()
+{
+  reset();
+}
+
+
+// also used when the thread contexts of a recycled slice_unit are reused
+void thread_context::reset()
 {
   /*
   CtbAddrInRS = 0;
@@ -96,6 +103,9 @@ thread_context::thread_context()
   CuQpOffsetCb = 0;
   CuQpOffsetCr = 0;
 
+  ctb_num_TUs = 0;
+  ctb_num_coefficients = 0;
+
   /*
   currentQPY = 0;
   currentQG_x = 0;
@@ -155,6 +165,7 @@ slice_unit::slice_unit(decoder_context* decctx)
 {
   state = Unprocessed;
   nThreadContexts = 0;
+  thread_contexts_capacity = 0;
 }
 
 slice_unit::~slice_unit()
@@ -167,11 +178,37 @@ slice_unit::~slice_unit()
 }
 
 
+void slice_unit::reset()
+{
+  assert(nal==NULL);
+
+  shdr = NULL;
+  imgunit = NULL;
+  flush_reorder_buffer = false;
+  state = Unprocessed;
+  finished_threads.reset();
+  nThreads = 0;
+  first_decoded_CTB_RS = -1;
+  last_decoded_CTB_RS = -1;
+  nThreadContexts = 0;
+}
+
+
 void slice_unit::allocate_thread_contexts(int n)
 {
-  assert(thread_contexts==NULL);
+  assert(nThreadContexts==0);
+
+  if (n > thread_contexts_capacity) {
+    delete[] thread_contexts;
+    thread_contexts = new thread_context[n];
+    thread_contexts_capacity = n;
+  }
+  else {
+    for (int i=0;i<n;i++) {
+      thread_contexts[i].reset();
+    }
+  }
 
-  thread_contexts = new thread_context[n];
   nThreadContexts = n;
 }
 
@@ -214,6 +251,10 @@ decoder_context::decoder_context()
 
   param_disable_deblocking = false;
   param_disable_sao = false;
+  param_keep_full_motion_info = false;
+  param_stage_timing = false;
+  param_task_trace = false;
+  param_ctb_cost = false;
   //param_disable_mc_residual_idct = false;
   //param_disable_intra_residual_idct = false;
 
@@ -313,11 +354,31 @@ decoder_context::decoder_context()
   // --- decoded picture buffer ---
 
   current_image_poc_lsb = -1; // any invalid number
+
+  num_object_allocations = 0;
+  num_object_reuses = 0;
+
+  memory_limit = 0;
+
+  num_waiting_for_input = 0;
+  num_image_buffer_full = 0;
+  num_output_empty = 0;
+  main_wait_time_ns = 0;
+  num_threads_blocked = 0;
+  num_blocked_waits = 0;
+  blocked_time_ns = 0;
+
+  hash_check_img = NULL;
+  hash_mismatch_POC = 0;
+
+  de265_mutex_init(&timing_mutex);
 }
 
 
 decoder_context::~decoder_context()
 {
+  de265_mutex_destroy(&timing_mutex);
+
   while (!image_units.empty()) {
     delete image_units.back();
     image_units.pop_back();
@@ -325,6 +386,108 @@ decoder_context::~decoder_context()
 }
 
 
+image_unit* decoder_context::alloc_image_unit()
+{
+  image_unit* imgunit = image_unit_pool.get();
+  if (imgunit==NULL) {
+    imgunit = new image_unit;
+    num_object_allocations++;
+  }
+  else {
+    num_object_reuses++;
+  }
+
+  return imgunit;
+}
+
+
+void decoder_context::free_image_unit(image_unit* imgunit)
+{
+  for (int i=0;i<imgunit->slice_units.size();i++) {
+    free_slice_unit(imgunit->slice_units[i]);
+  }
+
+  for (int i=0;i<imgunit->tasks.size();i++) {
+    free_task(imgunit->tasks[i]);
+  }
+
+  imgunit->slice_units.clear();
+  imgunit->tasks.clear();
+  imgunit->suffix_SEIs.clear();
+
+  // ctx_models and the sao_output buffer are kept for the next picture
+
+  imgunit->img   = NULL;
+  imgunit->role  = image_unit::Invalid;
+  imgunit->state = image_unit::Unprocessed;
+
+  image_unit_pool.put(imgunit);
+}
+
+
+slice_unit* decoder_context::alloc_slice_unit()
+{
+  slice_unit* sliceunit = slice_unit_pool.get();
+  if (sliceunit==NULL) {
+    sliceunit = new slice_unit(this);
+    num_object_allocations++;
+  }
+  else {
+    num_object_reuses++;
+  }
+
+  return sliceunit;
+}
+
+
+void decoder_context::free_slice_unit(slice_unit* sliceunit)
+{
+  nal_parser.free_NAL_unit(sliceunit->nal);
+  sliceunit->nal = NULL;
+
+  sliceunit->reset();
+
+  slice_unit_pool.put(sliceunit);
+}
+
+
+slice_segment_header* decoder_context::alloc_slice_header()
+{
+  slice_segment_header* shdr = slice_header_pool.get();
+  if (shdr==NULL) {
+    shdr = new slice_segment_header;
+    num_object_allocations++;
+  }
+  else {
+    num_object_reuses++;
+  }
+
+  // the header is reset when it is read
+
+  return shdr;
+}
+
+
+void decoder_context::free_slice_header(slice_segment_header* shdr)
+{
+  slice_header_pool.put(shdr);
+}
+
+
+void decoder_context::free_task(thread_task* task)
+{
+  task->state = thread_task::Queued;
+
+  if      (thread_task_ctb_row* t = dynamic_cast<thread_task_ctb_row*>(task))               { ctb_row_task_pool.put(t); }
+  else if (thread_task_slice_segment* t = dynamic_cast<thread_task_slice_segment*>(task))   { slice_segment_task_pool.put(t); }
+  else if (thread_task_deblock_CTBRow* t = dynamic_cast<thread_task_deblock_CTBRow*>(task)) { deblock_task_pool.put(t); }
+  else if (thread_task_sao* t = dynamic_cast<thread_task_sao*>(task))                       { sao_task_pool.put(t); }
+  else {
+    delete task;
+  }
+}
+
+
 void decoder_context::set_image_allocation_functions(de265_image_allocation* allocfunc,
                                                      void* userdata)
 {
@@ -343,7 +506,7 @@ void decoder_context::set_image_allocation_functions(de265_image_allocation* all
 
 de265_error decoder_context::start_thread_pool(int nThreads)
 {
-  ::start_thread_pool(&thread_pool_, nThreads);
+  ::start_thread_pool(&thread_pool_, nThreads, param_task_trace ? &trace : NULL);
 
   num_worker_threads = nThreads;
 
@@ -354,6 +517,8 @@ de265_error decoder_context::start_thread_pool(int nThreads)
 void decoder_context::stop_thread_pool()
 {
   if (get_num_worker_threads()>0) {
+    finish_hash_check(); // the remaining tasks would not be processed
+
     //flush_thread_pool(&ctx->thread_pool);
     ::stop_thread_pool(&thread_pool_);
   }
@@ -363,6 +528,8 @@ void decoder_context::stop_thread_pool()
 void decoder_context::reset()
 {
   if (num_worker_threads>0) {
+    finish_hash_check();
+
     //flush_thread_pool(&ctx->thread_pool);
     ::stop_thread_pool(&thread_pool_);
   }
@@ -418,7 +585,7 @@ void decoder_context::reset()
 
 
   while (!image_units.empty()) {
-    delete image_units.back();
+    free_image_unit(image_units.back());
     image_units.pop_back();
   }
 
@@ -457,6 +624,10 @@ void decoder_context::init_thread_context(thread_context* tctx)
   // zero scrap memory for coefficient blocks
   memset(tctx->_coeffBuf, 0, sizeof(tctx->_coeffBuf));  // TODO: check if we can safely remove this
 
+  tctx->timing.enabled = param_stage_timing;
+  tctx->timing.clear();
+  tctx->stats.clear();
+
   tctx->currentQG_x = -1;
   tctx->currentQG_y = -1;
 
@@ -494,11 +665,214 @@ void decoder_context::init_thread_context(thread_context* tctx)
 }
 
 
+static int64_t slice_unit_memory(const slice_unit* sliceunit)
+{
+  int64_t size = sizeof(slice_unit);
+  size += sliceunit->thread_contexts_allocated() * sizeof(thread_context);
+
+  if (sliceunit->nal) {
+    size += sliceunit->nal->allocated_size() + sizeof(NAL_unit);
+  }
+
+  return size;
+}
+
+
+static int64_t image_unit_memory(const image_unit* imgunit, de265_memory_usage* usage)
+{
+  usage->picture_planes += imgunit->sao_output.get_plane_memory();
+
+  int64_t size = sizeof(image_unit);
+  size += imgunit->tasks.capacity() * sizeof(thread_task*);
+
+  for (size_t i=0;i<imgunit->slice_units.size();i++) {
+    size += slice_unit_memory(imgunit->slice_units[i]);
+  }
+
+  return size;
+}
+
+
+void decoder_context::get_memory_usage(de265_memory_usage* usage) const
+{
+  usage->picture_planes = 0;
+  usage->metadata = 0;
+  usage->decoder_objects = 0;
+
+
+  // pictures
+
+  for (int i=0;i<dpb.size();i++) {
+    const de265_image* img = dpb.get_image(i);
+
+    usage->picture_planes += img->get_plane_memory();
+    usage->metadata       += img->get_metadata_memory();
+    usage->decoder_objects += sizeof(de265_image) + img->slices.size()*sizeof(slice_segment_header);
+  }
+
+  usage->plane_pool = plane_pool.get_unused_bytes();
+
+
+  // input
+
+  usage->input_queue = nal_parser.get_memory_usage();
+
+
+  // image units, slice units, and tasks in use and in the free lists
+
+  for (size_t i=0;i<image_units.size();i++) {
+    usage->decoder_objects += image_unit_memory(image_units[i], usage);
+  }
+
+  for (size_t i=0;i<image_unit_pool.size();i++) {
+    usage->decoder_objects += image_unit_memory(image_unit_pool.at(i), usage);
+  }
+
+  for (size_t i=0;i<slice_unit_pool.size();i++) {
+    usage->decoder_objects += slice_unit_memory(slice_unit_pool.at(i));
+  }
+
+  usage->decoder_objects += slice_header_pool.size() * sizeof(slice_segment_header);
+  usage->decoder_objects += ctb_row_task_pool.size() * sizeof(thread_task_ctb_row);
+  usage->decoder_objects += slice_segment_task_pool.size() * sizeof(thread_task_slice_segment);
+  usage->decoder_objects += deblock_task_pool.size() * sizeof(thread_task_deblock_CTBRow);
+  usage->decoder_objects += sao_task_pool.size() * sizeof(thread_task_sao);
+  usage->decoder_objects += hash_task_pool.size() * sizeof(thread_task_hash);
+
+
+  usage->total = (usage->picture_planes + usage->plane_pool + usage->metadata +
+                  usage->input_queue + usage->decoder_objects);
+}
+
+
+void decoder_context::set_memory_limit(int64_t bytes)
+{
+  memory_limit = bytes;
+
+  enforce_memory_limit();
+}
+
+
+bool decoder_context::is_over_memory_limit() const
+{
+  if (memory_limit==0) {
+    return false;
+  }
+
+  de265_memory_usage usage;
+  get_memory_usage(&usage);
+
+  return usage.total > memory_limit;
+}
+
+
+void decoder_context::enforce_memory_limit()
+{
+  if (!is_over_memory_limit()) {
+    return;
+  }
+
+  plane_pool.free_unused_buffers();
+  nal_parser.free_unused_NAL_units();
+
+  image_unit_pool.clear();
+  slice_unit_pool.clear();
+  slice_header_pool.clear();
+  ctb_row_task_pool.clear();
+  slice_segment_task_pool.clear();
+  deblock_task_pool.clear();
+  sao_task_pool.clear();
+  hash_task_pool.clear();
+}
+
+
+bool decoder_context::input_blocked_by_memory_limit() const
+{
+  return (memory_limit != 0 &&
+          nal_parser.number_of_complete_NAL_units_pending() > 0 &&
+          is_over_memory_limit());
+}
+
+
+void decoder_context::add_stage_timing(const stage_timing& timing)
+{
+  if (!timing.enabled) {
+    return;
+  }
+
+  de265_mutex_lock(&timing_mutex);
+  worker_timing.add(timing);
+  de265_mutex_unlock(&timing_mutex);
+}
+
+
+void decoder_context::get_stats(de265_decoder_stats* stats)
+{
+  stage_timing t = main_timing;
+
+  de265_mutex_lock(&timing_mutex);
+  t.add(worker_timing);
+  de265_mutex_unlock(&timing_mutex);
+
+  const int64_t* ns = t.time_ns;
+
+  stats->nal_parsing      = ns[STAGE_NAL_PARSING];
+  stats->slice_header     = ns[STAGE_SLICE_HEADER];
+  stats->inter_prediction = ns[STAGE_INTER_PREDICTION];
+  stats->residual         = ns[STAGE_RESIDUAL];
+  stats->intra_prediction = ns[STAGE_INTRA_PREDICTION];
+  stats->deblocking       = ns[STAGE_DEBLOCKING];
+  stats->sao              = ns[STAGE_SAO];
+  stats->hash_check       = ns[STAGE_HASH_CHECK];
+
+  // the reconstruction stages are timed inside of the CTU decoding
+  stats->ctu_parsing = libde265_max(0, ns[STAGE_CTU] - (stats->inter_prediction +
+                                                        stats->residual +
+                                                        stats->intra_prediction));
+
+  stats->total = (stats->nal_parsing + stats->slice_header + stats->ctu_parsing +
+                  stats->inter_prediction + stats->residual + stats->intra_prediction +
+                  stats->deblocking + stats->sao + stats->hash_check);
+}
+
+
+void decoder_context::get_pipeline_status(de265_pipeline_status* status)
+{
+  status->input_NAL_units = nal_parser.number_of_NAL_units_pending();
+  status->input_bytes     = nal_parser.bytes_in_input_queue();
+  status->image_units     = image_units.size();
+  status->reorder_buffer  = dpb.num_pictures_in_reorder_buffer();
+  status->output_queue    = dpb.num_pictures_in_output_queue();
+  status->dpb_pictures    = dpb.size();
+
+  status->worker_threads  = num_worker_threads;
+  status->threads_busy    = 0;
+  status->tasks_queued    = 0;
+
+  if (num_worker_threads>0) {
+    de265_mutex_lock(&thread_pool_.mutex);
+    status->threads_busy = thread_pool_.num_threads_working;
+    status->tasks_queued = thread_pool_.tasks.size();
+    de265_mutex_unlock(&thread_pool_.mutex);
+  }
+
+  status->threads_blocked = libde265_min(num_threads_blocked.load(), status->threads_busy);
+  status->threads_idle    = num_worker_threads - status->threads_busy;
+
+  status->waiting_for_input = num_waiting_for_input;
+  status->image_buffer_full = num_image_buffer_full;
+  status->output_empty      = num_output_empty;
+  status->blocked_waits     = num_blocked_waits;
+  status->blocked_time_ns   = blocked_time_ns;
+  status->main_wait_time_ns = main_wait_time_ns;
+}
+
+
 void decoder_context::add_task_decode_CTB_row(thread_context* tctx,
                                               bool firstSliceSubstream,
                                               int ctbRow)
 {
-  thread_task_ctb_row* task = new thread_task_ctb_row;
+  thread_task_ctb_row* task = alloc_task(ctb_row_task_pool);
   task->firstSliceSubstream = firstSliceSubstream;
   task->tctx = tctx;
   task->debug_startCtbRow = ctbRow;
@@ -513,7 +887,7 @@ void decoder_context::add_task_decode_CTB_row(thread_context* tctx,
 void decoder_context::add_task_decode_slice_segment(thread_context* tctx, bool firstSliceSubstream,
                                                     int ctbx,int ctby)
 {
-  thread_task_slice_segment* task = new thread_task_slice_segment;
+  thread_task_slice_segment* task = alloc_task(slice_segment_task_pool);
   task->firstSliceSubstream = firstSliceSubstream;
   task->tctx = tctx;
   task->debug_startCtbX = ctbx;
@@ -526,10 +900,54 @@ void decoder_context::add_task_decode_slice_segment(thread_context* tctx, bool f
 }
 
 
-de265_error decoder_context::read_vps_NAL(bitreader& reader)
+uint64_t parameter_set_source::payload_hash(const NAL_unit* nal)
+{
+  // FNV-1a
+
+  uint64_t h = 14695981039346656037ULL;
+
+  const unsigned char* p = nal->data();
+  for (int i=2;i<nal->size();i++) {
+    h = (h ^ p[i]) * 1099511628211ULL;
+  }
+
+  return h;
+}
+
+
+void parameter_set_source::set(const NAL_unit* nal)
+{
+  hash = payload_hash(nal);
+  data.assign(nal->data()+2, nal->data()+nal->size());
+}
+
+
+bool parameter_set_source::matches(const NAL_unit* nal, uint64_t nal_hash) const
+{
+  return (nal_hash == hash &&
+          nal->size()-2 == (int)data.size() &&
+          !data.empty() &&
+          memcmp(nal->data()+2, data.data(), data.size())==0);
+}
+
+
+de265_error decoder_context::read_vps_NAL(bitreader& reader, const NAL_unit* nal)
 {
   logdebug(LogHeaders,"---> read VPS\n");
 
+  // identical re-send of a VPS that we already have
+
+  uint64_t hash = parameter_set_source::payload_hash(nal);
+  for (int i=0;i<DE265_MAX_VPS_SETS;i++) {
+    if (vps[i] && vps_source[i].matches(nal, hash)) {
+      if (param_vps_headers_fd>=0) {
+        vps[i]->dump(param_vps_headers_fd);
+      }
+
+      return DE265_OK;
+    }
+  }
+
   std::shared_ptr<video_parameter_set> new_vps = std::make_shared<video_parameter_set>();
   de265_error err = new_vps->read(this,&reader);
   if (err != DE265_OK) {
@@ -541,14 +959,29 @@ de265_error decoder_context::read_vps_NAL(bitreader& reader)
   }
 
   vps[ new_vps->video_parameter_set_id ] = new_vps;
+  vps_source[ new_vps->video_parameter_set_id ].set(nal);
 
   return DE265_OK;
 }
 
-de265_error decoder_context::read_sps_NAL(bitreader& reader)
+de265_error decoder_context::read_sps_NAL(bitreader& reader, const NAL_unit* nal)
 {
   logdebug(LogHeaders,"----> read SPS\n");
 
+  // Identical re-send of an SPS that we already have. Keeping the object also keeps
+  // the PPSs that refer to it valid.
+
+  uint64_t hash = parameter_set_source::payload_hash(nal);
+  for (int i=0;i<DE265_MAX_SPS_SETS;i++) {
+    if (sps[i] && sps_source[i].matches(nal, hash)) {
+      if (param_sps_headers_fd>=0) {
+        sps[i]->dump(param_sps_headers_fd);
+      }
+
+      return DE265_OK;
+    }
+  }
+
   std::shared_ptr<seq_parameter_set> new_sps = std::make_shared<seq_parameter_set>();
   de265_error err;
 
@@ -561,14 +994,30 @@ de265_error decoder_context::read_sps_NAL(bitreader& reader)
   }
 
   sps[ new_sps->seq_parameter_set_id ] = new_sps;
+  sps_source[ new_sps->seq_parameter_set_id ].set(nal);
 
   return DE265_OK;
 }
 
-de265_error decoder_context::read_pps_NAL(bitreader& reader)
+de265_error decoder_context::read_pps_NAL(bitreader& reader, const NAL_unit* nal)
 {
   logdebug(LogHeaders,"----> read PPS\n");
 
+  // Identical re-send of a PPS that we already have. The derived tables depend on the
+  // SPS, hence the PPS can only be kept if its SPS has not been replaced in between.
+
+  uint64_t hash = parameter_set_source::payload_hash(nal);
+  for (int i=0;i<DE265_MAX_PPS_SETS;i++) {
+    if (pps[i] && pps_source[i].matches(nal, hash) &&
+        pps[i]->sps == sps[ (int)pps[i]->seq_parameter_set_id ]) {
+      if (param_pps_headers_fd>=0) {
+        pps[i]->dump(param_pps_headers_fd);
+      }
+
+      return DE265_OK;
+    }
+  }
+
   std::shared_ptr<pic_parameter_set> new_pps = std::make_shared<pic_parameter_set>();
 
   bool success = new_pps->read(&reader,this);
@@ -579,6 +1028,7 @@ de265_error decoder_context::read_pps_NAL(bitreader& reader)
 
   if (success) {
     pps[ (int)new_pps->pic_parameter_set_id ] = new_pps;
+    pps_source[ (int)new_pps->pic_parameter_set_id ].set(nal);
   }
 
   return success ? DE265_OK : DE265_WARNING_PPS_HEADER_INVALID;
@@ -621,13 +1071,15 @@ de265_error decoder_context::read_slice_NAL(bitreader& reader, NAL_unit* nal, na
 
   // --- read slice header ---
 
-  slice_segment_header* shdr = new slice_segment_header;
+  stage_timer timer(main_timing, STAGE_SLICE_HEADER);
+
+  slice_segment_header* shdr = alloc_slice_header();
   bool continueDecoding;
   de265_error err = shdr->read(&reader,this, &continueDecoding);
   if (!continueDecoding) {
     if (img) { img->integrity = INTEGRITY_NOT_DECODED; }
     nal_parser.free_NAL_unit(nal);
-    delete shdr;
+    free_slice_header(shdr);
     return err;
   }
 
@@ -640,7 +1092,7 @@ de265_error decoder_context::read_slice_NAL(bitreader& reader, NAL_unit* nal, na
     {
       if (img!=NULL) img->integrity = INTEGRITY_NOT_DECODED;
       nal_parser.free_NAL_unit(nal);
-      delete shdr;
+      free_slice_header(shdr);
       return err;
     }
 
@@ -663,7 +1115,7 @@ de265_error decoder_context::read_slice_NAL(bitreader& reader, NAL_unit* nal, na
   // --- start a new image if this is the first slice ---
 
   if (shdr->first_slice_segment_in_pic_flag) {
-    image_unit* imgunit = new image_unit;
+    image_unit* imgunit = alloc_image_unit();
     imgunit->img = this->img;
     image_units.push_back(imgunit);
   }
@@ -673,7 +1125,7 @@ de265_error decoder_context::read_slice_NAL(bitreader& reader, NAL_unit* nal, na
 
   if ( ! image_units.empty() ) {
 
-    slice_unit* sliceunit = new slice_unit(this);
+    slice_unit* sliceunit = alloc_slice_unit();
     sliceunit->nal = nal;
     sliceunit->shdr = shdr;
     sliceunit->reader = reader;
@@ -684,9 +1136,16 @@ de265_error decoder_context::read_slice_NAL(bitreader& reader, NAL_unit* nal, na
     image_units.back()->slice_units.push_back(sliceunit);
   }
 
+  timer.stop();
+
   bool did_work;
   err = decode_some(&did_work);
 
+  // the hash of a previous picture may have been checked in between
+  if (err == DE265_ERROR_CHECKSUM_MISMATCH) {
+    return err;
+  }
+
   return DE265_OK;
 }
 
@@ -726,8 +1185,17 @@ de265_error decoder_context::decode_some(bool* did_work)
 
       *did_work = true;
 
+      int64_t decodeStart = stage_timing::now();
+
       //err = decode_slice_unit_sequential(imgunit, sliceunit);
       err = decode_slice_unit_parallel(imgunit, sliceunit);
+
+      picture_stats sliceStats;
+      sliceStats.num_slices[sliceunit->shdr->slice_type]++;
+      sliceStats.slice_data_bytes = sliceunit->nal->size();
+      sliceStats.decode_time_ns = stage_timing::now() - decodeStart;
+      imgunit->img->add_stats(sliceStats);
+
       if (err) {
         return err;
       }
@@ -757,6 +1225,9 @@ de265_error decoder_context::decode_some(bool* did_work)
     // so we will have to replace this with keeping track of which CTB should have
     // been decoded (but aren't because of the input stream being faulty)
 
+    int64_t filterStart = stage_timing::now();
+
+    imgunit->img->clear_remaining_CTB_metadata();
     imgunit->img->mark_all_CTB_progress(CTB_PROGRESS_PREFILTER);
 
 
@@ -770,22 +1241,54 @@ de265_error decoder_context::decode_some(bool* did_work)
 
     // process suffix SEIs
 
+    stage_timer timer(main_timing, STAGE_HASH_CHECK);
+
+    // result of the previous picture
+    err = finish_hash_check();
+
     for (int i=0;i<imgunit->suffix_SEIs.size();i++) {
       const sei_message& sei = imgunit->suffix_SEIs[i];
 
-      err = process_sei(&sei, imgunit->img);
-      if (err != DE265_OK)
+      if (sei.payload_type == sei_payload_type_decoded_picture_hash &&
+          param_sei_check_hash && num_worker_threads>0) {
+        start_hash_check(&sei.data.decoded_picture_hash, imgunit->img);
+        continue;
+      }
+
+      de265_error seiErr = process_sei(&sei, imgunit->img);
+      if (seiErr == DE265_ERROR_CHECKSUM_MISMATCH) {
+        mark_hash_mismatch(imgunit->img);
+      }
+      if (seiErr != DE265_OK) {
+        err = seiErr;
         break;
+      }
     }
 
+    timer.stop();
+
+    picture_stats filterStats;
+    filterStats.decode_time_ns = stage_timing::now() - filterStart;
+    imgunit->img->add_stats(filterStats);
+
+
+    // only the 16x16 motion grid is needed for TMVP from now on
+
+    imgunit->img->compress_motion_info(param_keep_full_motion_info);
 
     push_picture_to_output_queue(imgunit);
 
     // remove just decoded image unit from queue
 
-    delete imgunit;
+    free_image_unit(imgunit);
 
     pop_front(image_units);
+
+    // pictures that were output and are not referenced anymore only keep their samples
+
+    dpb.release_unused_metadata(param_keep_full_motion_info);
+
+    enforce_memory_limit();
   }
 
   return err;
@@ -829,7 +1332,8 @@ de265_error decoder_context::decode_slice_unit_sequential(image_unit* imgunit,
 
   init_CABAC_decoder(&tctx.cabac_decoder,
                      sliceunit->reader.data,
-                     sliceunit->reader.bytes_remaining);
+                     sliceunit->reader.bytes_remaining,
+                     sliceunit->nal->is_padded());
 
   // alloc CABAC-model array if entropy_coding_sync is enabled
 
@@ -842,6 +1346,10 @@ de265_error decoder_context::decode_slice_unit_sequential(image_unit* imgunit,
 
   err=read_slice_segment_data(&tctx);
 
+  add_stage_timing(tctx.timing);
+  tctx.collect_remaining_bits();
+  imgunit->img->add_stats(tctx.stats);
+
   sliceunit->finished_threads.set_progress(1);
 
   return err;
@@ -1055,9 +1563,12 @@ de265_error decoder_context::decode_slice_unit_WPP(image_unit* imgunit,
       break;
     }
 
+    // only the last substream ends at the (padded) end of the NAL
     init_CABAC_decoder(&tctx->cabac_decoder,
                        &sliceunit->reader.data[dataStartIndex],
-                       dataEnd-dataStartIndex);
+                       dataEnd-dataStartIndex,
+                       sliceunit->nal->is_padded() &&
+                       dataEnd == sliceunit->reader.bytes_remaining);
 
     // add task
 
@@ -1084,7 +1595,7 @@ de265_error decoder_context::decode_slice_unit_WPP(image_unit* imgunit,
   img->wait_for_completion();
 
   for (int i=0;i<imgunit->tasks.size();i++)
-    delete imgunit->tasks[i];
+    free_task(imgunit->tasks[i]);
   imgunit->tasks.clear();
 
   return DE265_OK;
@@ -1157,9 +1668,12 @@ de265_error decoder_context::decode_slice_unit_tiles(image_unit* imgunit,
       break;
     }
 
+    // only the last substream ends at the (padded) end of the NAL
     init_CABAC_decoder(&tctx->cabac_decoder,
                        &sliceunit->reader.data[dataStartIndex],
-                       dataEnd-dataStartIndex);
+                       dataEnd-dataStartIndex,
+                       sliceunit->nal->is_padded() &&
+                       dataEnd == sliceunit->reader.bytes_remaining);
 
     // add task
 
@@ -1174,7 +1688,7 @@ de265_error decoder_context::decode_slice_unit_tiles(image_unit* imgunit,
   img->wait_for_completion();
 
   for (int i=0;i<imgunit->tasks.size();i++)
-    delete imgunit->tasks[i];
+    free_task(imgunit->tasks[i]);
   imgunit->tasks.clear();
 
   return err;
@@ -1189,6 +1703,8 @@ de265_error decoder_context::decode_NAL(NAL_unit* nal)
 
   de265_error err = DE265_OK;
 
+  stage_timer timer(main_timing, STAGE_NAL_PARSING);
+
   bitreader reader;
   bitreader_init(&reader, nal->data(), nal->size());
 
@@ -1227,21 +1743,22 @@ de265_error decoder_context::decode_NAL(NAL_unit* nal)
 
 
   if (nal_hdr.nal_unit_type<32) {
+    timer.stop(); // slices are timed separately
     err = read_slice_NAL(reader, nal, nal_hdr);
   }
   else switch (nal_hdr.nal_unit_type) {
     case NAL_UNIT_VPS_NUT:
-      err = read_vps_NAL(reader);
+      err = read_vps_NAL(reader, nal);
       nal_parser.free_NAL_unit(nal);
       break;
 
     case NAL_UNIT_SPS_NUT:
-      err = read_sps_NAL(reader);
+      err = read_sps_NAL(reader, nal);
       nal_parser.free_NAL_unit(nal);
       break;
 
     case NAL_UNIT_PPS_NUT:
-      err = read_pps_NAL(reader);
+      err = read_pps_NAL(reader, nal);
       nal_parser.free_NAL_unit(nal);
       break;
 
@@ -1275,6 +1792,10 @@ de265_error decoder_context::decode(int* more)
       (ctx->nal_parser.is_end_of_stream() || ctx->nal_parser.is_end_of_frame()) &&
       ctx->image_units.empty()) {
 
+    // the hash of the last picture is still being checked
+
+    de265_error err = finish_hash_check();
+
     // flush all pending pictures into output queue
 
     // ctx->push_current_picture_to_output_queue(); // TODO: not with new queue
@@ -1282,7 +1803,7 @@ de265_error decoder_context::decode(int* more)
 
     if (more) { *more = ctx->dpb.num_pictures_in_output_queue(); }
 
-    return DE265_OK;
+    return err;
   }
 
 
@@ -1294,6 +1815,7 @@ de265_error decoder_context::decode(int* more)
       ctx->nal_parser.get_NAL_queue_length() == 0) {
     if (more) { *more=1; }
 
+    num_waiting_for_input++;
     return DE265_ERROR_WAITING_FOR_INPUT_DATA;
   }
 
@@ -1303,6 +1825,8 @@ de265_error decoder_context::decode(int* more)
 
   if (!ctx->dpb.has_free_dpb_picture(false)) {
     if (more) *more = 1;
+
+    num_image_buffer_full++;
     return DE265_ERROR_IMAGE_BUFFER_FULL;
   }
 
@@ -1323,6 +1847,7 @@ de265_error decoder_context::decode(int* more)
       ctx->image_units.empty()) {
     if (more) { *more=1; }
 
+    num_waiting_for_input++;
     return DE265_ERROR_WAITING_FOR_INPUT_DATA;
   }
   else {
@@ -1877,6 +2402,7 @@ void decoder_context::run_postprocessing_filters_sequential(de265_image* img)
 #endif
 
     if (!img->decctx->param_disable_deblocking) {
+      stage_timer timer(main_timing, STAGE_DEBLOCKING);
       apply_deblocking_filter(img);
     }
 
@@ -1886,6 +2412,7 @@ void decoder_context::run_postprocessing_filters_sequential(de265_image* img)
 #endif
 
     if (!img->decctx->param_disable_sao) {
+      stage_timer timer(main_timing, STAGE_SAO);
       apply_sample_adaptive_offset_sequential(img);
     }
 
@@ -1896,6 +2423,75 @@ void decoder_context::run_postprocessing_filters_sequential(de265_image* img)
 }
 
 
+void decoder_context::start_hash_check(const sei_decoded_picture_hash* hash, de265_image* img)
+{
+  // Do not check pictures that are not output (see process_sei_decoded_picture_hash()).
+  if (img->PicOutputFlag == false) {
+    return;
+  }
+
+  assert(hash_check_img==NULL || hash_check_img==img);
+
+  if (hash_check_img==NULL) {
+    hash_progress.reset();
+  }
+
+  hash_check_img = img;
+  img->hash_check_pending = true;  // the image buffer must not be reused until we are done
+
+  int nPlanes = img->get_sps().chroma_format_idc==0 ? 1 : 3;
+
+  for (int cIdx=0;cIdx<nPlanes;cIdx++) {
+    thread_task_hash* task = alloc_task(hash_task_pool);
+    task->state = thread_task::Queued;
+    task->img  = img;
+    task->cIdx = cIdx;
+    task->hash = *hash;
+    task->mismatch = false;
+    task->finished = &hash_progress;
+
+    hash_tasks.push_back(task);
+    add_task(&thread_pool_, task);
+  }
+}
+
+
+de265_error decoder_context::finish_hash_check()
+{
+  if (hash_check_img==NULL) {
+    return DE265_OK;
+  }
+
+  int64_t waitStart = stage_timing::now();
+  hash_progress.wait_for_progress(hash_tasks.size());
+  main_wait_time_ns += stage_timing::now() - waitStart;
+
+  bool mismatch = false;
+  for (size_t i=0;i<hash_tasks.size();i++) {
+    mismatch |= hash_tasks[i]->mismatch;
+    hash_task_pool.put(hash_tasks[i]);
+  }
+
+  hash_tasks.clear();
+
+  if (mismatch) {
+    mark_hash_mismatch(hash_check_img);
+  }
+
+  hash_check_img->hash_check_pending = false;
+  hash_check_img = NULL;
+
+  return mismatch ? DE265_ERROR_CHECKSUM_MISMATCH : DE265_OK;
+}
+
+
+void decoder_context::mark_hash_mismatch(de265_image* img)
+{
+  img->integrity = INTEGRITY_DECODING_ERRORS;
+  hash_mismatch_POC = img->PicOrderCntVal;
+}
+
+
 void decoder_context::run_postprocessing_filters_parallel(image_unit* imgunit)
 {
   de265_image* img = imgunit->img;
@@ -2007,6 +2603,13 @@ bool decoder_context::process_slice_segment_header(slice_segment_header* hdr,
 
     // --- find and allocate image buffer for decoding ---
 
+    // Under a memory limit, shrink the DPB down to the size required by the stream
+    // instead of keeping unused slots.
+
+    if (memory_limit != 0) {
+      dpb.set_norm_size_of_DPB(sps->sps_max_dec_pic_buffering[sps->sps_max_sub_layers-1] + 1);
+    }
+
     int image_buffer_idx;
     bool isOutputImage = (!sps->sample_adaptive_offset_enabled_flag || param_disable_sao);
     image_buffer_idx = dpb.new_image(current_sps, this, pts, user_data, isOutputImage);
@@ -2024,7 +2627,8 @@ bool decoder_context::process_slice_segment_header(slice_segment_header* hdr,
 
     img->decctx = this;
 
-    img->clear_metadata();
+    // the metadata of each CTB is cleared when the CTB is decoded
+    img->clear_metadata_lazily();
 
 
     if (isIRAP(nal_unit_type)) {
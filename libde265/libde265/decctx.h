@@ -34,6 +34,8 @@
 #include "libde265/threads.h"
 #include "libde265/acceleration.h"
 #include "libde265/nal-parser.h"
+#include "libde265/alloc_pool.h"
+#include "libde265/stage-timing.h"
 
 #include <memory>
 
@@ -48,6 +50,8 @@ class slice_segment_header;
 class image_unit;
 class slice_unit;
 class decoder_context;
+class thread_task_deblock_CTBRow;
+class thread_task_sao;
 
 
 class thread_context
@@ -55,6 +59,8 @@ class thread_context
 public:
   thread_context();
 
+  void reset();
+
   int CtbAddrInRS;
   int CtbAddrInTS;
 
@@ -87,6 +93,11 @@ public:
   int16_t coeffList[3][32*32];
   int16_t coeffPos[3][32*32];
   int16_t nCoeff[3];
+  int16_t lastSubBlock[3]; // last coded 4x4 sub-block in scan order, 0: only top-left 4x4 coefficients
+
+  // statistics of the current CTB, for the CTB cost map
+  uint32_t ctb_num_TUs;
+  uint32_t ctb_num_coefficients;
 
   int32_t residual_luma[32*32]; // only used when cross-comp-prediction is enabled
 
@@ -117,6 +128,19 @@ public:
   slice_unit* sliceunit;
   thread_task* task; // executing thread_task or NULL if not multi-threaded
 
+  stage_timing timing; // added to the decoder totals at the end of the task
+  picture_stats stats; // added to the picture at the end of the task
+
+  // Add the CABAC bits that were not assigned to a CU yet to 'stats'.
+  void collect_remaining_bits() {
+#ifdef DE265_BIT_ACCOUNTING
+    for (int i=0;i<de265_num_bit_categories;i++) {
+      stats.bits[i] += cabac_decoder.bits[i];
+      cabac_decoder.bits[i] = 0;
+    }
+#endif
+  }
+
 private:
   thread_context(const thread_context&); // not allowed
   const thread_context& operator=(const thread_context&); // not allowed
@@ -147,6 +171,9 @@ public:
   slice_unit(decoder_context* decctx);
   ~slice_unit();
 
+  // back to the state after construction, but keep the thread contexts for reuse
+  void reset();
+
   NAL_unit* nal;   // we are the owner
   slice_segment_header* shdr;  // not the owner (de265_image is owner)
   bitreader reader;
@@ -175,11 +202,13 @@ public:
     return &thread_contexts[n];
   }
   int num_thread_contexts() const { return nThreadContexts; }
+  int thread_contexts_allocated() const { return thread_contexts_capacity; }
 
 private:
   thread_context* thread_contexts; /* NOTE: cannot use std::vector, because thread_context has
                                       no copy constructor. */
   int nThreadContexts;
+  int thread_contexts_capacity;
 
 public:
   decoder_context* ctx;
@@ -270,6 +299,30 @@ public:
 };
 
 
+/* The NAL payload that a parameter set was read from. Many encoders resend
+   identical parameter sets at every IRAP or even before every picture. These
+   re-sends are recognized by comparing them against the stored payload, such
+   that the existing parameter set objects and their derived tables are kept.
+ */
+class parameter_set_source
+{
+ public:
+  parameter_set_source() : hash(0) { }
+
+  void set(const NAL_unit* nal);
+  void clear() { hash=0; data.clear(); }
+
+  bool matches(const NAL_unit* nal, uint64_t nal_hash) const;
+
+  // hash of the payload without the NAL header
+  static uint64_t payload_hash(const NAL_unit* nal);
+
+ private:
+  uint64_t hash;
+  std::vector<uint8_t> data;
+};
+
+
 class base_context : public error_queue
 {
  public:
@@ -352,6 +405,10 @@ class decoder_context : public base_context {
 
   bool param_disable_deblocking;
   bool param_disable_sao;
+  bool param_keep_full_motion_info;
+  bool param_stage_timing;
+  bool param_task_trace;
+  bool param_ctb_cost;
   //bool param_disable_mc_residual_idct;  // not implemented yet
   //bool param_disable_intra_residual_idct;  // not implemented yet
 
@@ -360,12 +417,125 @@ class decoder_context : public base_context {
   de265_image_allocation param_image_allocation_functions;
   void*                  param_image_allocation_userdata;
 
+  // used by the default allocation functions, has to outlive the DPB
+  image_plane_pool plane_pool;
+
 
   // --- input stream data ---
 
   NAL_Parser nal_parser;
 
 
+  // --- recycled per-picture objects ---
+
+  /* Image units, slice units, slice headers and decoding tasks are taken from
+     free lists and returned there when they are not needed anymore. In the steady
+     state, no new objects have to be allocated. Only use from the main decoding thread.
+   */
+
+  image_unit* alloc_image_unit();
+  void        free_image_unit(image_unit*);
+
+  slice_unit* alloc_slice_unit();
+  void        free_slice_unit(slice_unit*);
+
+  slice_segment_header* alloc_slice_header();
+  void                  free_slice_header(slice_segment_header*);
+
+  template <class T> T* alloc_task(free_list<T>& list) {
+    T* task = list.get();
+    if (task==NULL) {
+      task = new T;
+      num_object_allocations++;
+    }
+    else {
+      num_object_reuses++;
+    }
+    return task;
+  }
+  void free_task(thread_task*);
+
+  // The free lists have to outlive the DPB (the images own the slice headers).
+  free_list<image_unit>                 image_unit_pool;
+  free_list<slice_unit>                 slice_unit_pool;
+  free_list<slice_segment_header>       slice_header_pool;
+  free_list<thread_task_ctb_row>        ctb_row_task_pool;
+  free_list<thread_task_slice_segment>  slice_segment_task_pool;
+  free_list<thread_task_deblock_CTBRow> deblock_task_pool;
+  free_list<thread_task_sao>            sao_task_pool;
+  free_list<thread_task_hash>           hash_task_pool;
+
+  uint64_t num_object_allocations;  // objects that had to be created with 'new'
+  uint64_t num_object_reuses;       // objects taken from the free lists
+
+
+  // --- memory accounting ---
+
+  void get_memory_usage(de265_memory_usage*) const;
+
+  void set_memory_limit(int64_t bytes);
+  bool is_over_memory_limit() const;
+
+  /* When over the limit, free all cached memory that is not needed for decoding
+     (unused picture planes, NAL buffers, recycled objects). */
+  void enforce_memory_limit();
+
+  /* Input backpressure: do not accept more input data while over the limit and
+     there are complete NALs that can be decoded first. */
+  bool input_blocked_by_memory_limit() const;
+
+  int64_t memory_limit;  // in bytes, 0: no limit
+
+
+  // --- decoding time per stage ---
+
+  void add_stage_timing(const stage_timing&);  // thread-safe
+  void get_stats(de265_decoder_stats*);
+
+  stage_timing main_timing;  // stages running in the main decoding thread
+
+
+  // --- pipeline status ---
+
+  void get_pipeline_status(de265_pipeline_status*);
+
+  // counted by the main thread
+  int64_t num_waiting_for_input;
+  int64_t num_image_buffer_full;
+  int64_t num_output_empty;
+  int64_t main_wait_time_ns;
+
+  // counted by the worker threads in de265_image::wait_for_progress()
+  std::atomic<int>     num_threads_blocked;
+  std::atomic<int64_t> num_blocked_waits;
+  std::atomic<int64_t> blocked_time_ns;
+
+
+  // --- decoded picture hash check on the worker threads ---
+
+  /* With worker threads, the SEI hash of a picture is checked by one task per color
+     plane while the next picture is decoded. finish_hash_check() waits for these tasks
+     and returns DE265_ERROR_CHECKSUM_MISMATCH if a plane did not match. It is called
+     when the next picture has been filtered and at the end of the stream. As the error
+     is returned later than the picture was decoded, the failing picture is remembered
+     in hash_mismatch_POC.
+     Only use from the main decoding thread.
+   */
+  void        start_hash_check(const sei_decoded_picture_hash*, de265_image*);
+  de265_error finish_hash_check();
+  void        mark_hash_mismatch(de265_image*);
+
+  de265_image* hash_check_img;  // NULL if no hash check is pending
+  int          hash_mismatch_POC;  // picture of the last DE265_ERROR_CHECKSUM_MISMATCH
+  std::vector<thread_task_hash*> hash_tasks;
+  de265_progress_lock hash_progress;
+
+
+  // --- timeline of the worker thread tasks ---
+
+  task_trace trace;  // only recorded when param_task_trace was set when starting the threads
+
+
   int get_num_worker_threads() const { return num_worker_threads; }
 
   /* */ de265_image* get_image(int dpb_index)       { return dpb.get_image(dpb_index); }
@@ -378,9 +548,12 @@ class decoder_context : public base_context {
   void         pop_next_picture_in_output_queue() { dpb.pop_next_picture_in_output_queue(); }
 
  private:
-  de265_error read_vps_NAL(bitreader&);
-  de265_error read_sps_NAL(bitreader&);
-  de265_error read_pps_NAL(bitreader&);
+  stage_timing worker_timing;  // sum of all finished tasks
+  de265_mutex  timing_mutex;
+
+  de265_error read_vps_NAL(bitreader&, const NAL_unit* nal);
+  de265_error read_sps_NAL(bitreader&, const NAL_unit* nal);
+  de265_error read_pps_NAL(bitreader&, const NAL_unit* nal);
   de265_error read_sei_NAL(bitreader& reader, bool suffix);
   de265_error read_eos_NAL(bitreader& reader);
   de265_error read_slice_NAL(bitreader&, NAL_unit* nal, nal_header& nal_hdr);
@@ -392,6 +565,10 @@ class decoder_context : public base_context {
   std::shared_ptr<seq_parameter_set>    sps[ DE265_MAX_SPS_SETS ];
   std::shared_ptr<pic_parameter_set>    pps[ DE265_MAX_PPS_SETS ];
 
+  parameter_set_source vps_source[ DE265_MAX_VPS_SETS ];
+  parameter_set_source sps_source[ DE265_MAX_SPS_SETS ];
+  parameter_set_source pps_source[ DE265_MAX_PPS_SETS ];
+
   std::shared_ptr<video_parameter_set>  current_vps;
   std::shared_ptr<seq_parameter_set>    current_sps;
   std::shared_ptr<pic_parameter_set>    current_pps;
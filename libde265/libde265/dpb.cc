@@ -201,6 +201,23 @@ void decoded_picture_buffer::clear()
 }
 
 
+void decoded_picture_buffer::release_unused_metadata(bool keep_motion_info)
+{
+  bool first = true;
+
+  for (int i=0;i<dpb.size();i++) {
+    if (dpb[i]->can_be_released()) {
+      if (first) {
+        first = false;
+      }
+      else if (dpb[i]->has_decoding_metadata()) {
+        dpb[i]->release_decoding_metadata(keep_motion_info);
+      }
+    }
+  }
+}
+
+
 int decoded_picture_buffer::new_image(std::shared_ptr<const seq_parameter_set> sps,
                                       decoder_context* decctx,
                                       de265_PTS pts, void* user_data, bool isOutputImage)
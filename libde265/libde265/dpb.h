@@ -50,6 +50,11 @@ public:
   /* Remove all pictures from DPB and queues. Decoding should be stopped while calling this. */
   void clear();
 
+  /* Free the decoding metadata of the pictures that are neither used for reference
+     nor waiting for output. The first free slot keeps its metadata, because
+     new_image() will reuse it next. */
+  void release_unused_metadata(bool keep_motion_info);
+
   int size() const { return dpb.size(); }
 
   /* Raw access to the images. */
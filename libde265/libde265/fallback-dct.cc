@@ -258,7 +258,7 @@ void rotate_coefficients_fallback(int16_t *coeff, int nT)
 
 
 
-static int8_t mat_8_357[4][4] = {
+const int8_t mat_8_357[4][4] = {
   { 29, 55, 74, 84 },
   { 74, 74,  0,-74 },
   { 84,-29,-74, 55 },
@@ -510,7 +510,7 @@ void transform_idst_4x4_fallback(int32_t *dst, const int16_t *coeffs, int bdShif
 
 
 
-static int8_t mat_dct[32][32] = {
+const int8_t mat_dct[32][32] = {
   { 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,      64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64},
   { 90, 90, 88, 85, 82, 78, 73, 67, 61, 54, 46, 38, 31, 22, 13,  4,      -4,-13,-22,-31,-38,-46,-54,-61,-67,-73,-78,-82,-85,-88,-90,-90},
   { 90, 87, 80, 70, 57, 43, 25,  9, -9,-25,-43,-57,-70,-80,-87,-90,     -90,-87,-80,-70,-57,-43,-25, -9,  9, 25, 43, 57, 70, 80, 87, 90},
@@ -693,6 +693,66 @@ void transform_idct_add(pixel_t *dst, ptrdiff_t stride,
 
 
 
+// Only coeffs[0] is non-zero. All DCT basis functions are 64 at DC, hence the
+// residual is constant over the whole block.
+template <class pixel_t>
+void transform_idct_dc_add(pixel_t *dst, ptrdiff_t stride,
+                           int nT, const int16_t *coeffs, int bit_depth)
+{
+  int postShift = 20-bit_depth;
+  int rnd1 = 1<<(7-1);
+  int rnd2 = 1<<(postShift-1);
+
+  int g   = Clip3(-32768,32767, (64*coeffs[0] + rnd1)>>7);
+  int out = (64*g + rnd2)>>postShift;
+
+  for (int y=0;y<nT;y++)
+    for (int x=0;x<nT;x++) {
+      dst[y*stride+x] = Clip_BitDepth(dst[y*stride+x] + out, bit_depth);
+    }
+}
+
+
+// Only the top-left 4x4 coefficients are non-zero. The vertical pass only
+// has to process 4 columns and both passes only sum over 4 basis functions.
+template <class pixel_t>
+void transform_idct_topleft4x4_add(pixel_t *dst, ptrdiff_t stride,
+                                   int nT, const int16_t *coeffs, int bit_depth)
+{
+  int postShift = 20-bit_depth;
+  int rnd1 = 1<<(7-1);
+  int rnd2 = 1<<(postShift-1);
+  int fact = (1<<(5-Log2(nT)));
+
+  int16_t g[32][4];
+
+  for (int c=0;c<4;c++)
+    for (int i=0;i<nT;i++) {
+      int sum=0;
+
+      for (int j=0;j<4;j++) {
+        sum += mat_dct[fact*j][i] * coeffs[c+j*nT];
+      }
+
+      g[i][c] = Clip3(-32768,32767, (sum+rnd1)>>7);
+    }
+
+  for (int y=0;y<nT;y++)
+    for (int i=0;i<nT;i++) {
+      int sum=0;
+
+      for (int j=0;j<4;j++) {
+        sum += mat_dct[fact*j][i] * g[y][j];
+      }
+
+      int out = (sum+rnd2)>>postShift;
+
+      dst[y*stride+i] = Clip_BitDepth(dst[y*stride+i] + out, bit_depth);
+    }
+}
+
+
+
 void transform_idct_fallback(int32_t *dst, int nT, const int16_t *coeffs, int bdShift, int max_coeff_bits)
 {
   /*
@@ -904,6 +964,78 @@ void transform_32x32_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdi
 }
 
 
+void transform_4x4_dc_add_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
+{
+  transform_idct_dc_add<uint8_t>(dst,stride,  4, coeffs, 8);
+}
+
+void transform_8x8_dc_add_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
+{
+  transform_idct_dc_add<uint8_t>(dst,stride,  8, coeffs, 8);
+}
+
+void transform_16x16_dc_add_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
+{
+  transform_idct_dc_add<uint8_t>(dst,stride,  16, coeffs, 8);
+}
+
+void transform_32x32_dc_add_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
+{
+  transform_idct_dc_add<uint8_t>(dst,stride,  32, coeffs, 8);
+}
+
+void transform_8x8_topleft4x4_add_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
+{
+  transform_idct_topleft4x4_add<uint8_t>(dst,stride,  8, coeffs, 8);
+}
+
+void transform_16x16_topleft4x4_add_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
+{
+  transform_idct_topleft4x4_add<uint8_t>(dst,stride,  16, coeffs, 8);
+}
+
+void transform_32x32_topleft4x4_add_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
+{
+  transform_idct_topleft4x4_add<uint8_t>(dst,stride,  32, coeffs, 8);
+}
+
+
+void transform_4x4_dc_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth)
+{
+  transform_idct_dc_add<uint16_t>(dst,stride,  4, coeffs, bit_depth);
+}
+
+void transform_8x8_dc_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth)
+{
+  transform_idct_dc_add<uint16_t>(dst,stride,  8, coeffs, bit_depth);
+}
+
+void transform_16x16_dc_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth)
+{
+  transform_idct_dc_add<uint16_t>(dst,stride,  16, coeffs, bit_depth);
+}
+
+void transform_32x32_dc_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth)
+{
+  transform_idct_dc_add<uint16_t>(dst,stride,  32, coeffs, bit_depth);
+}
+
+void transform_8x8_topleft4x4_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth)
+{
+  transform_idct_topleft4x4_add<uint16_t>(dst,stride,  8, coeffs, bit_depth);
+}
+
+void transform_16x16_topleft4x4_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth)
+{
+  transform_idct_topleft4x4_add<uint16_t>(dst,stride,  16, coeffs, bit_depth);
+}
+
+void transform_32x32_topleft4x4_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth)
+{
+  transform_idct_topleft4x4_add<uint16_t>(dst,stride,  32, coeffs, bit_depth);
+}
+
+
 static void transform_fdct_8(int16_t* coeffs, int nT,
                              const int16_t *input, ptrdiff_t stride)
 {
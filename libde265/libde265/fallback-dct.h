@@ -27,6 +27,12 @@
 #include "util.h"
 
 
+// inverse DST / DCT matrices (8.6.4.2), shared with the SIMD implementations
+
+extern const int8_t mat_8_357[4][4];
+extern const int8_t mat_dct[32][32];
+
+
 // --- decoding ---
 
 void transform_skip_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
@@ -53,6 +59,24 @@ void transform_8x8_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff
 void transform_16x16_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
 void transform_32x32_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
 
+// sparse coefficient blocks (only DC / only top-left 4x4)
+
+void transform_4x4_dc_add_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
+void transform_8x8_dc_add_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
+void transform_16x16_dc_add_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
+void transform_32x32_dc_add_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
+void transform_8x8_topleft4x4_add_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
+void transform_16x16_topleft4x4_add_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
+void transform_32x32_topleft4x4_add_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
+
+void transform_4x4_dc_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+void transform_8x8_dc_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+void transform_16x16_dc_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+void transform_32x32_dc_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+void transform_8x8_topleft4x4_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+void transform_16x16_topleft4x4_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+void transform_32x32_topleft4x4_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+
 void rotate_coefficients_fallback(int16_t *coeff, int nT);
 
 
@@ -21,6 +21,7 @@
 #include "fallback.h"
 #include "fallback-motion.h"
 #include "fallback-dct.h"
+#include "fallback-intrapred.h"
 
 
 void init_acceleration_functions_fallback(struct acceleration_functions* accel)
@@ -101,6 +102,32 @@ void init_acceleration_functions_fallback(struct acceleration_functions* accel)
   accel->transform_add_16[2] = transform_16x16_add_16_fallback;
   accel->transform_add_16[3] = transform_32x32_add_16_fallback;
 
+  accel->transform_dc_add_8[0] = transform_4x4_dc_add_8_fallback;
+  accel->transform_dc_add_8[1] = transform_8x8_dc_add_8_fallback;
+  accel->transform_dc_add_8[2] = transform_16x16_dc_add_8_fallback;
+  accel->transform_dc_add_8[3] = transform_32x32_dc_add_8_fallback;
+  accel->transform_topleft4x4_add_8[0] = transform_4x4_add_8_fallback;
+  accel->transform_topleft4x4_add_8[1] = transform_8x8_topleft4x4_add_8_fallback;
+  accel->transform_topleft4x4_add_8[2] = transform_16x16_topleft4x4_add_8_fallback;
+  accel->transform_topleft4x4_add_8[3] = transform_32x32_topleft4x4_add_8_fallback;
+
+  accel->transform_dc_add_16[0] = transform_4x4_dc_add_16_fallback;
+  accel->transform_dc_add_16[1] = transform_8x8_dc_add_16_fallback;
+  accel->transform_dc_add_16[2] = transform_16x16_dc_add_16_fallback;
+  accel->transform_dc_add_16[3] = transform_32x32_dc_add_16_fallback;
+  accel->transform_topleft4x4_add_16[0] = transform_4x4_add_16_fallback;
+  accel->transform_topleft4x4_add_16[1] = transform_8x8_topleft4x4_add_16_fallback;
+  accel->transform_topleft4x4_add_16[2] = transform_16x16_topleft4x4_add_16_fallback;
+  accel->transform_topleft4x4_add_16[3] = transform_32x32_topleft4x4_add_16_fallback;
+
+  // no scalar fused dequantization+transform, the separate steps are used instead
+  accel->transform_4x4_dst_dequant_add_8 = NULL;
+  accel->transform_4x4_dst_dequant_add_16 = NULL;
+  for (int i=0;i<4;i++) {
+    accel->transform_dequant_add_8[i]  = NULL;
+    accel->transform_dequant_add_16[i] = NULL;
+  }
+
   accel->rotate_coefficients = rotate_coefficients_fallback;
   accel->add_residual_8  = add_residual_fallback<uint8_t>;
   accel->add_residual_16 = add_residual_fallback<uint16_t>;
@@ -114,6 +141,16 @@ void init_acceleration_functions_fallback(struct acceleration_functions* accel)
   accel->transform_idct_16x16 = transform_idct_16x16_fallback;
   accel->transform_idct_32x32 = transform_idct_32x32_fallback;
 
+  accel->intra_prediction_sample_filtering_8 = intra_prediction_sample_filtering_8_fallback;
+  accel->intra_prediction_planar_8  = intra_prediction_planar_8_fallback;
+  accel->intra_prediction_DC_8      = intra_prediction_DC_8_fallback;
+  accel->intra_prediction_angular_8 = intra_prediction_angular_8_fallback;
+
+  accel->intra_prediction_sample_filtering_16 = intra_prediction_sample_filtering_16_fallback;
+  accel->intra_prediction_planar_16  = intra_prediction_planar_16_fallback;
+  accel->intra_prediction_DC_16      = intra_prediction_DC_16_fallback;
+  accel->intra_prediction_angular_16 = intra_prediction_angular_16_fallback;
+
   accel->fwd_transform_4x4_dst_8 = fdst_4x4_8_fallback;
   accel->fwd_transform_8[0] = fdct_4x4_8_fallback;
   accel->fwd_transform_8[1] = fdct_8x8_8_fallback;
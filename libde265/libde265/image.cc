@@ -33,6 +33,10 @@
 #include <malloc.h>
 #endif
 
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
 #ifdef HAVE_SSE4_1
 // SSE code processes 128bit per iteration and thus might read more data
 // than is later actually used.
@@ -105,6 +109,237 @@ LIBDE265_API void de265_free_image_plane(struct de265_image* img, int cIdx)
 }
 
 
+#define HUGE_PAGE_SIZE (2*1024*1024)
+
+image_plane_pool::image_plane_pool()
+{
+  huge_pages = de265_huge_pages_none;
+  hits = misses = 0;
+  total_bytes = 0;
+
+  de265_mutex_init(&mutex);
+}
+
+
+image_plane_pool::~image_plane_pool()
+{
+  // all pictures should have been released by now
+  assert(used_buffers.empty());
+
+  for (size_t i=0;i<free_buffers.size();i++) {
+    free_memory(free_buffers[i]);
+  }
+
+  de265_mutex_destroy(&mutex);
+}
+
+
+void image_plane_pool::set_huge_pages(enum de265_huge_pages mode)
+{
+  de265_mutex_lock(&mutex);
+
+  huge_pages = mode;
+
+  // drop the cached buffers such that all new planes use the new memory type
+
+  for (size_t i=0;i<free_buffers.size();i++) {
+    free_memory(free_buffers[i]);
+  }
+  free_buffers.clear();
+
+  de265_mutex_unlock(&mutex);
+}
+
+
+bool image_plane_pool::alloc_memory(buffer& buf, size_t size)
+{
+  buf.size = size;
+  buf.alloc_size = size;
+  buf.mmapped = false;
+  buf.mem = NULL;
+
+#ifdef HAVE_SYS_MMAN_H
+  if (huge_pages != de265_huge_pages_none) {
+    size_t huge_size = (size + HUGE_PAGE_SIZE-1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+
+#ifdef MAP_HUGETLB
+    if (huge_pages == de265_huge_pages_explicit) {
+      void* p = mmap(NULL, huge_size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (p != MAP_FAILED) {
+        buf.mem = (uint8_t*)p;
+        buf.alloc_size = huge_size;
+        buf.mmapped = true;
+        return true;
+      }
+
+      // no huge pages reserved in the system, use transparent huge pages
+    }
+#endif
+
+#ifdef MADV_HUGEPAGE
+    buf.mem = (uint8_t*)ALLOC_ALIGNED(HUGE_PAGE_SIZE, huge_size);
+    if (buf.mem) {
+      buf.alloc_size = huge_size;
+      madvise(buf.mem, huge_size, MADV_HUGEPAGE);
+      return true;
+    }
+#endif
+  }
+#endif
+
+  buf.mem = (uint8_t*)ALLOC_ALIGNED_16(size);
+  return buf.mem != NULL;
+}
+
+
+void image_plane_pool::free_memory(buffer& buf)
+{
+#ifdef HAVE_SYS_MMAN_H
+  if (buf.mmapped) {
+    munmap(buf.mem, buf.alloc_size);
+  }
+  else
+#endif
+    {
+      FREE_ALIGNED(buf.mem);
+    }
+
+  total_bytes -= buf.alloc_size;
+  buf.mem = NULL;
+}
+
+
+/* Free the cached buffers with a size that is not used by any picture anymore.
+   This happens after a change of the picture size or chroma format.
+ */
+void image_plane_pool::free_unused_sizes()
+{
+  for (size_t i=0;i<free_buffers.size(); ) {
+    bool size_in_use = false;
+    for (size_t k=0;k<used_buffers.size();k++) {
+      if (used_buffers[k].size == free_buffers[i].size) {
+        size_in_use = true;
+        break;
+      }
+    }
+
+    if (size_in_use) {
+      i++;
+    }
+    else {
+      free_memory(free_buffers[i]);
+      free_buffers[i] = free_buffers.back();
+      free_buffers.pop_back();
+    }
+  }
+}
+
+
+uint8_t* image_plane_pool::get_buffer(size_t size)
+{
+  de265_mutex_lock(&mutex);
+
+  for (size_t i=0;i<free_buffers.size();i++) {
+    if (free_buffers[i].size == size) {
+      used_buffers.push_back(free_buffers[i]);
+      free_buffers[i] = free_buffers.back();
+      free_buffers.pop_back();
+
+      hits++;
+
+      de265_mutex_unlock(&mutex);
+      return used_buffers.back().mem;
+    }
+  }
+
+  misses++;
+
+  free_unused_sizes();
+
+  buffer buf;
+  if (!alloc_memory(buf, size)) {
+    de265_mutex_unlock(&mutex);
+    return NULL;
+  }
+
+  total_bytes += buf.alloc_size;
+  used_buffers.push_back(buf);
+
+  de265_mutex_unlock(&mutex);
+  return buf.mem;
+}
+
+
+void image_plane_pool::release_buffer(uint8_t* mem)
+{
+  de265_mutex_lock(&mutex);
+
+  for (size_t i=0;i<used_buffers.size();i++) {
+    if (used_buffers[i].mem == mem) {
+      free_buffers.push_back(used_buffers[i]);
+      used_buffers[i] = used_buffers.back();
+      used_buffers.pop_back();
+      break;
+    }
+  }
+
+  de265_mutex_unlock(&mutex);
+}
+
+
+int64_t image_plane_pool::get_unused_bytes() const
+{
+  de265_mutex_lock(&mutex);
+
+  int64_t bytes = 0;
+  for (size_t i=0;i<free_buffers.size();i++) {
+    bytes += free_buffers[i].alloc_size;
+  }
+
+  de265_mutex_unlock(&mutex);
+
+  return bytes;
+}
+
+
+void image_plane_pool::free_unused_buffers()
+{
+  de265_mutex_lock(&mutex);
+
+  for (size_t i=0;i<free_buffers.size();i++) {
+    free_memory(free_buffers[i]);
+  }
+  free_buffers.clear();
+
+  de265_mutex_unlock(&mutex);
+}
+
+
+void image_plane_pool::get_statistics(de265_plane_pool_statistics* stats) const
+{
+  de265_mutex_lock(&mutex);
+
+  stats->hits    = hits;
+  stats->misses  = misses;
+  stats->buffers = free_buffers.size() + used_buffers.size();
+  stats->bytes   = total_bytes;
+
+  de265_mutex_unlock(&mutex);
+}
+
+
+static uint8_t* alloc_plane(image_plane_pool* pool, size_t size)
+{
+  if (pool) {
+    return pool->get_buffer(size);
+  }
+  else {
+    return (uint8_t *)ALLOC_ALIGNED_16(size);
+  }
+}
+
+
 static int  de265_image_get_buffer(de265_decoder_context* ctx,
                                    de265_image_spec* spec, de265_image* img, void* userdata)
 {
@@ -123,15 +358,17 @@ static int  de265_image_get_buffer(de265_decoder_context* ctx,
   int luma_height   = spec->height;
   int chroma_height = rawChromaHeight;
 
+  image_plane_pool* pool = (img->decctx ? &img->decctx->plane_pool : NULL);
+
   bool alloc_failed = false;
 
   uint8_t* p[3] = { 0,0,0 };
-  p[0] = (uint8_t *)ALLOC_ALIGNED_16(luma_height   * luma_bpl   + MEMORY_PADDING);
+  p[0] = alloc_plane(pool, luma_height   * luma_bpl   + MEMORY_PADDING);
   if (p[0]==NULL) { alloc_failed=true; }
 
   if (img->get_chroma_format() != de265_chroma_mono) {
-    p[1] = (uint8_t *)ALLOC_ALIGNED_16(chroma_height * chroma_bpl + MEMORY_PADDING);
-    p[2] = (uint8_t *)ALLOC_ALIGNED_16(chroma_height * chroma_bpl + MEMORY_PADDING);
+    p[1] = alloc_plane(pool, chroma_height * chroma_bpl + MEMORY_PADDING);
+    p[2] = alloc_plane(pool, chroma_height * chroma_bpl + MEMORY_PADDING);
 
     if (p[1]==NULL || p[2]==NULL) { alloc_failed=true; }
   }
@@ -144,7 +381,8 @@ static int  de265_image_get_buffer(de265_decoder_context* ctx,
   if (alloc_failed) {
     for (int i=0;i<3;i++)
       if (p[i]) {
-        FREE_ALIGNED(p[i]);
+        if (pool) { pool->release_buffer(p[i]); }
+        else      { FREE_ALIGNED(p[i]); }
       }
 
     return 0;
@@ -160,10 +398,13 @@ static int  de265_image_get_buffer(de265_decoder_context* ctx,
 static void de265_image_release_buffer(de265_decoder_context* ctx,
                                        de265_image* img, void* userdata)
 {
+  image_plane_pool* pool = (img->decctx ? &img->decctx->plane_pool : NULL);
+
   for (int i=0;i<3;i++) {
     uint8_t* p = (uint8_t*)img->get_image_plane(i);
     if (p) {
-      FREE_ALIGNED(p);
+      if (pool) { pool->release_buffer(p); }
+      else      { FREE_ALIGNED(p); }
     }
   }
 }
@@ -212,6 +453,11 @@ de265_image::de265_image()
   user_data = NULL;
 
   ctb_progress = NULL;
+  motion_compressed = false;
+  metadata_generation = 0;
+  log2PBsPerCtb = 0;
+  pb_log2CtbSize = 0;
+  pb_ctbsPerRow = 0;
 
   integrity = INTEGRITY_NOT_DECODED;
 
@@ -220,6 +466,8 @@ de265_image::de265_image()
   PicState = UnusedForReference;
   PicOutputFlag = false;
 
+  hash_check_pending = false;
+
   nThreadsQueued   = 0;
   nThreadsRunning  = 0;
   nThreadsBlocked  = 0;
@@ -250,6 +498,8 @@ de265_error de265_image::alloc_image(int w,int h, enum de265_chroma c,
   ID = s_next_image_ID++;
   removed_at_picture_id = std::numeric_limits<int32_t>::max();
 
+  stats.clear();
+
   decctx = dctx;
   //encctx = ectx;
 
@@ -410,42 +660,61 @@ de265_error de265_image::alloc_image(int w,int h, enum de265_chroma c,
   // --- allocate decoding info arrays ---
 
   if (allocMetadata) {
+    // CTB-major layout of the block metadata, only used when compiled with DE265_TILED_METADATA
+
+    int log2TileSize = sps->Log2CtbSizeY;
+
     // intra pred mode
 
     mem_alloc_success &= intraPredMode.alloc(sps->PicWidthInMinPUs, sps->PicHeightInMinPUs,
-                                             sps->Log2MinPUSize);
+                                             sps->Log2MinPUSize, log2TileSize);
 
     mem_alloc_success &= intraPredModeC.alloc(sps->PicWidthInMinPUs, sps->PicHeightInMinPUs,
-                                              sps->Log2MinPUSize);
+                                              sps->Log2MinPUSize, log2TileSize);
+
+    // If any of the arrays cleared by clear_metadata() is reallocated, it has to be
+    // cleared completely before lazy clearing can be used again.
+
+    int prevSizes[3] = { cb_info.data_size, deblk_info.data_size, ctb_info.data_size };
 
     // cb info
 
     mem_alloc_success &= cb_info.alloc(sps->PicWidthInMinCbsY, sps->PicHeightInMinCbsY,
-                                       sps->Log2MinCbSizeY);
+                                       sps->Log2MinCbSizeY, log2TileSize);
 
-    // pb info
+    // pb info: a list of PBs for each CTB (room for one PB per 8x4 block, the smallest
+    // PB size) and the 4x4 grid of indices into these lists
 
     int puWidth  = sps->PicWidthInMinCbsY  << (sps->Log2MinCbSizeY -2);
     int puHeight = sps->PicHeightInMinCbsY << (sps->Log2MinCbSizeY -2);
 
-    mem_alloc_success &= pb_info.alloc(puWidth,puHeight, 2);
+    mem_alloc_success &= pb_index.alloc(puWidth,puHeight, 2, log2TileSize);
+
+    log2PBsPerCtb = 2*(sps->Log2CtbSizeY-2) -1;
+    pb_log2CtbSize = sps->Log2CtbSizeY;
+    pb_ctbsPerRow  = sps->PicWidthInCtbsY;
+    mem_alloc_success &= pb_list.alloc(1<<log2PBsPerCtb, sps->PicSizeInCtbsY, 0);
+
+    mem_alloc_success &= col_motion.alloc((sps->pic_width_in_luma_samples +15)>>4,
+                                          (sps->pic_height_in_luma_samples+15)>>4, 4);
+    motion_compressed = false;
 
 
     // tu info
 
     mem_alloc_success &= tu_info.alloc(sps->PicWidthInTbsY, sps->PicHeightInTbsY,
-                                       sps->Log2MinTrafoSize);
+                                       sps->Log2MinTrafoSize, log2TileSize);
 
     // deblk info
 
     int deblk_w = (sps->pic_width_in_luma_samples +3)/4;
     int deblk_h = (sps->pic_height_in_luma_samples+3)/4;
 
-    mem_alloc_success &= deblk_info.alloc(deblk_w, deblk_h, 2);
+    mem_alloc_success &= deblk_info.alloc(deblk_w, deblk_h, 2, log2TileSize);
 
     // CTB info
 
-    if (ctb_info.data_size != sps->PicSizeInCtbsY)
+    if (ctb_info.data_size != sps->PicSizeInCtbsY || ctb_progress == NULL)
       {
         delete[] ctb_progress;
 
@@ -455,6 +724,29 @@ de265_error de265_image::alloc_image(int w,int h, enum de265_chroma c,
         ctb_progress = new de265_progress_lock[ ctb_info.data_size ];
       }
 
+    // CTB costs, written when the CTB is decoded
+
+    if (decctx && decctx->param_ctb_cost) {
+      mem_alloc_success &= ctb_cost.alloc(sps->PicWidthInCtbsY, sps->PicHeightInCtbsY,
+                                          sps->Log2CtbSizeY);
+      ctb_cost.clear();
+    }
+    else {
+      ctb_cost.release();
+    }
+
+#ifdef DE265_BIT_ACCOUNTING
+    mem_alloc_success &= cu_bits.alloc(sps->PicWidthInMinCbsY, sps->PicHeightInMinCbsY,
+                                       sps->Log2MinCbSizeY);
+    cu_bits.clear();
+#endif
+
+    if (prevSizes[0] != cb_info.data_size ||
+        prevSizes[1] != deblk_info.data_size ||
+        prevSizes[2] != ctb_info.data_size) {
+      metadata_generation = 0;
+    }
+
 
     // check for memory shortage
 
@@ -483,6 +775,40 @@ de265_image::~de265_image()
 }
 
 
+int64_t de265_image::get_plane_memory() const
+{
+  int64_t size = 0;
+  for (int c=0;c<3;c++) {
+    if (pixels[c]) {
+      size += ((int64_t)get_image_stride(c) * get_height(c)) << bpp_shift[c];
+    }
+  }
+
+  return size;
+}
+
+
+int64_t de265_image::get_metadata_memory() const
+{
+  int64_t size = 0;
+
+  size += intraPredMode.memory_size() + intraPredModeC.memory_size();
+  size += ctb_info.memory_size() + cb_info.memory_size() + tu_info.memory_size();
+  size += pb_index.memory_size() + pb_list.memory_size() + col_motion.memory_size();
+  size += deblk_info.memory_size() + ctb_cost.memory_size();
+#ifdef DE265_BIT_ACCOUNTING
+  size += cu_bits.memory_size();
+#endif
+
+  if (ctb_progress) {
+    size += ctb_info.data_size * sizeof(de265_progress_lock);
+  }
+  size += ctb_metadata_generation.capacity() * sizeof(uint32_t);
+
+  return size;
+}
+
+
 void de265_image::release()
 {
   // free image memory
@@ -511,7 +837,8 @@ void de265_image::release()
   // free slices
 
   for (int i=0;i<slices.size();i++) {
-    delete slices[i];
+    if (decctx) decctx->free_slice_header(slices[i]);
+    else        delete slices[i];
   }
   slices.clear();
 }
@@ -692,6 +1019,13 @@ void de265_image::wait_for_progress(thread_task* task, int ctbAddrRS, int progre
     assert(task!=NULL);
     task->state = thread_task::Blocked;
 
+    int64_t blockStart = stage_timing::now();
+    if (decctx) { decctx->num_threads_blocked++; }
+
+    if (task->trace) {
+      task->trace->add(TASK_EVENT_BLOCK, NULL, ctbAddrRS, progress);
+    }
+
     /* TODO: check whether we are the first blocked task in the list.
        If we are, we have to conceal input errors.
        Simplest concealment: do not block.
@@ -699,18 +1033,63 @@ void de265_image::wait_for_progress(thread_task* task, int ctbAddrRS, int progre
 
     progresslock->wait_for_progress(progress);
     task->state = thread_task::Running;
+
+    if (decctx) {
+      decctx->num_threads_blocked--;
+      decctx->num_blocked_waits++;
+      decctx->blocked_time_ns += stage_timing::now() - blockStart;
+    }
+
+    if (task->trace) {
+      task->trace->add(TASK_EVENT_UNBLOCK);
+    }
+
     thread_unblocks();
   }
 }
 
 
+void picture_stats::add(const picture_stats& s)
+{
+  for (int i=0;i<3;i++) { num_slices[i] += s.num_slices[i]; }
+  for (int i=0;i<4;i++) { num_CUs[i] += s.num_CUs[i]; }
+
+  slice_data_bytes += s.slice_data_bytes;
+  num_PUs_skip  += s.num_PUs_skip;
+  num_PUs_merge += s.num_PUs_merge;
+  num_PUs_AMVP  += s.num_PUs_AMVP;
+  num_PUs_intra += s.num_PUs_intra;
+  QP_area_sum   += s.QP_area_sum;
+  area          += s.area;
+  decode_time_ns += s.decode_time_ns;
+
+#ifdef DE265_BIT_ACCOUNTING
+  for (int i=0;i<de265_num_bit_categories;i++) { bits[i] += s.bits[i]; }
+#endif
+}
+
+
+void de265_image::add_stats(const picture_stats& s)
+{
+  de265_mutex_lock(&mutex);
+  stats.add(s);
+  de265_mutex_unlock(&mutex);
+}
+
+
 void de265_image::wait_for_completion()
 {
+  int64_t waitStart = stage_timing::now();
+
   de265_mutex_lock(&mutex);
   while (nThreadsFinished!=nThreadsTotal) {
     de265_cond_wait(&finished_cond, &mutex);
   }
   de265_mutex_unlock(&mutex);
+
+  if (decctx) {
+    decctx->main_wait_time_ns += stage_timing::now() - waitStart;
+  }
 }
 
 bool de265_image::debug_is_completed() const
@@ -722,14 +1101,20 @@ bool de265_image::debug_is_completed() const
 
 void de265_image::clear_metadata()
 {
-  // TODO: maybe we could avoid the memset by ensuring that all data is written to
-  // during decoding (especially log2CbSize), but it is unlikely to be faster than the memset.
+  // The decoder uses clear_metadata_lazily() instead, which clears each CTB just
+  // before it is decoded.
 
   cb_info.clear();
   //tu_info.clear();  // done on the fly
   ctb_info.clear();
   deblk_info.clear();
 
+  // all CTBs are cleared now
+  ctb_metadata_generation.assign(ctb_info.data_size, 1);
+  metadata_generation = 1;
+
+  motion_compressed = false;
+
   // --- reset CTB progresses ---
 
   for (int i=0;i<ctb_info.data_size;i++) {
@@ -738,25 +1123,252 @@ void de265_image::clear_metadata()
 }
 
 
+void de265_image::clear_metadata_lazily()
+{
+  metadata_generation++;
+
+  if (metadata_generation==1 ||  // freshly allocated storage
+      metadata_generation==0) {  // wrap-around of the counter
+    clear_metadata();
+    return;
+  }
+
+  motion_compressed = false;
+
+  for (int i=0;i<ctb_info.data_size;i++) {
+    ctb_progress[i].reset(CTB_PROGRESS_NONE);
+  }
+}
+
+
+void de265_image::clear_CTB_metadata(int ctbX,int ctbY)
+{
+  int ctbAddrRS = ctbX + ctbY*ctb_info.width_in_units;
+  if (ctb_metadata_generation[ctbAddrRS] == metadata_generation) {
+    return;
+  }
+
+  const int log2CtbSize = sps->Log2CtbSizeY;
+  const int x0 = ctbX << log2CtbSize;
+  const int y0 = ctbY << log2CtbSize;
+
+  cb_info   .clear_block(x0,y0, log2CtbSize);
+  deblk_info.clear_block(x0,y0, log2CtbSize);
+  memset(&ctb_info[ctbAddrRS], 0, sizeof(CTB_info));
+
+  ctb_metadata_generation[ctbAddrRS] = metadata_generation;
+}
+
+
+void de265_image::clear_remaining_CTB_metadata()
+{
+  for (int i=0;i<ctb_info.data_size;i++) {
+    if (ctb_metadata_generation[i] != metadata_generation) {
+      const int ctbX = i % ctb_info.width_in_units;
+      const int ctbY = i / ctb_info.width_in_units;
+
+      clear_CTB_metadata(ctbX,ctbY);
+
+      // The CTB was never decoded. It is MODE_INTER after the clear, so give it
+      // one zero PB instead of the stale motion in the reused arrays.
+
+      if (has_full_motion_info()) {
+        const int log2CtbSize = sps->Log2CtbSizeY;
+
+        PB_info& pb = pb_list[i<<log2PBsPerCtb];
+        memset(&pb, 0, sizeof(PB_info));
+        pb.width  = 1<<log2CtbSize;
+        pb.height = 1<<log2CtbSize;
+
+        ctb_info[i].numPBs = 1;
+        pb_index.clear_block(ctbX<<log2CtbSize, ctbY<<log2CtbSize, log2CtbSize);
+      }
+    }
+  }
+}
+
+
 void de265_image::set_mv_info(int x,int y, int nPbW,int nPbH, const PBMotion& mv)
 {
+  int ctbAddrRS = (x>>pb_log2CtbSize) + (y>>pb_log2CtbSize)*pb_ctbsPerRow;
+  CTB_info& ctb = ctb_info[ctbAddrRS];
+
+  // When decoding, each CTB has at most one PB per 8x4 block. The list can only
+  // run full when PBs are overwritten (encoder mode decision).
+
+  if (unlikely(ctb.numPBs >= (1<<log2PBsPerCtb))) {
+    compact_PB_list(ctbAddrRS, x,y,nPbW,nPbH);
+
+    // Partly overwritten PBs may still fill the list. Their remaining blocks belong
+    // to the CU that is being overwritten, so also drop the 8x8 blocks around this PB.
+
+    if (ctb.numPBs >= (1<<log2PBsPerCtb)) {
+      int x0 = x & ~7;
+      int y0 = y & ~7;
+      compact_PB_list(ctbAddrRS, x0,y0, ((x+nPbW+7)&~7)-x0, ((y+nPbH+7)&~7)-y0);
+    }
+
+    // only possible with 4x4 PBs, which HEVC does not allow: reuse the last entry
+    if (ctb.numPBs >= (1<<log2PBsPerCtb)) {
+      ctb.numPBs = (1<<log2PBsPerCtb)-1;
+    }
+  }
+
+  int idx = ctb.numPBs++;
+
+  PB_info& pb = pb_list[(ctbAddrRS<<log2PBsPerCtb) + idx];
+  pb.motion = mv;
+  pb.x = x & ((1<<pb_log2CtbSize)-1);
+  pb.y = y & ((1<<pb_log2CtbSize)-1);
+  pb.width  = nPbW;
+  pb.height = nPbH;
+
+
+  // set the index in all 4x4 blocks of the PB
+
   int log2PuSize = 2;
 
-  int xPu = x >> log2PuSize;
-  int yPu = y >> log2PuSize;
   int wPu = nPbW >> log2PuSize;
   int hPu = nPbH >> log2PuSize;
 
-  int stride = pb_info.width_in_units;
+  int stride;
+  uint8_t* p = pb_index.get_ptr(x,y,&stride);
 
-  for (int pby=0;pby<hPu;pby++)
+  for (int pby=0;pby<hPu;pby++, p+=stride)
     for (int pbx=0;pbx<wPu;pbx++)
       {
-        pb_info[ xPu+pbx + (yPu+pby)*stride ] = mv;
+        p[pbx] = idx;
       }
 }
 
 
+/* Remove all PBs from the list of the CTB that are not referenced anymore.
+   The area (xExcl;yExcl) (wExcl x hExcl) is about to be overwritten and
+   does not keep its PBs alive.
+ */
+void de265_image::compact_PB_list(int ctbAddrRS, int xExcl,int yExcl,int wExcl,int hExcl)
+{
+  const int log2CtbSize = sps->Log2CtbSizeY;
+  const int mask = (1<<log2PBsPerCtb)-1;
+
+  int x0 = (ctbAddrRS % sps->PicWidthInCtbsY) << log2CtbSize;
+  int y0 = (ctbAddrRS / sps->PicWidthInCtbsY) << log2CtbSize;
+  int x1 = std::min(x0 + (1<<log2CtbSize), pb_index.width_in_units  << 2);
+  int y1 = std::min(y0 + (1<<log2CtbSize), pb_index.height_in_units << 2);
+
+  PB_info* list = &pb_list[ctbAddrRS<<log2PBsPerCtb];
+
+  std::vector<PB_info> oldList(list, list + mask+1);
+  std::vector<int16_t> remap(mask+1, -1);
+  int nPBs = 0;
+
+  for (int y=y0;y<y1;y+=4)
+    for (int x=x0;x<x1;x+=4) {
+      if (x>=xExcl && x<xExcl+wExcl &&
+          y>=yExcl && y<yExcl+hExcl) {
+        continue;
+      }
+
+      uint8_t& idx = pb_index.get(x,y);
+      int oldIdx = idx & mask;
+
+      if (remap[oldIdx] < 0) {
+        remap[oldIdx] = nPBs;
+        list[nPBs] = oldList[oldIdx];
+        nPBs++;
+      }
+
+      idx = remap[oldIdx];
+    }
+
+  ctb_info[ctbAddrRS].numPBs = nPBs;
+}
+
+
+#ifdef DE265_BIT_ACCOUNTING
+const CU_bits* de265_image::find_CU_bits(int x,int y, int* out_x0, int* out_y0) const
+{
+  if (cu_bits.data==NULL ||
+      x<0 || y<0 || x>=sps->pic_width_in_luma_samples || y>=sps->pic_height_in_luma_samples) {
+    return NULL;
+  }
+
+  // CUs are aligned to their size, try each size at its aligned position
+
+  for (int log2CbSize = sps->Log2MinCbSizeY; log2CbSize <= sps->Log2CtbSizeY; log2CbSize++) {
+    int x0 = (x >> log2CbSize) << log2CbSize;
+    int y0 = (y >> log2CbSize) << log2CbSize;
+
+    const CU_bits& cu = cu_bits.get(x0,y0);
+    if (cu.log2CbSize == log2CbSize) {
+      *out_x0 = x0;
+      *out_y0 = y0;
+      return &cu;
+    }
+  }
+
+  return NULL;
+}
+#endif
+
+
+int de265_image::get_num_PBs(int ctbAddrRS) const
+{
+  return std::min((int)ctb_info[ctbAddrRS].numPBs, 1<<log2PBsPerCtb);
+}
+
+
+void de265_image::compress_motion_info(bool keep_full_grid)
+{
+  const int w = col_motion.width_in_units;
+  const int h = col_motion.height_in_units;
+
+  for (int y=0;y<h;y++)
+    for (int x=0;x<w;x++)
+      {
+        PBMotion& col = col_motion.get_unit(x,y);
+
+        if (get_pred_mode(x<<4,y<<4) == MODE_INTRA) {
+          memset(&col, 0, sizeof(PBMotion));
+        }
+        else {
+          col = get_mv_info(x<<4,y<<4);
+        }
+      }
+
+  motion_compressed = true;
+
+  if (!keep_full_grid) {
+    pb_index.release();
+    pb_list.release();
+  }
+}
+
+
+void de265_image::release_decoding_metadata(bool keep_motion_info)
+{
+  intraPredMode.release();
+  intraPredModeC.release();
+  cb_info.release();
+  tu_info.release();
+  deblk_info.release();
+  col_motion.release();
+  motion_compressed = false;
+
+  if (!keep_motion_info) {
+    pb_index.release();
+    pb_list.release();
+  }
+
+  delete[] ctb_progress;
+  ctb_progress = NULL;
+
+  // cb_info and deblk_info have to be cleared completely when they are allocated again
+  std::vector<uint32_t>().swap(ctb_metadata_generation);
+  metadata_generation = 0;
+}
+
+
 bool de265_image::available_zscan(int xCurr,int yCurr, int xN,int yN) const
 {
   if (xN<0 || yN<0) return false;
@@ -30,6 +30,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <memory>
+#include <vector>
+#include <algorithm>
 #ifdef HAVE_STDBOOL_H
 #include <stdbool.h>
 #endif
@@ -44,6 +46,52 @@
 
 struct en265_encoder_context;
 
+
+/* Keeps the sample planes of released pictures for reuse, such that we do not
+   have to go through malloc/free (and fresh pages from the kernel) for every
+   picture. Buffers are matched by their size in bytes, which covers the plane
+   geometry and the bit depth.
+ */
+class image_plane_pool
+{
+ public:
+  image_plane_pool();
+  ~image_plane_pool();
+
+  void set_huge_pages(enum de265_huge_pages mode);
+
+  uint8_t* get_buffer(size_t size);
+  void     release_buffer(uint8_t* mem);
+
+  void get_statistics(de265_plane_pool_statistics*) const;
+
+  int64_t get_unused_bytes() const;  // size of the buffers not used by any picture
+  void    free_unused_buffers();
+
+ private:
+  struct buffer {
+    uint8_t* mem;
+    size_t   size;       // requested size, the key for reuse
+    size_t   alloc_size; // actual size of the allocation
+    bool     mmapped;
+  };
+
+  bool alloc_memory(buffer&, size_t size);
+  void free_memory(buffer&);
+  void free_unused_sizes();
+
+  std::vector<buffer> free_buffers;
+  std::vector<buffer> used_buffers;
+
+  enum de265_huge_pages huge_pages;
+
+  uint64_t hits, misses;
+  int64_t  total_bytes;
+
+  mutable de265_mutex mutex;
+};
+
+
 enum PictureState {
   UnusedForReference,
   UsedForShortTermReference,
@@ -83,14 +131,49 @@ enum PictureState {
 
 class decoder_context;
 
+/* Per-picture array of decoding metadata with one entry for each block of
+   (1<<log2unitSize) x (1<<log2unitSize) samples.
+
+   The array is stored in raster order over the whole picture. When compiled with
+   DE265_TILED_METADATA, it is stored CTB-major (tiled) instead: all units of one CTB
+   are stored consecutively in raster order, and the CTBs follow each other in raster
+   order. The layout is fixed at compile time, such that index() does not have to
+   check for it. (The tiled layout has been measured to be slower so far.)
+
+   Within one CTB, both layouts can be accessed through a pointer and a row stride,
+   see get_ptr().
+ */
 template <class DataUnit> class MetaDataArray
 {
  public:
-  MetaDataArray() { data=NULL; data_size=0; log2unitSize=0; width_in_units=0; height_in_units=0; }
+  MetaDataArray() { data=NULL; data_size=0; log2unitSize=0; width_in_units=0; height_in_units=0;
+                    log2tileUnits=0; tiles_per_row=0; }
   ~MetaDataArray() { free(data); }
 
-  LIBDE265_CHECK_RESULT bool alloc(int w,int h, int _log2unitSize) {
-    int size = w*h;
+  /* With DE265_TILED_METADATA, the array is stored CTB-major when log2CtbSize is nonzero.
+   */
+  LIBDE265_CHECK_RESULT bool alloc(int w,int h, int _log2unitSize, int log2CtbSize=0) {
+#ifdef DE265_TILED_METADATA
+    bool tiled = (log2CtbSize > _log2unitSize);
+#else
+    bool tiled = false;
+#endif
+
+    int size;
+    if (tiled) {
+      log2tileUnits = log2CtbSize - _log2unitSize;
+
+      int tileUnits = 1<<log2tileUnits;
+      tiles_per_row  = (w + tileUnits-1) >> log2tileUnits;
+      int tiles_per_col = (h + tileUnits-1) >> log2tileUnits;
+
+      size = (tiles_per_row * tiles_per_col) << (2*log2tileUnits);
+    }
+    else {
+      log2tileUnits = 0;
+      tiles_per_row = w;
+      size = w*h;
+    }
 
     if (size != data_size) {
       free(data);
@@ -114,83 +197,159 @@ template <class DataUnit> class MetaDataArray
     if (data) memset(data, 0, sizeof(DataUnit) * data_size);
   }
 
-  const DataUnit& get(int x,int y) const {
-    int unitX = x>>log2unitSize;
-    int unitY = y>>log2unitSize;
+  /* Clear the units of the square block at sample position (x0;y0), cropped to the
+     array size. In the CTB-major layout, the block must not cross a CTB boundary.
+   */
+  void clear_block(int x0,int y0, int log2BlkSize) {
+    int unitX = x0>>log2unitSize;
+    int unitY = y0>>log2unitSize;
+    int n = 1<<(log2BlkSize-log2unitSize);
+    int w = std::min(n, width_in_units  - unitX);
+    int h = std::min(n, height_in_units - unitY);
+
+    int stride;
+    DataUnit* p = get_ptr(x0,y0,&stride);
+
+    if (w==stride) {
+      memset(p, 0, sizeof(DataUnit) * w*h);
+    }
+    else {
+      for (int y=0;y<h;y++, p+=stride) {
+        memset(p, 0, sizeof(DataUnit) * w);
+      }
+    }
+  }
+
+  // free the storage, the next alloc() will allocate it again
+  void release() {
+    free(data);
+    data = NULL;
+    data_size = 0;
+  }
 
+  // array index of the unit at (unitX;unitY), in units
+  int index(int unitX,int unitY) const {
     assert(unitX >= 0 && unitX < width_in_units);
     assert(unitY >= 0 && unitY < height_in_units);
 
-    return data[ unitX + unitY*width_in_units ];
-  }
+#ifdef DE265_TILED_METADATA
+    const int mask = (1<<log2tileUnits)-1;
+    int tileIdx = (unitX>>log2tileUnits) + (unitY>>log2tileUnits)*tiles_per_row;
 
-  DataUnit& get(int x,int y) {
-    int unitX = x>>log2unitSize;
-    int unitY = y>>log2unitSize;
+    return (tileIdx << (2*log2tileUnits)) + ((unitY & mask) << log2tileUnits) + (unitX & mask);
+#else
+    return unitX + unitY*width_in_units;
+#endif
+  }
 
-    assert(unitX >= 0 && unitX < width_in_units);
-    assert(unitY >= 0 && unitY < height_in_units);
+  const DataUnit& get(int x,int y) const {
+    return data[ index(x>>log2unitSize, y>>log2unitSize) ];
+  }
 
-    return data[ unitX + unitY*width_in_units ];
+  DataUnit& get(int x,int y) {
+    return data[ index(x>>log2unitSize, y>>log2unitSize) ];
   }
 
   void set(int x,int y, const DataUnit& d) {
-    int unitX = x>>log2unitSize;
-    int unitY = y>>log2unitSize;
+    data[ index(x>>log2unitSize, y>>log2unitSize) ] = d;
+  }
 
-    assert(unitX >= 0 && unitX < width_in_units);
-    assert(unitY >= 0 && unitY < height_in_units);
+  // access in unit coordinates
+  const DataUnit& get_unit(int unitX,int unitY) const { return data[ index(unitX,unitY) ]; }
+  /* */ DataUnit& get_unit(int unitX,int unitY)       { return data[ index(unitX,unitY) ]; }
+
+  // distance between vertically adjacent units of the same CTB
+  int row_stride() const {
+#ifdef DE265_TILED_METADATA
+    if (log2tileUnits) return 1<<log2tileUnits;
+#endif
+    return width_in_units;
+  }
 
-    data[ unitX + unitY*width_in_units ] = d;
+  /* Pointer to the unit at sample position (x;y). The unit below is at ptr+stride, as
+     long as it is in the same CTB. Use this to fill or scan blocks within a CTB.
+   */
+  DataUnit* get_ptr(int x,int y, int* stride) {
+    *stride = row_stride();
+    return &data[ index(x>>log2unitSize, y>>log2unitSize) ];
+  }
+
+  const DataUnit* get_ptr(int x,int y, int* stride) const {
+    *stride = row_stride();
+    return &data[ index(x>>log2unitSize, y>>log2unitSize) ];
   }
 
+  bool is_tiled() const { return log2tileUnits != 0; }
+
+  // raw access to the storage, the order depends on the layout
   DataUnit& operator[](int idx) { return data[idx]; }
   const DataUnit& operator[](int idx) const { return data[idx]; }
 
   int size() const { return data_size; }
 
+  size_t memory_size() const { return data_size * sizeof(DataUnit); }
+
   // private:
   DataUnit* data;
   int data_size;
   int log2unitSize;
   int width_in_units;
   int height_in_units;
+
+ private:
+  int  log2tileUnits; // CTB size in units, 0 in raster order
+  int  tiles_per_row;
 };
 
 #define SET_CB_BLK(x,y,log2BlkWidth,  Field,value)              \
-  int cbX = x >> cb_info.log2unitSize; \
-  int cbY = y >> cb_info.log2unitSize; \
+  int cbStride;                                                     \
+  CB_ref_info* cbPtr = cb_info.get_ptr(x,y,&cbStride);             \
   int width = 1 << (log2BlkWidth - cb_info.log2unitSize);           \
-  for (int cby=cbY;cby<cbY+width;cby++)                             \
-    for (int cbx=cbX;cbx<cbX+width;cbx++)                           \
+  for (int cby=0;cby<width;cby++, cbPtr+=cbStride)                  \
+    for (int cbx=0;cbx<width;cbx++)                                 \
       {                                                             \
-        cb_info[ cbx + cby*cb_info.width_in_units ].Field = value;  \
+        cbPtr[cbx].Field = value;                                   \
       }
 
 #define CLEAR_TB_BLK(x,y,log2BlkWidth)              \
-  int tuX = x >> tu_info.log2unitSize; \
-  int tuY = y >> tu_info.log2unitSize; \
+  int tuStride;                                                     \
+  uint8_t* tuPtr = tu_info.get_ptr(x,y,&tuStride);                  \
   int width = 1 << (log2BlkWidth - tu_info.log2unitSize);           \
-  for (int tuy=tuY;tuy<tuY+width;tuy++)                             \
-    for (int tux=tuX;tux<tuX+width;tux++)                           \
+  for (int tuy=0;tuy<width;tuy++, tuPtr+=tuStride)                  \
+    for (int tux=0;tux<width;tux++)                                 \
       {                                                             \
-        tu_info[ tux + tuy*tu_info.width_in_units ] = 0;  \
+        tuPtr[tux] = 0;                                             \
       }
 
 
+/* Pictures can have more than 65535 CTBs (e.g. 8K with 16x16 CTBs), hence the
+   32 bit addresses. The remaining fields are packed into 2 bytes, giving 28 bytes
+   in total. Only the thread decoding or deblocking a CTB writes its flags.
+ */
 typedef struct {
-  uint16_t SliceAddrRS;
-  uint16_t SliceHeaderIndex; // index into array to slice header for this CTB
+  uint32_t SliceAddrRS;
+  uint32_t SliceHeaderIndex; // index into array to slice header for this CTB
 
   sao_info saoInfo;
-  bool     deblock;         // this CTB has to be deblocked
+
+  uint16_t numPBs  : 14;    // number of entries in this CTB's part of the PB list
+  uint16_t deblock : 1;     // this CTB has to be deblocked
 
   // The following flag helps to quickly check whether we have to
   // check all conditions in the SAO filter or whether we can skip them.
-  bool     has_pcm_or_cu_transquant_bypass; // pcm or transquant_bypass is used in this CTB
+  uint16_t has_pcm_or_cu_transquant_bypass : 1; // pcm or transquant_bypass is used in this CTB
 } CTB_info;
 
 
+// One inter prediction block, stored once in the PB list of its CTB.
+typedef struct {
+  PBMotion motion;
+
+  uint8_t  x,y;            // position in luma samples, relative to the CTB
+  uint8_t  width,height;   // [4;64]
+} PB_info;
+
+
 typedef struct {
   uint8_t log2CbSize : 3;   /* [0;6] (1<<log2CbSize) = 64
                                This is only set in the top-left corner of the CB.
@@ -217,6 +376,42 @@ typedef struct {
 } CB_ref_info;
 
 
+/* Counters of one picture (see de265_picture_stats). Each thread_context counts
+   into its own object, which is added to the picture when the thread finishes
+   its part of the slice segment.
+ */
+struct picture_stats
+{
+  picture_stats() { clear(); }
+
+  void clear() { memset(this, 0, sizeof(picture_stats)); }
+  void add(const picture_stats& s);
+
+  uint32_t num_slices[3];     // by slice_type (B, P, I)
+  uint64_t slice_data_bytes;
+  uint32_t num_CUs[4];        // 8x8 to 64x64
+  uint32_t num_PUs_skip;
+  uint32_t num_PUs_merge;
+  uint32_t num_PUs_AMVP;
+  uint32_t num_PUs_intra;
+  uint64_t QP_area_sum;       // sum of the CU luma QPs, weighted by their area in 8x8 units
+  uint64_t area;              // in 8x8 units
+  int64_t  decode_time_ns;
+
+#ifdef DE265_BIT_ACCOUNTING
+  uint64_t bits[de265_num_bit_categories];  // fixed-point, see CABAC_BIT_SHIFT
+#endif
+};
+
+
+#ifdef DE265_BIT_ACCOUNTING
+// Bits of one CU, stored at its top-left position.
+struct CU_bits
+{
+  uint32_t bits[de265_num_bit_categories];  // fixed-point, see CABAC_BIT_SHIFT
+  uint8_t  log2CbSize;                      // 0 if there is no CU at this position
+};
+#endif
 
 
 struct de265_image {
@@ -236,6 +431,9 @@ struct de265_image {
 
   bool is_allocated() const { return pixels[0] != NULL; }
 
+  int64_t get_plane_memory() const;     // sample data of all planes
+  int64_t get_metadata_memory() const;  // block metadata and CTB progress locks
+
   void release();
 
   void set_headers(std::shared_ptr<video_parameter_set> _vps,
@@ -321,7 +519,9 @@ struct de265_image {
     return get_bit_depth(cIdx)>8;
   }
 
-  bool can_be_released() const { return PicOutputFlag==false && PicState==UnusedForReference; }
+  bool can_be_released() const {
+    return PicOutputFlag==false && PicState==UnusedForReference && !hash_check_pending;
+  }
 
 
   void add_slice_segment_header(slice_segment_header* shdr) {
@@ -411,11 +611,26 @@ private:
 
   MetaDataArray<CTB_info>    ctb_info;
   MetaDataArray<CB_ref_info> cb_info;
-  MetaDataArray<PBMotion>    pb_info;
+  MetaDataArray<uint8_t>     pb_index;  // 4x4 grid, index into the PB list of the CTB
+  MetaDataArray<PB_info>     pb_list;   // (1<<log2PBsPerCtb) entries for each CTB, one per 8x4 block
+  int                        log2PBsPerCtb;
+  int                        pb_log2CtbSize;  // copies of the SPS values for get_mv_info()
+  int                        pb_ctbsPerRow;
+  MetaDataArray<PBMotion>    col_motion;  // 16x16 grid for TMVP, see compress_motion_info()
   MetaDataArray<uint8_t>     intraPredMode;
   MetaDataArray<uint8_t>     intraPredModeC;
   MetaDataArray<uint8_t>     tu_info;
   MetaDataArray<uint8_t>     deblk_info;
+  MetaDataArray<de265_ctb_cost> ctb_cost;  // only with decctx->param_ctb_cost, kept after decoding
+#ifdef DE265_BIT_ACCOUNTING
+  MetaDataArray<CU_bits>     cu_bits;   // kept after decoding
+#endif
+
+  bool motion_compressed;  // col_motion is valid
+
+  // CTBs whose entry equals metadata_generation have been cleared for the current picture
+  std::vector<uint32_t> ctb_metadata_generation;
+  uint32_t metadata_generation;  // 0: storage is uninitialized
 
 public:
   // --- meta information ---
@@ -439,6 +654,12 @@ public:
 
   nal_header nal_hdr;
 
+  picture_stats stats;  // the totals are complete when the picture is output
+
+  bool hash_check_pending;  // worker threads are still checking the SEI hash (see decoder_context)
+
+  void add_stats(const picture_stats&);  // thread-safe
+
   // --- multi core ---
 
   de265_progress_lock* ctb_progress; // ctb_info_size
@@ -484,6 +705,15 @@ public:
   */
   void clear_metadata();
 
+  /* Like clear_metadata(), but the CTB data is not cleared here. Instead,
+     clear_CTB_metadata() has to be called before a CTB is decoded and
+     clear_remaining_CTB_metadata() after decoding, for the CTBs that
+     were not decoded (missing slices).
+  */
+  void clear_metadata_lazily();
+  void clear_CTB_metadata(int ctbX,int ctbY);
+  void clear_remaining_CTB_metadata();
+
 
   // --- CB metadata access ---
 
@@ -554,7 +784,7 @@ public:
   // coordinates in CB units
   int  get_log2CbSize_cbUnits(int xCb, int yCb) const
   {
-    return (enum PredMode)cb_info[ xCb + yCb*cb_info.width_in_units ].log2CbSize;
+    return (enum PredMode)cb_info.get_unit(xCb,yCb).log2CbSize;
   }
 
   void set_PartMode(int x,int y, enum PartMode mode)
@@ -606,14 +836,15 @@ public:
 
   void set_nonzero_coefficient(int x,int y, int log2TrafoSize)
   {
-    const int tuX = x >> tu_info.log2unitSize;
-    const int tuY = y >> tu_info.log2unitSize;
     const int width = 1 << (log2TrafoSize - tu_info.log2unitSize);
 
-    for (int tuy=tuY;tuy<tuY+width;tuy++)
-      for (int tux=tuX;tux<tuX+width;tux++)
+    int stride;
+    uint8_t* p = tu_info.get_ptr(x,y,&stride);
+
+    for (int tuy=0;tuy<width;tuy++, p+=stride)
+      for (int tux=0;tux<width;tux++)
         {
-          tu_info[ tux + tuy*tu_info.width_in_units ] |= TU_FLAG_NONZERO_COEFF;
+          p[tux] |= TU_FLAG_NONZERO_COEFF;
         }
   }
 
@@ -630,34 +861,17 @@ public:
     return (enum IntraPredMode)intraPredMode.get(x,y);
   }
 
-  enum IntraPredMode get_IntraPredMode_atIndex(int idx) const
-  {
-    return (enum IntraPredMode)intraPredMode[idx];
-  }
-
-  void set_IntraPredMode(int PUidx,int log2blkSize, enum IntraPredMode mode)
-  {
-    int pbSize = 1<<(log2blkSize - intraPredMode.log2unitSize);
-
-    for (int y=0;y<pbSize;y++)
-      for (int x=0;x<pbSize;x++)
-        intraPredMode[PUidx + x + y*intraPredMode.width_in_units] = mode;
-  }
-
   void set_IntraPredMode(int x0,int y0,int log2blkSize,
                          enum IntraPredMode mode)
   {
     int pbSize = 1<<(log2blkSize - intraPredMode.log2unitSize);
-    int PUidx  = (x0>>sps->Log2MinPUSize) + (y0>>sps->Log2MinPUSize)*sps->PicWidthInMinPUs;
 
-    for (int y=0;y<pbSize;y++)
-      for (int x=0;x<pbSize;x++) {
-        assert(x < sps->PicWidthInMinPUs);
-        assert(y < sps->PicHeightInMinPUs);
+    int stride;
+    uint8_t* p = intraPredMode.get_ptr(x0,y0,&stride);
 
-        int idx = PUidx + x + y*intraPredMode.width_in_units;
-        assert(idx<intraPredMode.data_size);
-        intraPredMode[idx] = mode;
+    for (int y=0;y<pbSize;y++, p+=stride)
+      for (int x=0;x<pbSize;x++) {
+        p[x] = mode;
       }
   }
 
@@ -678,17 +892,14 @@ public:
     uint8_t combinedValue = mode;
     if (is_mode4) combinedValue |= 0x80;
 
-    int pbSize = 1<<(log2blkSize - intraPredMode.log2unitSize);
-    int PUidx  = (x0>>sps->Log2MinPUSize) + (y0>>sps->Log2MinPUSize)*sps->PicWidthInMinPUs;
+    int pbSize = 1<<(log2blkSize - intraPredModeC.log2unitSize);
 
-    for (int y=0;y<pbSize;y++)
-      for (int x=0;x<pbSize;x++) {
-        assert(x<sps->PicWidthInMinPUs);
-        assert(y<sps->PicHeightInMinPUs);
+    int stride;
+    uint8_t* p = intraPredModeC.get_ptr(x0,y0,&stride);
 
-        int idx = PUidx + x + y*intraPredModeC.width_in_units;
-        assert(idx<intraPredModeC.data_size);
-        intraPredModeC[idx] = combinedValue;
+    for (int y=0;y<pbSize;y++, p+=stride)
+      for (int x=0;x<pbSize;x++) {
+        p[x] = combinedValue;
       }
   }
 
@@ -821,7 +1032,7 @@ public:
 
     if (xd<deblk_info.width_in_units &&
         yd<deblk_info.height_in_units) {
-      deblk_info[xd + yd*deblk_info.width_in_units] |= flags;
+      deblk_info.get_unit(xd,yd) |= flags;
     }
   }
 
@@ -830,34 +1041,98 @@ public:
     const int xd = x0/4;
     const int yd = y0/4;
 
-    return deblk_info[xd + yd*deblk_info.width_in_units];
+    return deblk_info.get_unit(xd,yd);
   }
 
   void    set_deblk_bS(int x0,int y0, uint8_t bS)
   {
-    uint8_t* data = &deblk_info[x0/4 + y0/4*deblk_info.width_in_units];
+    uint8_t* data = &deblk_info.get_unit(x0/4,y0/4);
     *data &= ~DEBLOCK_BS_MASK;
     *data |= bS;
   }
 
   uint8_t get_deblk_bS(int x0,int y0) const
   {
-    return deblk_info[x0/4 + y0/4*deblk_info.width_in_units] & DEBLOCK_BS_MASK;
+    return deblk_info.get_unit(x0/4,y0/4) & DEBLOCK_BS_MASK;
   }
 
 
   // --- PB metadata access ---
 
+  /* The motion of each PB is stored only once, in a list per CTB. The 4x4 grid
+     holds the index of the covering PB within the list of its CTB.
+     Reading a position that was never set returns an arbitrary PB_info, but
+     never reads out of bounds.
+   */
   const PBMotion& get_mv_info(int x,int y) const
   {
-    return pb_info.get(x,y);
+    int ctbAddrRS = (x>>pb_log2CtbSize) + (y>>pb_log2CtbSize)*pb_ctbsPerRow;
+    int idx = pb_index.get(x,y) & ((1<<log2PBsPerCtb)-1);
+
+    return pb_list[(ctbAddrRS<<log2PBsPerCtb) + idx].motion;
   }
 
   void set_mv_info(int x,int y, int nPbW,int nPbH, const PBMotion& mv);
 
+  /* Number of PBs in the CTB and the list of them, in decoding order.
+     Only valid until compress_motion_info() frees the full motion information.
+   */
+  int get_num_PBs(int ctbAddrRS) const;
+  const PB_info* get_PB_list(int ctbAddrRS) const { return &pb_list[ctbAddrRS<<log2PBsPerCtb]; }
+
+  bool has_full_motion_info() const { return pb_list.data != NULL; }
+
+
+  // --- CTB decoding cost (DE265_DECODER_PARAM_CTB_COST) ---
+
+  bool has_ctb_costs() const { return ctb_cost.data != NULL; }
+
+  de265_ctb_cost* get_ctb_cost_ptr(int ctbAddrRS) {
+    return ctb_cost.data ? &ctb_cost[ctbAddrRS] : NULL;
+  }
+
+  const de265_ctb_cost& get_ctb_cost(int ctbAddrRS) const { return ctb_cost[ctbAddrRS]; }
+
+
+#ifdef DE265_BIT_ACCOUNTING
+  // --- bit accounting ---
+
+  CU_bits& get_CU_bits(int x0,int y0) { return cu_bits.get(x0,y0); }
+
+  // The CU covering (x,y) or NULL if none has been decoded there.
+  const CU_bits* find_CU_bits(int x,int y, int* out_x0, int* out_y0) const;
+#endif
+
+  /* Store the motion of the finished picture subsampled to the 16x16 grid that
+     is used for collocated (TMVP) motion vectors (8.5.3.2.8). Intra blocks get
+     an entry with both predFlags cleared. Unless 'keep_full_grid' is set, the
+     PB lists are freed afterwards and get_mv_info() must not be used anymore.
+   */
+  void compress_motion_info(bool keep_full_grid);
+
+  /* Free the metadata that is only needed while the picture is decoded or used as a
+     reference: the intra, transform and deblocking arrays, the TMVP motion grid and
+     the CTB progress locks. The sample planes and the CTB info stay, and so do the
+     PB lists if 'keep_motion_info' is set. alloc_image() allocates everything again.
+   */
+  void release_decoding_metadata(bool keep_motion_info);
+
+  bool has_decoding_metadata() const { return ctb_progress != NULL; }
+
+  bool has_compressed_motion_info() const { return motion_compressed; }
+
+  // only valid after compress_motion_info(), (x;y) in luma samples
+  const PBMotion& get_compressed_mv_info(int x,int y) const
+  {
+    return col_motion.get_unit(x>>4, y>>4);
+  }
+
   // --- value logging ---
 
   void printBlk(int x0,int y0, int cIdx, int log2BlkSize);
+
+private:
+  void compact_PB_list(int ctbAddrRS, int xExcl,int yExcl,int wExcl,int hExcl);
 };
 
 
@@ -74,7 +74,7 @@ void fillIntraPredModeCandidates(enum IntraPredMode candModeList[3],
 }
 
 
-void fillIntraPredModeCandidates(enum IntraPredMode candModeList[3], int x,int y, int PUidx,
+void fillIntraPredModeCandidates(enum IntraPredMode candModeList[3], int x,int y,
                                  bool availableA, // left
                                  bool availableB, // top
                                  const de265_image* img)
@@ -92,7 +92,7 @@ void fillIntraPredModeCandidates(enum IntraPredMode candModeList[3], int x,int y
     candIntraPredModeA=INTRA_DC;
  }
   else {
-    candIntraPredModeA = img->get_IntraPredMode_atIndex(PUidx-1);
+    candIntraPredModeA = img->get_IntraPredMode(x-1,y);
   }
 
   // block above
@@ -108,7 +108,7 @@ void fillIntraPredModeCandidates(enum IntraPredMode candModeList[3], int x,int y
     candIntraPredModeB=INTRA_DC;
   }
   else {
-    candIntraPredModeB = img->get_IntraPredMode_atIndex(PUidx-sps->PicWidthInMinPUs);
+    candIntraPredModeB = img->get_IntraPredMode(x,y-1);
   }
 
 
@@ -281,21 +281,24 @@ void decode_intra_prediction_internal(de265_image* img,
   pixel_t  border_pixels_mem[4*MAX_INTRA_PRED_BLOCK_SIZE+1];
   pixel_t* border_pixels = &border_pixels_mem[2*MAX_INTRA_PRED_BLOCK_SIZE];
 
+  const acceleration_functions* acceleration = &img->decctx->acceleration;
+
   fill_border_samples(img, xB0,yB0, nT, cIdx, border_pixels);
 
   if (img->get_sps().range_extension.intra_smoothing_disabled_flag == 0 &&
       (cIdx==0 || img->get_sps().ChromaArrayType==CHROMA_444))
     {
-      intra_prediction_sample_filtering(img->get_sps(), border_pixels, nT, cIdx, intraPredMode);
+      intra_prediction_sample_filtering(img->get_sps(), border_pixels, nT, cIdx, intraPredMode,
+                                        acceleration);
     }
 
 
   switch (intraPredMode) {
   case INTRA_PLANAR:
-    intra_prediction_planar(dst,dstStride, nT,cIdx, border_pixels);
+    acceleration->intra_prediction_planar<pixel_t>(dst,dstStride, nT,cIdx, border_pixels);
     break;
   case INTRA_DC:
-    intra_prediction_DC(dst,dstStride, nT,cIdx, border_pixels);
+    acceleration->intra_prediction_DC<pixel_t>(dst,dstStride, nT,cIdx, border_pixels);
     break;
   default:
     {
@@ -304,8 +307,9 @@ void decode_intra_prediction_internal(de265_image* img,
         (img->get_sps().range_extension.implicit_rdpcm_enabled_flag &&
          img->get_cu_transquant_bypass(xB0,yB0));
 
-      intra_prediction_angular(dst,dstStride, bit_depth,disableIntraBoundaryFilter,
-                               xB0,yB0,intraPredMode,nT,cIdx, border_pixels);
+      acceleration->intra_prediction_angular<pixel_t>(dst,dstStride, bit_depth,
+                                                      disableIntraBoundaryFilter,
+                                                      intraPredMode,nT,cIdx, border_pixels);
     }
     break;
   }
@@ -27,26 +27,15 @@ extern const int intraPredAngle_table[1+34];
 
 
 /* Fill the three intra-pred-mode candidates into candModeList.
-   Block position is (x,y) and you also have to give the PUidx for this
-   block (which is (x>>Log2MinPUSize) + (y>>Log2MinPUSize)*PicWidthInMinPUs).
+   Block position is (x,y).
    availableA/B is the output of check_CTB_available().
  */
 void fillIntraPredModeCandidates(enum IntraPredMode candModeList[3],
-                                 int x,int y, int PUidx,
+                                 int x,int y,
                                  bool availableA, // left
                                  bool availableB, // top
                                  const de265_image* img);
 
-
-inline void fillIntraPredModeCandidates(enum IntraPredMode candModeList[3], int x,int y,
-                                 bool availableA, // left
-                                 bool availableB, // top
-                                 const de265_image* img)
-{
-  int PUidx = img->get_sps().getPUIndexRS(x,y);
-  fillIntraPredModeCandidates(candModeList, x,y, PUidx, availableA,availableB, img);
-}
-
 void fillIntraPredModeCandidates(enum IntraPredMode candModeList[3],
                                  enum IntraPredMode candIntraPredModeA,
                                  enum IntraPredMode candIntraPredModeB);
@@ -181,12 +170,27 @@ void print_border(pixel_t* data, uint8_t* available, int nT)
 #endif
 
 
+// [1 2 1] smoothing of the reference samples, including the unfiltered end points
+template <class pixel_t>
+void intra_prediction_sample_filtering_121(pixel_t* pF, const pixel_t* p, int nT)
+{
+  pF[-2*nT] = p[-2*nT];
+  pF[ 2*nT] = p[ 2*nT];
+
+  for (int i=-(2*nT-1) ; i<=2*nT-1 ; i++)
+    {
+      pF[i] = (p[i+1] + 2*p[i] + p[i-1] + 2) >> 2;
+    }
+}
+
+
 // (8.4.4.2.3)
 template <class pixel_t>
 void intra_prediction_sample_filtering(const seq_parameter_set& sps,
                                        pixel_t* p,
                                        int nT, int cIdx,
-                                       enum IntraPredMode intraPredMode)
+                                       enum IntraPredMode intraPredMode,
+                                       const acceleration_functions* accel = NULL)
 {
   int filterFlag;
 
@@ -213,7 +217,8 @@ void intra_prediction_sample_filtering(const seq_parameter_set& sps,
   }
 
 
-  if (filterFlag) {
+  // filterFlag is never set for nT==64, the explicit bound keeps pF_mem provably large enough
+  if (filterFlag && nT<=32) {
     int biIntFlag = (sps.strong_intra_smoothing_enable_flag &&
                      cIdx==0 &&
                      nT==32 &&
@@ -233,14 +238,10 @@ void intra_prediction_sample_filtering(const seq_parameter_set& sps,
         pF[-i] = p[0] + ((i*(p[-64]-p[0])+32)>>6);
         pF[ i] = p[0] + ((i*(p[ 64]-p[0])+32)>>6);
       }
+    } else if (accel) {
+      accel->intra_prediction_sample_filtering<pixel_t>(pF, p, nT);
     } else {
-      pF[-2*nT] = p[-2*nT];
-      pF[ 2*nT] = p[ 2*nT];
-
-      for (int i=-(2*nT-1) ; i<=2*nT-1 ; i++)
-        {
-          pF[i] = (p[i+1] + 2*p[i] + p[i-1] + 2) >> 2;
-        }
+      intra_prediction_sample_filtering_121(pF, p, nT);
     }
 
 
@@ -262,7 +263,7 @@ void intra_prediction_sample_filtering(const seq_parameter_set& sps,
 template <class pixel_t>
 void intra_prediction_planar(pixel_t* dst, int dstStride,
                              int nT,int cIdx,
-                             pixel_t* border)
+                             const pixel_t* border)
 {
   int Log2_nT = Log2(nT);
 
@@ -289,7 +290,7 @@ void intra_prediction_planar(pixel_t* dst, int dstStride,
 template <class pixel_t>
 void intra_prediction_DC(pixel_t* dst, int dstStride,
                          int nT,int cIdx,
-                         pixel_t* border)
+                         const pixel_t* border)
 {
   int Log2_nT = Log2(nT);
 
@@ -334,7 +335,7 @@ void intra_prediction_angular(pixel_t* dst, int dstStride,
                               int xB0,int yB0,
                               enum IntraPredMode intraPredMode,
                               int nT,int cIdx,
-                              pixel_t* border)
+                              const pixel_t* border)
 {
   pixel_t  ref_mem[4*MAX_INTRA_PRED_BLOCK_SIZE+1]; // TODO: what is the required range here ?
   pixel_t* ref=&ref_mem[2*MAX_INTRA_PRED_BLOCK_SIZE];
@@ -1100,12 +1100,25 @@ void derive_collocated_motion_vectors(base_context* ctx,
     return;
   }
 
-  enum PredMode predMode = colImg->get_pred_mode(xColPb,yColPb);
+  // Finished pictures only keep the motion on the 16x16 grid, with intra blocks
+  // marked by cleared predFlags. (xColPb;yColPb) is always on that grid.
+
+  const PBMotion* colMotion;
+  bool colIntra;
+
+  if (colImg->has_compressed_motion_info()) {
+    colMotion = &colImg->get_compressed_mv_info(xColPb,yColPb);
+    colIntra  = (colMotion->predFlag[0]==0 && colMotion->predFlag[1]==0);
+  }
+  else {
+    colMotion = &colImg->get_mv_info(xColPb,yColPb);
+    colIntra  = (colImg->get_pred_mode(xColPb,yColPb) == MODE_INTRA);
+  }
 
 
   // collocated block is Intra -> no collocated MV
 
-  if (predMode == MODE_INTRA) {
+  if (colIntra) {
     out_mvLXCol->x = 0;
     out_mvLXCol->y = 0;
     *out_availableFlagLXCol = 0;
@@ -1131,7 +1144,7 @@ void derive_collocated_motion_vectors(base_context* ctx,
 
   // get the collocated MV
 
-  const PBMotion& mvi = colImg->get_mv_info(xColPb,yColPb);
+  const PBMotion& mvi = *colMotion;
   int listCol;
   int refIdxCol;
   MotionVector mvCol;
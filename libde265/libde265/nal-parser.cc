@@ -39,6 +39,7 @@ NAL_unit::NAL_unit()
   nal_data = NULL;
   data_size = 0;
   capacity = 0;
+  padded = false;
 }
 
 NAL_unit::~NAL_unit()
@@ -54,14 +55,15 @@ void NAL_unit::clear()
 
   // set size to zero but keep memory
   data_size = 0;
+  padded = false;
 
   skipped_bytes.clear();
 }
 
 LIBDE265_CHECK_RESULT bool NAL_unit::resize(int new_size)
 {
-  if (capacity < new_size) {
-    unsigned char* newbuffer = (unsigned char*)malloc(new_size);
+  if (capacity < new_size || nal_data == NULL) {
+    unsigned char* newbuffer = (unsigned char*)malloc(new_size + DE265_NAL_PADDING_SIZE);
     if (newbuffer == NULL) {
       return false;
     }
@@ -84,6 +86,7 @@ LIBDE265_CHECK_RESULT bool NAL_unit::append(const unsigned char* in_data, int n)
   }
   memcpy(nal_data + data_size, in_data, n);
   data_size += n;
+  padded = false;
   return true;
 }
 
@@ -94,9 +97,18 @@ bool LIBDE265_CHECK_RESULT NAL_unit::set_data(const unsigned char* in_data, int
   }
   memcpy(nal_data, in_data, n);
   data_size = n;
+  padded = false;
   return true;
 }
 
+void NAL_unit::pad()
+{
+  assert(nal_data != NULL);
+
+  memset(nal_data + data_size, 0, DE265_NAL_PADDING_SIZE);
+  padded = true;
+}
+
 void NAL_unit::insert_skipped_byte(int pos)
 {
   skipped_bytes.push_back(pos);
@@ -224,6 +236,30 @@ void NAL_Parser::free_NAL_unit(NAL_unit* nal)
   }
 }
 
+int64_t NAL_Parser::get_memory_usage() const
+{
+  int64_t size = nBytes_in_NAL_queue + NAL_queue.size()*sizeof(NAL_unit);
+
+  if (pending_input_NAL) {
+    size += pending_input_NAL->allocated_size() + sizeof(NAL_unit);
+  }
+
+  for (size_t i=0;i<NAL_free_list.size();i++) {
+    size += NAL_free_list[i]->allocated_size() + sizeof(NAL_unit);
+  }
+
+  return size;
+}
+
+void NAL_Parser::free_unused_NAL_units()
+{
+  for (size_t i=0;i<NAL_free_list.size();i++) {
+    delete NAL_free_list[i];
+  }
+
+  NAL_free_list.clear();
+}
+
 NAL_unit* NAL_Parser::pop_from_NAL_queue()
 {
   if (NAL_queue.empty()) {
@@ -241,6 +277,8 @@ NAL_unit* NAL_Parser::pop_from_NAL_queue()
 
 void NAL_Parser::push_to_NAL_queue(NAL_unit* nal)
 {
+  nal->pad();
+
   NAL_queue.push(nal);
   nBytes_in_NAL_queue += nal->size();
 }
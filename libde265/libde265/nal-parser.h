@@ -32,6 +32,9 @@
 #define DE265_NAL_FREE_LIST_SIZE 16
 #define DE265_SKIPPED_BYTES_INITIAL_SIZE 16
 
+// Zero bytes after the end of the NAL data, allows the CABAC decoder to do wide refills.
+#define DE265_NAL_PADDING_SIZE 16
+
 
 class NAL_unit {
  public:
@@ -53,10 +56,17 @@ class NAL_unit {
   LIBDE265_CHECK_RESULT bool set_data(const unsigned char* data, int n);
 
   int size() const { return data_size; }
-  void set_size(int s) { data_size=s; }
+  int allocated_size() const { return capacity; }
+  void set_size(int s) { data_size=s; padded=false; }
   unsigned char* data() { return nal_data; }
   const unsigned char* data() const { return nal_data; }
 
+  /* Zero the DE265_NAL_PADDING_SIZE bytes after the data. Any later change of
+     the data invalidates the padding.
+   */
+  void pad();
+  bool is_padded() const { return padded; }
+
 
   // --- skipped stuffing bytes ---
 
@@ -78,7 +88,8 @@ class NAL_unit {
  private:
   unsigned char* nal_data;
   int data_size;
-  int capacity;
+  int capacity;   // without the padding
+  bool padded;
 
   std::vector<int> skipped_bytes; // up to position[x], there were 'x' skipped bytes
 };
@@ -120,6 +131,12 @@ class NAL_Parser
 
   void free_NAL_unit(NAL_unit*);
 
+  // memory of the NALs in the input queue and in the free-list
+  int64_t get_memory_usage() const;
+
+  // delete the NALs in the free-list
+  void free_unused_NAL_units();
+
 
   int get_NAL_queue_length() const { return NAL_queue.size(); }
   bool is_end_of_stream() const { return end_of_stream; }
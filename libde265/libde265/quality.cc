@@ -20,17 +20,22 @@
 
 #include "quality.h"
 #include <math.h>
+#include <vector>
 
+// SSE2 is always available on x86-64, no runtime check is needed for these kernels.
+#if defined(__SSE2__) || defined(_M_X64)
+#define QUALITY_SSE2 1
+#include <emmintrin.h>
+#endif
 
-uint32_t SSD(const uint8_t* img, int imgStride,
-             const uint8_t* ref, int refStride,
-             int width, int height)
+
+#if !QUALITY_SSE2
+static uint32_t SSD_scalar(const uint8_t* iPtr, int imgStride,
+                           const uint8_t* rPtr, int refStride,
+                           int width, int height)
 {
   uint32_t sum=0;
 
-  const uint8_t* iPtr = img;
-  const uint8_t* rPtr = ref;
-
   for (int y=0;y<height;y++) {
     for (int x=0;x<width;x++) {
       int diff = iPtr[x] - rPtr[x];
@@ -43,16 +48,78 @@ uint32_t SSD(const uint8_t* img, int imgStride,
 
   return sum;
 }
+#endif
 
 
-uint32_t SAD(const uint8_t* img, int imgStride,
+#if QUALITY_SSE2
+static uint32_t SSD_sse2(const uint8_t* iPtr, int imgStride,
+                         const uint8_t* rPtr, int refStride,
+                         int width, int height)
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i acc = zero;
+  uint32_t sum=0;
+
+  for (int y=0;y<height;y++) {
+    int x=0;
+
+    for (;x+16<=width;x+=16) {
+      __m128i a = _mm_loadu_si128((const __m128i*)(iPtr+x));
+      __m128i b = _mm_loadu_si128((const __m128i*)(rPtr+x));
+
+      __m128i dlo = _mm_sub_epi16(_mm_unpacklo_epi8(a,zero), _mm_unpacklo_epi8(b,zero));
+      __m128i dhi = _mm_sub_epi16(_mm_unpackhi_epi8(a,zero), _mm_unpackhi_epi8(b,zero));
+
+      acc = _mm_add_epi32(acc, _mm_madd_epi16(dlo,dlo));
+      acc = _mm_add_epi32(acc, _mm_madd_epi16(dhi,dhi));
+    }
+
+    if (x+8<=width) {
+      __m128i a = _mm_loadl_epi64((const __m128i*)(iPtr+x));
+      __m128i b = _mm_loadl_epi64((const __m128i*)(rPtr+x));
+
+      __m128i d = _mm_sub_epi16(_mm_unpacklo_epi8(a,zero), _mm_unpacklo_epi8(b,zero));
+      acc = _mm_add_epi32(acc, _mm_madd_epi16(d,d));
+      x+=8;
+    }
+
+    for (;x<width;x++) {
+      int diff = iPtr[x] - rPtr[x];
+      sum += diff*diff;
+    }
+
+    iPtr += imgStride;
+    rPtr += refStride;
+  }
+
+  // wraps around like the scalar code
+
+  acc = _mm_add_epi32(acc, _mm_srli_si128(acc,8));
+  acc = _mm_add_epi32(acc, _mm_srli_si128(acc,4));
+
+  return sum + (uint32_t)_mm_cvtsi128_si32(acc);
+}
+#endif
+
+
+uint32_t SSD(const uint8_t* img, int imgStride,
              const uint8_t* ref, int refStride,
              int width, int height)
 {
-  uint32_t sum=0;
+#if QUALITY_SSE2
+  return SSD_sse2(img,imgStride, ref,refStride, width,height);
+#else
+  return SSD_scalar(img,imgStride, ref,refStride, width,height);
+#endif
+}
 
-  const uint8_t* iPtr = img;
-  const uint8_t* rPtr = ref;
+
+#if !QUALITY_SSE2
+static uint32_t SAD_scalar(const uint8_t* iPtr, int imgStride,
+                           const uint8_t* rPtr, int refStride,
+                           int width, int height)
+{
+  uint32_t sum=0;
 
   for (int y=0;y<height;y++) {
     for (int x=0;x<width;x++) {
@@ -66,6 +133,59 @@ uint32_t SAD(const uint8_t* img, int imgStride,
 
   return sum;
 }
+#endif
+
+
+#if QUALITY_SSE2
+static uint32_t SAD_sse2(const uint8_t* iPtr, int imgStride,
+                         const uint8_t* rPtr, int refStride,
+                         int width, int height)
+{
+  __m128i acc = _mm_setzero_si128();
+  uint32_t sum=0;
+
+  for (int y=0;y<height;y++) {
+    int x=0;
+
+    for (;x+16<=width;x+=16) {
+      __m128i a = _mm_loadu_si128((const __m128i*)(iPtr+x));
+      __m128i b = _mm_loadu_si128((const __m128i*)(rPtr+x));
+      acc = _mm_add_epi64(acc, _mm_sad_epu8(a,b));
+    }
+
+    if (x+8<=width) {
+      __m128i a = _mm_loadl_epi64((const __m128i*)(iPtr+x));
+      __m128i b = _mm_loadl_epi64((const __m128i*)(rPtr+x));
+      acc = _mm_add_epi64(acc, _mm_sad_epu8(a,b));
+      x+=8;
+    }
+
+    for (;x<width;x++) {
+      int diff = iPtr[x] - rPtr[x];
+      sum += abs_value(diff);
+    }
+
+    iPtr += imgStride;
+    rPtr += refStride;
+  }
+
+  acc = _mm_add_epi64(acc, _mm_srli_si128(acc,8));
+
+  return sum + (uint32_t)_mm_cvtsi128_si32(acc);
+}
+#endif
+
+
+uint32_t SAD(const uint8_t* img, int imgStride,
+             const uint8_t* ref, int refStride,
+             int width, int height)
+{
+#if QUALITY_SSE2
+  return SAD_sse2(img,imgStride, ref,refStride, width,height);
+#else
+  return SAD_scalar(img,imgStride, ref,refStride, width,height);
+#endif
+}
 
 
 double MSE(const uint8_t* img, int imgStride,
@@ -78,12 +198,7 @@ double MSE(const uint8_t* img, int imgStride,
   const uint8_t* rPtr = ref;
 
   for (int y=0;y<height;y++) {
-    uint32_t lineSum=0;
-
-    for (int x=0;x<width;x++) {
-      int diff = iPtr[x] - rPtr[x];
-      lineSum += diff*diff;
-    }
+    uint32_t lineSum = SSD(iPtr,imgStride, rPtr,refStride, width,1);
 
     sum += ((double)lineSum)/width;
 
@@ -102,6 +217,139 @@ double PSNR(double mse)
   return 10*log10(255.0*255.0/mse);
 }
 
+
+// Sums of a, b, a*a+b*b and a*b of consecutive 4x4 blocks.
+
+static void ssim_4x4_sums_scalar(const uint8_t* a, int aStride,
+                                 const uint8_t* b, int bStride,
+                                 int nBlocks, int (*sums)[4])
+{
+  for (int blk=0;blk<nBlocks;blk++) {
+    int s1=0, s2=0, ss=0, s12=0;
+
+    for (int y=0;y<4;y++)
+      for (int x=0;x<4;x++) {
+        int va = a[y*aStride + blk*4+x];
+        int vb = b[y*bStride + blk*4+x];
+
+        s1  += va;
+        s2  += vb;
+        ss  += va*va + vb*vb;
+        s12 += va*vb;
+      }
+
+    sums[blk][0] = s1;
+    sums[blk][1] = s2;
+    sums[blk][2] = ss;
+    sums[blk][3] = s12;
+  }
+}
+
+
+#if QUALITY_SSE2
+static void ssim_4x4_sums_sse2(const uint8_t* a, int aStride,
+                               const uint8_t* b, int bStride,
+                               int nBlocks, int (*sums)[4])
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one  = _mm_set1_epi16(1);
+
+  int blk=0;
+
+  // two blocks per iteration
+
+  for (;blk+2<=nBlocks;blk+=2) {
+    __m128i s1 = zero, s2 = zero, ss = zero, s12 = zero;
+
+    for (int y=0;y<4;y++) {
+      __m128i va = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(a + y*aStride + blk*4)), zero);
+      __m128i vb = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(b + y*bStride + blk*4)), zero);
+
+      s1  = _mm_add_epi32(s1,  _mm_madd_epi16(va,one));
+      s2  = _mm_add_epi32(s2,  _mm_madd_epi16(vb,one));
+      ss  = _mm_add_epi32(ss,  _mm_add_epi32(_mm_madd_epi16(va,va), _mm_madd_epi16(vb,vb)));
+      s12 = _mm_add_epi32(s12, _mm_madd_epi16(va,vb));
+    }
+
+    // 32-bit lanes 0+1 belong to the first block, 2+3 to the second one
+
+    __m128i v[4] = { s1, s2, ss, s12 };
+    for (int i=0;i<4;i++) {
+      __m128i t = _mm_add_epi32(v[i], _mm_srli_epi64(v[i],32));
+      sums[blk  ][i] = _mm_cvtsi128_si32(t);
+      sums[blk+1][i] = _mm_cvtsi128_si32(_mm_srli_si128(t,8));
+    }
+  }
+
+  if (blk<nBlocks) {
+    ssim_4x4_sums_scalar(a+blk*4,aStride, b+blk*4,bStride, nBlocks-blk, sums+blk);
+  }
+}
+#endif
+
+
+// SSIM of an 8x8 window from the sums of its four 4x4 blocks
+
+static double ssim_window(int s1, int s2, int ss, int s12)
+{
+  const double c1 = .01*.01*255*255*64;
+  const double c2 = .03*.03*255*255*64*63;
+
+  double fs1 = s1;
+  double fs2 = s2;
+  double vars  = ss *64.0 - fs1*fs1 - fs2*fs2;
+  double covar = s12*64.0 - fs1*fs2;
+
+  return ((2*fs1*fs2 + c1) * (2*covar + c2)) / ((fs1*fs1 + fs2*fs2 + c1) * (vars + c2));
+}
+
+
+double SSIM(const uint8_t* img, int imgStride,
+            const uint8_t* ref, int refStride,
+            int width, int height)
+{
+  const int wBlks = width /4;
+  const int hBlks = height/4;
+
+  if (wBlks<2 || hBlks<2) {
+    return 1.0;
+  }
+
+  // block sums of the previous and the current row of 4x4 blocks
+
+  std::vector<int> buffer(2*wBlks*4);
+  int (*prev)[4] = (int (*)[4])&buffer[0];
+  int (*curr)[4] = (int (*)[4])&buffer[wBlks*4];
+
+  double sum=0.0;
+
+  for (int by=0;by<hBlks;by++) {
+#if QUALITY_SSE2
+    ssim_4x4_sums_sse2(img + by*4*imgStride, imgStride, ref + by*4*refStride, refStride,
+                       wBlks, curr);
+#else
+    ssim_4x4_sums_scalar(img + by*4*imgStride, imgStride, ref + by*4*refStride, refStride,
+                         wBlks, curr);
+#endif
+
+    if (by>0) {
+      for (int bx=0;bx<wBlks-1;bx++) {
+        int s[4];
+        for (int i=0;i<4;i++) {
+          s[i] = prev[bx][i] + prev[bx+1][i] + curr[bx][i] + curr[bx+1][i];
+        }
+
+        sum += ssim_window(s[0],s[1],s[2],s[3]);
+      }
+    }
+
+    std::swap(prev,curr);
+  }
+
+  return sum / ((wBlks-1)*(hBlks-1));
+}
+
+
 uint32_t compute_distortion_ssd(const de265_image* img1, const de265_image* img2,
                                 int x0, int y0, int log2size, int cIdx)
 {
@@ -40,6 +40,13 @@ LIBDE265_API double MSE(const uint8_t* img, int imgStride,
 
 LIBDE265_API double PSNR(double mse);
 
+/* Mean SSIM of the 8x8 windows at a step of 4 samples (without Gaussian weighting).
+   Returns 1.0 for planes smaller than 8x8.
+ */
+LIBDE265_API double SSIM(const uint8_t* img, int imgStride,
+                         const uint8_t* ref, int refStride,
+                         int width, int height);
+
 
 LIBDE265_API uint32_t compute_distortion_ssd(const de265_image* img1, const de265_image* img2,
                                              int x0, int y0, int log2size, int cIdx);
@@ -377,28 +377,6 @@ void apply_sample_adaptive_offset_sequential(de265_image* img)
 
 
 
-
-class thread_task_sao : public thread_task
-{
-public:
-  int  ctb_y;
-  de265_image* img; /* this is where we get the SPS from
-                       (either inputImg or outputImg can be a dummy image)
-                    */
-
-  de265_image* inputImg;
-  de265_image* outputImg;
-  int inputProgress;
-
-  virtual void work();
-  virtual std::string name() const {
-    char buf[100];
-    sprintf(buf,"sao-%d",ctb_y);
-    return buf;
-  }
-};
-
-
 void thread_task_sao::work()
 {
   state = Running;
@@ -423,6 +401,11 @@ void thread_task_sao::work()
   }
 
 
+  stage_timing timing;
+  timing.enabled = img->decctx->param_stage_timing;
+  stage_timer timer(timing, STAGE_SAO);
+
+
   // copy input image to output for this CTB-row
 
   outputImg->copy_lines_from(inputImg, ctb_y * ctbSize, (ctb_y+1) * ctbSize);
@@ -458,6 +441,10 @@ void thread_task_sao::work()
     }
 
 
+  timer.stop();
+  img->decctx->add_stage_timing(timing);
+
+
   // mark SAO progress
 
   for (int x=0;x<=rightCtb;x++) {
@@ -501,7 +488,7 @@ bool add_sao_tasks(image_unit* imgunit, int saoInputProgress)
 
   for (int y=0;y<nRows;y++)
     {
-      thread_task_sao* task = new thread_task_sao;
+      thread_task_sao* task = ctx->alloc_task(ctx->sao_task_pool);
 
       task->inputImg  = img;
       task->outputImg = &imgunit->sao_output;
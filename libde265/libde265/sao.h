@@ -23,6 +23,28 @@
 
 #include "libde265/decctx.h"
 
+
+class thread_task_sao : public thread_task
+{
+public:
+  int  ctb_y;
+  de265_image* img; /* this is where we get the SPS from
+                       (either inputImg or outputImg can be a dummy image)
+                    */
+
+  de265_image* inputImg;
+  de265_image* outputImg;
+  int inputProgress;
+
+  virtual void work();
+  virtual std::string name() const {
+    char buf[100];
+    sprintf(buf,"sao-%d",ctb_y);
+    return buf;
+  }
+};
+
+
 void apply_sample_adaptive_offset(de265_image* img);
 
 /* requires less memory than the function above */
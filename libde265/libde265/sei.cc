@@ -222,6 +222,49 @@ static inline uint16_t crc_process_byte_parallel(uint16_t crc, uint8_t byte)
 	   (t << 12)) & 0xFFFF;
 }
 
+/* Tables for processing eight bytes at once ("slicing-by-8"). table[k][b] is the CRC
+   register after processing byte b, followed by k zero bytes, starting from zero.
+   Since the CRC is linear, the register after eight bytes is the XOR of the table
+   entries of each byte. The initial register acts like XORing it into the first two bytes.
+ */
+class crc_tables
+{
+public:
+  crc_tables() {
+    for (int b=0;b<256;b++) {
+      uint16_t crc = crc_process_byte_parallel(0, b);
+      table[0][b] = crc;
+
+      for (int k=1;k<8;k++) {
+        crc = crc_process_byte_parallel(crc, 0);
+        table[k][b] = crc;
+      }
+    }
+  }
+
+  uint16_t table[8][256];
+};
+
+static uint16_t crc_process_bytes(uint16_t crc, const uint8_t* data, int len)
+{
+  static const crc_tables tables;  // initialized on first use (thread-safe)
+  const uint16_t (*t)[256] = tables.table;
+
+  int x=0;
+  for (; x+8<=len; x+=8) {
+    const uint8_t* p = data+x;
+
+    crc = (t[7][p[0] ^ (crc >> 8)] ^ t[6][p[1] ^ (crc & 0xFF)] ^
+           t[5][p[2]] ^ t[4][p[3]] ^ t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]]);
+  }
+
+  for (; x<len; x++) {
+    crc = crc_process_byte_parallel(crc, data[x]);
+  }
+
+  return crc;
+}
+
 static uint32_t compute_CRC_8bit_fast(const uint8_t* data,int w,int h,int stride, int bit_depth)
 {
   raw_hash_data raw_data(w,stride);
@@ -239,9 +282,7 @@ static uint32_t compute_CRC_8bit_fast(const uint8_t* data,int w,int h,int stride
     else
       chunk = raw_data.prepare_8bit(data, y);
 
-    for(int x=0; x<chunk.len; x++) {
-      crc = crc_process_byte_parallel(crc, chunk.data[x]);
-    }
+    crc = crc_process_bytes(crc, chunk.data, chunk.len);
   }
 
   return crc;
@@ -286,77 +327,86 @@ static de265_error process_sei_decoded_picture_hash(const sei_message* sei, de26
 
   int nHashes = img->get_sps().chroma_format_idc==0 ? 1 : 3;
   for (int i=0;i<nHashes;i++) {
-    uint8_t* data;
-    int w,h,stride;
+    if (!check_decoded_picture_hash(seihash, img, i)) {
+      return DE265_ERROR_CHECKSUM_MISMATCH;
+    }
+  }
 
-    w = img->get_width(i);
-    h = img->get_height(i);
+  loginfo(LogSEI,"decoded picture hash checked: OK\n");
+  //printf("checked picture %d SEI: OK\n", img->PicOrderCntVal);
 
-    data = img->get_image_plane(i);
-    stride = img->get_image_stride(i);
+  return DE265_OK;
+}
 
-    switch (seihash->hash_type) {
-    case sei_decoded_picture_hash_type_MD5:
-      {
-        uint8_t md5[16];
-        compute_MD5(data,w,h,stride,md5, img->get_bit_depth(i));
 
-/*
-        fprintf(stderr,"computed MD5: ");
-        for (int b=0;b<16;b++) {
-          fprintf(stderr,"%02x", md5[b]);
-        }
-        fprintf(stderr,"\n");
-*/
+bool check_decoded_picture_hash(const sei_decoded_picture_hash* seihash, de265_image* img, int i)
+{
+  uint8_t* data;
+  int w,h,stride;
 
-        for (int b=0;b<16;b++) {
-          if (md5[b] != seihash->md5[i][b]) {
-/*
-            fprintf(stderr,"SEI decoded picture MD5 mismatch (POC=%d)\n", img->PicOrderCntVal);
-*/
-            return DE265_ERROR_CHECKSUM_MISMATCH;
-          }
+  w = img->get_width(i);
+  h = img->get_height(i);
+
+  data = img->get_image_plane(i);
+  stride = img->get_image_stride(i);
+
+  switch (seihash->hash_type) {
+  case sei_decoded_picture_hash_type_MD5:
+    {
+      uint8_t md5[16];
+      compute_MD5(data,w,h,stride,md5, img->get_bit_depth(i));
+
+      for (int b=0;b<16;b++) {
+        if (md5[b] != seihash->md5[i][b]) {
+          return false;
         }
       }
-      break;
+    }
+    break;
 
-    case sei_decoded_picture_hash_type_CRC:
-      {
-        uint16_t crc = compute_CRC_8bit_fast(data,w,h,stride, img->get_bit_depth(i));
+  case sei_decoded_picture_hash_type_CRC:
+    {
+      uint16_t crc = compute_CRC_8bit_fast(data,w,h,stride, img->get_bit_depth(i));
 
-        logtrace(LogSEI,"SEI decoded picture hash: %04x <-[%d]-> decoded picture: %04x\n",
-                 seihash->crc[i], i, crc);
+      logtrace(LogSEI,"SEI decoded picture hash: %04x <-[%d]-> decoded picture: %04x\n",
+               seihash->crc[i], i, crc);
 
-        if (crc != seihash->crc[i]) {
-/*
-          fprintf(stderr,"SEI decoded picture hash: %04x, decoded picture: %04x (POC=%d)\n",
-                  seihash->crc[i], crc, img->PicOrderCntVal);
-*/
-          return DE265_ERROR_CHECKSUM_MISMATCH;
-        }
+      if (crc != seihash->crc[i]) {
+        return false;
       }
-      break;
+    }
+    break;
 
-    case sei_decoded_picture_hash_type_checksum:
-      {
-        uint32_t chksum = compute_checksum_8bit(data,w,h,stride, img->get_bit_depth(i));
+  case sei_decoded_picture_hash_type_checksum:
+    {
+      uint32_t chksum = compute_checksum_8bit(data,w,h,stride, img->get_bit_depth(i));
 
-        if (chksum != seihash->checksum[i]) {
-/*
-          fprintf(stderr,"SEI decoded picture hash: %04x, decoded picture: %04x (POC=%d)\n",
-                  seihash->checksum[i], chksum, img->PicOrderCntVal);
-*/
-          return DE265_ERROR_CHECKSUM_MISMATCH;
-        }
+      if (chksum != seihash->checksum[i]) {
+        return false;
       }
-      break;
     }
+    break;
   }
 
-  loginfo(LogSEI,"decoded picture hash checked: OK\n");
-  //printf("checked picture %d SEI: OK\n", img->PicOrderCntVal);
+  return true;
+}
 
-  return DE265_OK;
+
+void thread_task_hash::work()
+{
+  state = Running;
+
+  stage_timing timing;
+  timing.enabled = img->decctx->param_stage_timing;
+  stage_timer timer(timing, STAGE_HASH_CHECK);
+
+  mismatch = !check_decoded_picture_hash(&hash, img, cIdx);
+
+  timer.stop();
+  img->decctx->add_stage_timing(timing);
+
+  state = Finished;
+  finished->increase_progress(1);
 }
 
 
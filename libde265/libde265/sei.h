@@ -23,6 +23,7 @@
 
 #include "libde265/bitstream.h"
 #include "libde265/de265.h"
+#include "libde265/threads.h"
 
 
 enum sei_payload_type {
@@ -86,4 +87,29 @@ de265_error read_sei(bitreader* reader, sei_message*, bool suffix, const seq_par
 void dump_sei(const sei_message*, const seq_parameter_set* sps);
 de265_error process_sei(const sei_message*, struct de265_image* img);
 
+// Check the decoded picture hash of one color plane, false on mismatch.
+bool check_decoded_picture_hash(const sei_decoded_picture_hash*, struct de265_image* img, int cIdx);
+
+
+/* Checks the hash of one color plane on a worker thread (see decoder_context::start_hash_check()).
+   When done, 'mismatch' is set and 'finished' is increased by one.
+ */
+class thread_task_hash : public thread_task
+{
+public:
+  struct de265_image* img;
+  int cIdx;
+  sei_decoded_picture_hash hash;  // a copy, the SEI is released with the image unit
+
+  bool mismatch;
+  de265_progress_lock* finished;
+
+  virtual void work();
+  virtual std::string name() const {
+    char buf[100];
+    sprintf(buf,"hash-%d",cIdx);
+    return buf;
+  }
+};
+
 #endif
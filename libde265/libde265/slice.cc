@@ -1611,6 +1611,8 @@ static int decode_sao_band_position(thread_context* tctx)
 
 static int decode_transquant_bypass_flag(thread_context* tctx)
 {
+  set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_CU_header);
+
   logtrace(LogSlice,"# cu_transquant_bypass_enable_flag\n");
   int value = decode_CABAC_bit(&tctx->cabac_decoder,
                                &tctx->ctx_model[CONTEXT_MODEL_CU_TRANSQUANT_BYPASS_FLAG]);
@@ -1625,6 +1627,8 @@ static int decode_transquant_bypass_flag(thread_context* tctx)
 static int decode_split_cu_flag(thread_context* tctx,
 				int x0, int y0, int ctDepth)
 {
+  set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_CU_split);
+
   // check if neighbors are available
 
   int availableL = check_CTB_available(tctx->img, x0,y0, x0-1,y0);
@@ -1656,6 +1660,8 @@ static int decode_split_cu_flag(thread_context* tctx,
 static int decode_cu_skip_flag(thread_context* tctx,
 			       int x0, int y0, int ctDepth)
 {
+  set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_CU_header);
+
   decoder_context* ctx = tctx->decctx;
 
   // check if neighbors are available
@@ -1689,6 +1695,8 @@ static int decode_cu_skip_flag(thread_context* tctx,
 static enum PartMode decode_part_mode(thread_context* tctx,
 				      enum PredMode pred_mode, int cLog2CbSize)
 {
+  set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_CU_header);
+
   de265_image* img = tctx->img;
 
   if (pred_mode == MODE_INTRA) {
@@ -1769,6 +1777,8 @@ static enum PartMode decode_part_mode(thread_context* tctx,
 
 static inline int decode_prev_intra_luma_pred_flag(thread_context* tctx)
 {
+  set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_intra_mode);
+
   logtrace(LogSlice,"# prev_intra_luma_pred_flag\n");
   int bit = decode_CABAC_bit(&tctx->cabac_decoder, &tctx->ctx_model[CONTEXT_MODEL_PREV_INTRA_LUMA_PRED_FLAG]);
   logtrace(LogSymbols,"$1 prev_intra_luma_pred_flag=%d\n",bit);
@@ -1778,6 +1788,8 @@ static inline int decode_prev_intra_luma_pred_flag(thread_context* tctx)
 
 static inline int decode_mpm_idx(thread_context* tctx)
 {
+  set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_intra_mode);
+
   logtrace(LogSlice,"# mpm_idx (TU:2)\n");
   int mpm = decode_CABAC_TU_bypass(&tctx->cabac_decoder, 2);
   logtrace(LogSlice,"> mpm_idx = %d\n",mpm);
@@ -1788,6 +1800,8 @@ static inline int decode_mpm_idx(thread_context* tctx)
 
 static inline int decode_rem_intra_luma_pred_mode(thread_context* tctx)
 {
+  set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_intra_mode);
+
   logtrace(LogSlice,"# rem_intra_luma_pred_mode (5 bits)\n");
   int value = decode_CABAC_FL_bypass(&tctx->cabac_decoder, 5);
   logtrace(LogSymbols,"$1 rem_intra_luma_pred_mode=%d\n",value);
@@ -1797,6 +1811,8 @@ static inline int decode_rem_intra_luma_pred_mode(thread_context* tctx)
 
 static int decode_intra_chroma_pred_mode(thread_context* tctx)
 {
+  set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_intra_mode);
+
   logtrace(LogSlice,"# intra_chroma_pred_mode\n");
 
   int prefix = decode_CABAC_bit(&tctx->cabac_decoder, &tctx->ctx_model[CONTEXT_MODEL_INTRA_CHROMA_PRED_MODE]);
@@ -1819,6 +1835,8 @@ static int decode_intra_chroma_pred_mode(thread_context* tctx)
 static int decode_split_transform_flag(thread_context* tctx,
 				       int log2TrafoSize)
 {
+  set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_transform_tree);
+
   logtrace(LogSlice,"# split_transform_flag (log2TrafoSize=%d)\n",log2TrafoSize);
 
   int context = 5-log2TrafoSize;
@@ -1835,6 +1853,8 @@ static int decode_split_transform_flag(thread_context* tctx,
 static int decode_cbf_chroma(thread_context* tctx,
 			     int trafoDepth)
 {
+  set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_transform_tree);
+
   logtrace(LogSlice,"# cbf_chroma\n");
 
   int bit = decode_CABAC_bit(&tctx->cabac_decoder, &tctx->ctx_model[CONTEXT_MODEL_CBF_CHROMA + trafoDepth]);
@@ -1847,6 +1867,8 @@ static int decode_cbf_chroma(thread_context* tctx,
 static int decode_cbf_luma(thread_context* tctx,
 			   int trafoDepth)
 {
+  set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_transform_tree);
+
   logtrace(LogSlice,"# cbf_luma\n");
 
   int bit = decode_CABAC_bit(&tctx->cabac_decoder, &tctx->ctx_model[CONTEXT_MODEL_CBF_LUMA + (trafoDepth==0)]);
@@ -1858,7 +1880,8 @@ static int decode_cbf_luma(thread_context* tctx,
 }
 
 
-static inline int decode_coded_sub_block_flag(thread_context* tctx,
+static inline int decode_coded_sub_block_flag(CABAC_decoder* decoder,
+                                              context_model* model,
                                               int cIdx,
                                               uint8_t coded_sub_block_neighbors)
 {
@@ -1873,8 +1896,7 @@ static inline int decode_coded_sub_block_flag(thread_context* tctx,
     ctxIdxInc += 2;
   }
 
-  int bit = decode_CABAC_bit(&tctx->cabac_decoder,
-                             &tctx->ctx_model[CONTEXT_MODEL_CODED_SUB_BLOCK_FLAG + ctxIdxInc]);
+  int bit = decode_CABAC_bit(decoder, &model[CONTEXT_MODEL_CODED_SUB_BLOCK_FLAG + ctxIdxInc]);
 
   logtrace(LogSymbols,"$1 coded_sub_block_flag=%d\n",bit);
   return bit;
@@ -1883,6 +1905,8 @@ static inline int decode_coded_sub_block_flag(thread_context* tctx,
 
 static int decode_cu_qp_delta_abs(thread_context* tctx)
 {
+  set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_delta_QP);
+
   logtrace(LogSlice,"# cu_qp_delta_abs\n");
 
   int bit = decode_CABAC_bit(&tctx->cabac_decoder,
@@ -1961,6 +1985,58 @@ static const uint8_t ctxIdxMap[16] = {
 
 uint8_t* ctxIdxLookup[4 /* 4-log2-32 */][2 /* !!cIdx */][2 /* !!scanIdx */][4 /* prevCsbf */];
 
+
+/* The same significant_coeff_flag contexts, but in scan order and for each
+   sub-block type, together with the coefficient positions. This is used by the
+   specialized decode_residual_coefficients().
+ */
+struct residual_scan_table
+{
+  uint16_t coeffPos[64][16];  // raster position of coefficient n in sub-block i
+  uint8_t  subBlockPos[64];   // raster position of sub-block i
+  uint8_t  sigCtx[2 /* !!cIdx */][2 /* DC sub-block */][4 /* prevCsbf */][16];
+};
+
+static residual_scan_table residual_scan_tables[4 /* log2-2 */][3 /* scanIdx */];
+
+static void init_residual_scan_tables()
+{
+  for (int log2w=2; log2w<=5 ; log2w++)
+    for (int scanIdx=0;scanIdx<3;scanIdx++) {
+      residual_scan_table& table = residual_scan_tables[log2w-2][scanIdx];
+
+      int sbWidth = 1<<(log2w-2);
+      const position* ScanOrderSub = get_scan_order(log2w-2, scanIdx);
+      const position* ScanOrderPos = get_scan_order(2, scanIdx);
+
+      for (int i=0;i<sbWidth*sbWidth;i++) {
+        position S = ScanOrderSub[i];
+        table.subBlockPos[i] = S.x + S.y*sbWidth;
+
+        for (int n=0;n<16;n++) {
+          int xC = (S.x<<2) + ScanOrderPos[n].x;
+          int yC = (S.y<<2) + ScanOrderPos[n].y;
+          table.coeffPos[i][n] = xC + (yC<<log2w);
+        }
+      }
+
+      // The context only depends on whether the sub-block is the DC sub-block,
+      // so we take the contexts from the sub-blocks at (0;0) and (1;0).
+
+      for (int cIdx=0;cIdx<2;cIdx++)
+        for (int dcSubBlock=0;dcSubBlock<2;dcSubBlock++)
+          for (int prevCsbf=0;prevCsbf<4;prevCsbf++)
+            for (int n=0;n<16;n++) {
+              int xS = (dcSubBlock || sbWidth==1) ? 0 : 1;
+              int xC = (xS<<2) + ScanOrderPos[n].x;
+              int yC = ScanOrderPos[n].y;
+
+              table.sigCtx[cIdx][dcSubBlock][prevCsbf][n] =
+                ctxIdxLookup[log2w-2][cIdx][!!scanIdx][prevCsbf][xC+(yC<<log2w)];
+            }
+    }
+}
+
 bool alloc_and_init_significant_coeff_ctxIdx_lookupTable()
 {
   int tableSize = 4*4*(2) + 8*8*(2*2*4) + 16*16*(2*4) + 32*32*(2*4);
@@ -2112,6 +2188,8 @@ bool alloc_and_init_significant_coeff_ctxIdx_lookupTable()
                 }
           }
 
+  init_residual_scan_tables();
+
   return true;
 }
 
@@ -2340,14 +2418,14 @@ static int decode_significant_coeff_flag(thread_context* tctx,
 
 
 
-static inline int decode_significant_coeff_flag_lookup(thread_context* tctx,
-                                                 uint8_t ctxIdxInc)
+static inline int decode_significant_coeff_flag_lookup(CABAC_decoder* decoder,
+                                                       context_model* model,
+                                                       uint8_t ctxIdxInc)
 {
   logtrace(LogSlice,"# significant_coeff_flag\n");
   logtrace(LogSlice,"context: %d\n",ctxIdxInc);
 
-  int bit = decode_CABAC_bit(&tctx->cabac_decoder,
-                             &tctx->ctx_model[CONTEXT_MODEL_SIGNIFICANT_COEFF_FLAG + ctxIdxInc]);
+  int bit = decode_CABAC_bit(decoder, &model[CONTEXT_MODEL_SIGNIFICANT_COEFF_FLAG + ctxIdxInc]);
 
   logtrace(LogSymbols,"$1 significant_coeff_flag=%d\n",bit);
 
@@ -2358,7 +2436,8 @@ static inline int decode_significant_coeff_flag_lookup(thread_context* tctx,
 
 
 
-static inline int decode_coeff_abs_level_greater1(thread_context* tctx,
+static inline int decode_coeff_abs_level_greater1(CABAC_decoder* decoder,
+                                                  context_model* model,
                                                   int cIdx, int i,
                                                   bool firstCoeffInSubblock,
                                                   bool firstSubblock,
@@ -2412,8 +2491,7 @@ static inline int decode_coeff_abs_level_greater1(thread_context* tctx,
 
   if (cIdx>0) { ctxIdxInc+=16; }
 
-  int bit = decode_CABAC_bit(&tctx->cabac_decoder,
-                             &tctx->ctx_model[CONTEXT_MODEL_COEFF_ABS_LEVEL_GREATER1_FLAG + ctxIdxInc]);
+  int bit = decode_CABAC_bit(decoder, &model[CONTEXT_MODEL_COEFF_ABS_LEVEL_GREATER1_FLAG + ctxIdxInc]);
 
   *lastInvocation_greater1Ctx = greater1Ctx;
   *lastInvocation_coeff_abs_level_greater1_flag = bit;
@@ -2425,7 +2503,8 @@ static inline int decode_coeff_abs_level_greater1(thread_context* tctx,
 }
 
 
-static int decode_coeff_abs_level_greater2(thread_context* tctx,
+static int decode_coeff_abs_level_greater2(CABAC_decoder* decoder,
+                                           context_model* model,
 					   int cIdx, // int i,int n,
 					   int ctxSet)
 {
@@ -2435,8 +2514,7 @@ static int decode_coeff_abs_level_greater2(thread_context* tctx,
 
   if (cIdx>0) ctxIdxInc+=4;
 
-  int bit = decode_CABAC_bit(&tctx->cabac_decoder,
-                             &tctx->ctx_model[CONTEXT_MODEL_COEFF_ABS_LEVEL_GREATER2_FLAG + ctxIdxInc]);
+  int bit = decode_CABAC_bit(decoder, &model[CONTEXT_MODEL_COEFF_ABS_LEVEL_GREATER2_FLAG + ctxIdxInc]);
 
   logtrace(LogSymbols,"$1 coeff_abs_level_greater2=%d\n",bit);
 
@@ -2446,8 +2524,8 @@ static int decode_coeff_abs_level_greater2(thread_context* tctx,
 
 #define MAX_PREFIX 64
 
-static int decode_coeff_abs_level_remaining(thread_context* tctx,
-                                            int cRiceParam)
+static inline int decode_coeff_abs_level_remaining(CABAC_decoder* decoder,
+                                                   int cRiceParam)
 {
   logtrace(LogSlice,"# decode_coeff_abs_level_remaining\n");
 
@@ -2455,7 +2533,7 @@ static int decode_coeff_abs_level_remaining(thread_context* tctx,
   int codeword=0;
   do {
     prefix++;
-    codeword = decode_CABAC_bypass(&tctx->cabac_decoder);
+    codeword = decode_CABAC_bypass(decoder);
 
     if (prefix>MAX_PREFIX) {
       return 0; // TODO: error
@@ -2470,14 +2548,14 @@ static int decode_coeff_abs_level_remaining(thread_context* tctx,
   if (prefix <= 3) {
     // when code only TR part (level < TRMax)
 
-    codeword = decode_CABAC_FL_bypass(&tctx->cabac_decoder, cRiceParam);
+    codeword = decode_CABAC_FL_bypass(decoder, cRiceParam);
     value = (prefix<<cRiceParam) + codeword;
   }
   else {
     // Suffix coded with EGk. Note that the unary part of EGk is already
     // included in the 'prefix' counter above.
 
-    codeword = decode_CABAC_FL_bypass(&tctx->cabac_decoder, prefix-3+cRiceParam);
+    codeword = decode_CABAC_FL_bypass(decoder, prefix-3+cRiceParam);
     value = (((1<<(prefix-3))+3-1)<<cRiceParam)+codeword;
   }
 
@@ -2489,6 +2567,8 @@ static int decode_coeff_abs_level_remaining(thread_context* tctx,
 
 static int decode_merge_flag(thread_context* tctx)
 {
+  set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_merge);
+
   logtrace(LogSlice,"# merge_flag\n");
 
   int bit = decode_CABAC_bit(&tctx->cabac_decoder,
@@ -2502,6 +2582,8 @@ static int decode_merge_flag(thread_context* tctx)
 
 static int decode_merge_idx(thread_context* tctx)
 {
+  set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_merge);
+
   logtrace(LogSlice,"# merge_idx\n");
 
   if (tctx->shdr->MaxNumMergeCand <= 1) {
@@ -2540,6 +2622,8 @@ static int decode_merge_idx(thread_context* tctx)
 
 static int decode_pred_mode_flag(thread_context* tctx)
 {
+  set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_CU_header);
+
   logtrace(LogSlice,"# pred_mode_flag\n");
 
   int bit = decode_CABAC_bit(&tctx->cabac_decoder,
@@ -2551,6 +2635,8 @@ static int decode_pred_mode_flag(thread_context* tctx)
 
 static int decode_mvp_lx_flag(thread_context* tctx)
 {
+  set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_motion_info);
+
   logtrace(LogSlice,"# mvp_lx_flag\n");
 
   int bit = decode_CABAC_bit(&tctx->cabac_decoder,
@@ -2562,6 +2648,8 @@ static int decode_mvp_lx_flag(thread_context* tctx)
 
 static int decode_rqt_root_cbf(thread_context* tctx)
 {
+  set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_transform_tree);
+
   logtrace(LogSlice,"# rqt_root_cbf\n");
 
   int bit = decode_CABAC_bit(&tctx->cabac_decoder,
@@ -2573,6 +2661,8 @@ static int decode_rqt_root_cbf(thread_context* tctx)
 
 static int decode_ref_idx_lX(thread_context* tctx, int numRefIdxLXActive)
 {
+  set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_motion_info);
+
   logtrace(LogSlice,"# ref_idx_lX\n");
 
   int cMax = numRefIdxLXActive-1;
@@ -2612,6 +2702,8 @@ static enum InterPredIdc  decode_inter_pred_idc(thread_context* tctx,
                                                int nPbW, int nPbH,
                                                int ctDepth)
 {
+  set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_motion_info);
+
   logtrace(LogSlice,"# inter_pred_idc\n");
 
   int value;
@@ -2695,6 +2787,8 @@ bool advanceCtbAddr(thread_context* tctx)
 void read_sao(thread_context* tctx, int xCtb,int yCtb,
               int CtbAddrInSliceSeg)
 {
+  set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_SAO);
+
   slice_segment_header* shdr = tctx->shdr;
   de265_image* img = tctx->img;
   const seq_parameter_set& sps = img->get_sps();
@@ -2847,6 +2941,8 @@ void read_coding_tree_unit(thread_context* tctx)
            xCtbPixels,yCtbPixels, xCtb,yCtb,
            tctx->img->PicOrderCntVal, tctx->shdr->SliceAddrRS);
 
+  img->clear_CTB_metadata(xCtb, yCtb);
+
   img->set_SliceAddrRS(xCtb, yCtb, tctx->shdr->SliceAddrRS);
 
   img->set_SliceHeaderIndex(xCtbPixels,yCtbPixels, shdr->slice_index);
@@ -2902,129 +2998,19 @@ int check_CTB_available(const de265_image* img,
 }
 
 
-int residual_coding(thread_context* tctx,
-                    int x0, int y0,  // position of TU in frame
-                    int log2TrafoSize,
-                    int cIdx)
+/* Parse the coefficients of a TU, starting at the last significant coefficient.
+   This handles all cases, including the range-extension tools. For the common
+   case, see the specialized decode_residual_coefficients() below.
+ */
+int decode_residual_coefficients_generic(CABAC_decoder* decoder,
+                                         context_model* model,
+                                         int log2TrafoSize, int cIdx, int scanIdx,
+                                         int lastSubBlock, int lastScanPos,
+                                         bool signHiding,
+                                         bool transformSkipContext,
+                                         uint8_t* StatCoeff,
+                                         int16_t* coeffList, int16_t* coeffPos)
 {
-  logtrace(LogSlice,"- residual_coding x0:%d y0:%d log2TrafoSize:%d cIdx:%d\n",x0,y0,log2TrafoSize,cIdx);
-
-  //slice_segment_header* shdr = tctx->shdr;
-
-  de265_image* img = tctx->img;
-  const seq_parameter_set& sps = img->get_sps();
-  const pic_parameter_set& pps = img->get_pps();
-
-  enum PredMode PredMode = img->get_pred_mode(x0,y0);
-
-  if (cIdx==0) {
-    img->set_nonzero_coefficient(x0,y0,log2TrafoSize);
-  }
-
-
-  if (pps.transform_skip_enabled_flag &&
-      !tctx->cu_transquant_bypass_flag &&
-      (log2TrafoSize <= pps.Log2MaxTransformSkipSize))
-    {
-      tctx->transform_skip_flag[cIdx] = decode_transform_skip_flag(tctx,cIdx);
-    }
-  else
-    {
-      tctx->transform_skip_flag[cIdx] = 0;
-    }
-
-
-  tctx->explicit_rdpcm_flag = false;
-
-  if (PredMode == MODE_INTER && sps.range_extension.explicit_rdpcm_enabled_flag &&
-      ( tctx->transform_skip_flag[cIdx] || tctx->cu_transquant_bypass_flag))
-    {
-      tctx->explicit_rdpcm_flag = decode_explicit_rdpcm_flag(tctx,cIdx);
-      if (tctx->explicit_rdpcm_flag) {
-        tctx->explicit_rdpcm_dir = decode_explicit_rdpcm_dir(tctx,cIdx);
-      }
-
-      //printf("EXPLICIT RDPCM %d;%d\n",x0,y0);
-    }
-  else
-    {
-      tctx->explicit_rdpcm_flag = false;
-    }
-
-
-
-  // sbType for persistent_rice_adaptation_enabled_flag
-
-  int sbType = (cIdx==0) ? 2 : 0;
-  if (tctx->transform_skip_flag[cIdx] || tctx->cu_transquant_bypass_flag) {
-    sbType++;
-  }
-
-
-  // --- decode position of last coded coefficient ---
-
-  int last_significant_coeff_x_prefix =
-    decode_last_significant_coeff_prefix(tctx,log2TrafoSize,cIdx,
-                                         &tctx->ctx_model[CONTEXT_MODEL_LAST_SIGNIFICANT_COEFFICIENT_X_PREFIX]);
-
-  int last_significant_coeff_y_prefix =
-    decode_last_significant_coeff_prefix(tctx,log2TrafoSize,cIdx,
-                                         &tctx->ctx_model[CONTEXT_MODEL_LAST_SIGNIFICANT_COEFFICIENT_Y_PREFIX]);
-
-
-  // TODO: we can combine both FL-bypass calls into one, but the gain may be limited...
-
-  int LastSignificantCoeffX;
-  if (last_significant_coeff_x_prefix > 3) {
-    int nBits = (last_significant_coeff_x_prefix>>1)-1;
-    int last_significant_coeff_x_suffix = decode_CABAC_FL_bypass(&tctx->cabac_decoder,nBits);
-
-    LastSignificantCoeffX =
-      ((2+(last_significant_coeff_x_prefix & 1)) << nBits) + last_significant_coeff_x_suffix;
-  }
-  else {
-    LastSignificantCoeffX = last_significant_coeff_x_prefix;
-  }
-
-  int LastSignificantCoeffY;
-  if (last_significant_coeff_y_prefix > 3) {
-    int nBits = (last_significant_coeff_y_prefix>>1)-1;
-    int last_significant_coeff_y_suffix = decode_CABAC_FL_bypass(&tctx->cabac_decoder,nBits);
-
-    LastSignificantCoeffY =
-      ((2+(last_significant_coeff_y_prefix & 1)) << nBits) + last_significant_coeff_y_suffix;
-  }
-  else {
-    LastSignificantCoeffY = last_significant_coeff_y_prefix;
-  }
-
-
-
-  // --- determine scanIdx ---
-
-  int scanIdx;
-
-  if (PredMode == MODE_INTRA) {
-    if (cIdx==0) {
-      scanIdx = get_intra_scan_idx(log2TrafoSize, img->get_IntraPredMode(x0,y0),  cIdx, &sps);
-      //printf("luma scan idx=%d <- intra mode=%d\n",scanIdx, img->get_IntraPredMode(x0,y0));
-    }
-    else {
-      scanIdx = get_intra_scan_idx(log2TrafoSize, img->get_IntraPredModeC(x0,y0), cIdx, &sps);
-      //printf("chroma scan idx=%d <- intra mode=%d chroma:%d trsize:%d\n",scanIdx,
-      //       img->get_IntraPredModeC(x0,y0), sps->chroma_format_idc, 1<<log2TrafoSize);
-    }
-  }
-  else {
-    scanIdx=0;
-  }
-
-  if (scanIdx==2) {
-    std::swap(LastSignificantCoeffX, LastSignificantCoeffY);
-  }
-
-  logtrace(LogSlice,"LastSignificantCoeff: x=%d;y=%d\n",LastSignificantCoeffX,LastSignificantCoeffY);
-
   const position* ScanOrderSub = get_scan_order(log2TrafoSize-2, scanIdx);
   const position* ScanOrderPos = get_scan_order(2, scanIdx);
 
@@ -3034,17 +3020,8 @@ int residual_coding(thread_context* tctx,
   logtrace(LogSlice,"*\n");
 
 
-  // --- find last sub block and last scan pos ---
-
   int xC,yC;
 
-  scan_position lastScanP = get_scan_position(LastSignificantCoeffX, LastSignificantCoeffY,
-                                              scanIdx, log2TrafoSize);
-
-  int lastScanPos  = lastScanP.scanPos;
-  int lastSubBlock = lastScanP.subBlock;
-
-
   int sbWidth = 1<<(log2TrafoSize-2);
 
   uint8_t coded_sub_block_neighbors[32/4*32/4];
@@ -3071,7 +3048,7 @@ int residual_coding(thread_context* tctx,
 
   // ----- decode coefficients -----
 
-  tctx->nCoeff[cIdx] = 0;
+  int nCoeff = 0;
 
 
   // i - subblock index
@@ -3089,7 +3066,7 @@ int residual_coding(thread_context* tctx,
     int sub_block_is_coded = 0;
 
     if ((i<lastSubBlock) && (i>0)) {
-      sub_block_is_coded = decode_coded_sub_block_flag(tctx, cIdx,
+      sub_block_is_coded = decode_coded_sub_block_flag(decoder, model, cIdx,
                                                        coded_sub_block_neighbors[S.x+S.y*sbWidth]);
       inferSbDcSigCoeffFlag=1;
     }
@@ -3152,8 +3129,7 @@ int residual_coding(thread_context* tctx,
         // for all AC coefficients in sub-block, a significant_coeff flag is coded
 
         int ctxInc;
-        if (sps.range_extension.transform_skip_context_enabled_flag &&
-            (tctx->cu_transquant_bypass_flag || tctx->transform_skip_flag[cIdx])) {
+        if (transformSkipContext) {
           ctxInc = ( cIdx == 0 ) ? 42 : (16+27);
         }
         else {
@@ -3162,7 +3138,7 @@ int residual_coding(thread_context* tctx,
 
         logtrace(LogSlice,"trafoSize: %d\n",1<<log2TrafoSize);
 
-        int significant_coeff = decode_significant_coeff_flag_lookup(tctx, ctxInc);
+        int significant_coeff = decode_significant_coeff_flag_lookup(decoder, model, ctxInc);
 
         if (significant_coeff) {
           coeff_value[nCoefficients] = 1;
@@ -3185,15 +3161,14 @@ int residual_coding(thread_context* tctx,
             // if we cannot infert the DC coefficient, it is coded
 
             int ctxInc;
-            if (sps.range_extension.transform_skip_context_enabled_flag &&
-                (tctx->cu_transquant_bypass_flag || tctx->transform_skip_flag[cIdx])) {
+            if (transformSkipContext) {
               ctxInc = ( cIdx == 0 ) ? 42 : (16+27);
             }
             else {
               ctxInc = ctxIdxMap[x0+(y0<<log2TrafoSize)];
             }
 
-            int significant_coeff = decode_significant_coeff_flag_lookup(tctx, ctxInc);
+            int significant_coeff = decode_significant_coeff_flag_lookup(decoder, model, ctxInc);
 
 
             if (significant_coeff) {
@@ -3243,7 +3218,7 @@ int residual_coding(thread_context* tctx,
       int lastGreater1Coefficient = libde265_min(8,nCoefficients);
       for (int c=0;c<lastGreater1Coefficient;c++) {
         int greater1_flag =
-          decode_coeff_abs_level_greater1(tctx, cIdx,i,
+          decode_coeff_abs_level_greater1(decoder, model, cIdx,i,
                                           c==0,
                                           firstSubblock,
                                           lastSubblock_greater1Ctx,
@@ -3276,7 +3251,7 @@ int residual_coding(thread_context* tctx,
       // --- decode greater-2 flag ---
 
       if (newLastGreater1ScanPos != -1) {
-        int flag = decode_coeff_abs_level_greater2(tctx,cIdx, lastInvocation_ctxSet);
+        int flag = decode_coeff_abs_level_greater2(decoder, model, cIdx, lastInvocation_ctxSet);
         coeff_value[newLastGreater1ScanPos] += flag;
         coeff_has_max_base_level[newLastGreater1ScanPos] = flag;
       }
@@ -3284,37 +3259,18 @@ int residual_coding(thread_context* tctx,
 
       // --- decode coefficient signs ---
 
-      int signHidden;
-
-
-      IntraPredMode predModeIntra;
-      if (cIdx==0) predModeIntra = img->get_IntraPredMode(x0,y0);
-      else         predModeIntra = img->get_IntraPredModeC(x0,y0);
-
-
-      if (tctx->cu_transquant_bypass_flag ||
-          (PredMode == MODE_INTRA &&
-           sps.range_extension.implicit_rdpcm_enabled_flag &&
-           tctx->transform_skip_flag[cIdx] &&
-           ( predModeIntra == 10 || predModeIntra == 26 )) ||
-          tctx->explicit_rdpcm_flag)
-        {
-          signHidden = 0;
-        }
-      else
-        {
-          signHidden = (coeff_scan_pos[0]-coeff_scan_pos[nCoefficients-1] > 3);
-        }
+      int signHidden = (signHiding &&
+                        coeff_scan_pos[0]-coeff_scan_pos[nCoefficients-1] > 3);
 
 
       for (int n=0;n<nCoefficients-1;n++) {
-        coeff_sign[n] = decode_CABAC_bypass(&tctx->cabac_decoder);
+        coeff_sign[n] = decode_CABAC_bypass(decoder);
         logtrace(LogSlice,"sign[%d] = %d\n", n, coeff_sign[n]);
       }
 
       // n==nCoefficients-1
-      if (!pps.sign_data_hiding_flag || !signHidden) {
-        coeff_sign[nCoefficients-1] = decode_CABAC_bypass(&tctx->cabac_decoder);
+      if (!signHidden) {
+        coeff_sign[nCoefficients-1] = decode_CABAC_bypass(decoder);
         logtrace(LogSlice,"sign[%d] = %d\n", nCoefficients-1, coeff_sign[nCoefficients-1]);
       }
       else {
@@ -3327,11 +3283,11 @@ int residual_coding(thread_context* tctx,
       int sumAbsLevel=0;
       int uiGoRiceParam;
 
-      if (sps.range_extension.persistent_rice_adaptation_enabled_flag==0) {
+      if (StatCoeff==NULL) {
         uiGoRiceParam = 0;
       }
       else {
-        uiGoRiceParam = tctx->StatCoeff[sbType]/4;
+        uiGoRiceParam = *StatCoeff/4;
       }
 
       // printf("initial uiGoRiceParam=%d\n",uiGoRiceParam);
@@ -3346,9 +3302,9 @@ int residual_coding(thread_context* tctx,
 
         if (coeff_has_max_base_level[n]) {
           coeff_abs_level_remaining =
-            decode_coeff_abs_level_remaining(tctx, uiGoRiceParam);
+            decode_coeff_abs_level_remaining(decoder, uiGoRiceParam);
 
-          if (sps.range_extension.persistent_rice_adaptation_enabled_flag == 0) {
+          if (StatCoeff==NULL) {
             // (2014.10 / 9-20)
             if (baseLevel + coeff_abs_level_remaining > 3*(1<<uiGoRiceParam)) {
               uiGoRiceParam++;
@@ -3361,14 +3317,14 @@ int residual_coding(thread_context* tctx,
           }
 
           // persistent_rice_adaptation_enabled_flag
-          if (sps.range_extension.persistent_rice_adaptation_enabled_flag &&
+          if (StatCoeff != NULL &&
               firstCoeffWithAbsLevelRemaining) {
-            if (coeff_abs_level_remaining >= (3 << (tctx->StatCoeff[sbType]/4 ))) {
-              tctx->StatCoeff[sbType]++;
+            if (coeff_abs_level_remaining >= (3 << (*StatCoeff/4 ))) {
+              (*StatCoeff)++;
             }
-            else if (2*coeff_abs_level_remaining < (1 << (tctx->StatCoeff[sbType]/4 )) &&
-                     tctx->StatCoeff[sbType] > 0) {
-              tctx->StatCoeff[sbType]--;
+            else if (2*coeff_abs_level_remaining < (1 << (*StatCoeff/4 )) &&
+                     *StatCoeff > 0) {
+              (*StatCoeff)--;
             }
           }
 
@@ -3386,7 +3342,7 @@ int residual_coding(thread_context* tctx,
           currCoeff = -currCoeff;
         }
 
-        if (pps.sign_data_hiding_flag && signHidden) {
+        if (signHidden) {
           sumAbsLevel += baseLevel + coeff_abs_level_remaining;
 
           if (n==nCoefficients-1 && (sumAbsLevel & 1)) {
@@ -3405,9 +3361,9 @@ int residual_coding(thread_context* tctx,
         xC = (S.x<<2) + ScanOrderPos[p].x;
         yC = (S.y<<2) + ScanOrderPos[p].y;
 
-        tctx->coeffList[cIdx][ tctx->nCoeff[cIdx] ] = currCoeff;
-        tctx->coeffPos [cIdx][ tctx->nCoeff[cIdx] ] = xC + yC*CoeffStride;
-        tctx->nCoeff[cIdx]++;
+        coeffList[nCoeff] = currCoeff;
+        coeffPos [nCoeff] = xC + yC*CoeffStride;
+        nCoeff++;
 
         //printf("%d ",currCoeff);
       }  // iterate through coefficients in sub-block
@@ -3417,6 +3373,375 @@ int residual_coding(thread_context* tctx,
     }  // if nonZero
   }  // next sub-block
 
+  return nCoeff;
+}
+
+
+/* Coefficient parser specialized for TU size, scan order and luma/chroma.
+   All context indices come from precomputed tables. The range-extension
+   coding tools (transform_skip_context, persistent_rice_adaptation) are not
+   supported here, these go through decode_residual_coefficients_generic().
+ */
+template <int log2TrafoSize, int scanIdx, bool chroma>
+int decode_residual_coefficients(CABAC_decoder* decoder,
+                                 context_model* model,
+                                 int lastSubBlock, int lastScanPos,
+                                 bool signHiding,
+                                 int16_t* coeffList, int16_t* coeffPos)
+{
+  const int log2SbWidth = log2TrafoSize-2;
+  const int sbWidth = 1<<log2SbWidth;
+
+  const residual_scan_table& table = residual_scan_tables[log2TrafoSize-2][scanIdx];
+
+  context_model* sigModel      = &model[CONTEXT_MODEL_SIGNIFICANT_COEFF_FLAG];
+  context_model* csbfModel     = &model[CONTEXT_MODEL_CODED_SUB_BLOCK_FLAG + (chroma ? 2 : 0)];
+  context_model* greater1Model = &model[CONTEXT_MODEL_COEFF_ABS_LEVEL_GREATER1_FLAG + (chroma ? 16 : 0)];
+  context_model* greater2Model = &model[CONTEXT_MODEL_COEFF_ABS_LEVEL_GREATER2_FLAG + (chroma ? 4 : 0)];
+
+  uint8_t coded_sub_block_neighbors[sbWidth*sbWidth];
+  memset(coded_sub_block_neighbors,0,sbWidth*sbWidth);
+
+  int nCoeff = 0;
+  int c1 = 1;
+
+  for (int i=lastSubBlock;i>=0;i--) {
+    int sbPos    = table.subBlockPos[i];
+    int prevCsbf = coded_sub_block_neighbors[sbPos];
+
+    // --- coded_sub_block_flag (first and last sub-block are always coded) ---
+
+    bool inferSbDcSigCoeffFlag = false;
+
+    if (i<lastSubBlock && i>0) {
+      int csbfCtx = (prevCsbf & 1) | (prevCsbf >> 1);
+      if (!decode_CABAC_bit(decoder, &csbfModel[csbfCtx])) {
+        continue;
+      }
+
+      inferSbDcSigCoeffFlag = true;
+    }
+
+    if (sbWidth>1) {
+      if ((sbPos & (sbWidth-1)) > 0) coded_sub_block_neighbors[sbPos-1]       |= 1;
+      if ((sbPos >> log2SbWidth) > 0) coded_sub_block_neighbors[sbPos-sbWidth] |= 2;
+    }
+
+
+    // --- significant_coeff_flags ---
+
+    const uint8_t* sigCtx = table.sigCtx[chroma][i==0][prevCsbf];
+
+    int8_t scanPos[16];
+    int nCoefficients=0;
+
+    int n=15;
+    if (i==lastSubBlock) {
+      scanPos[nCoefficients++] = lastScanPos;
+      n = lastScanPos-1;
+    }
+
+    for ( ; n>0 ; n--) {
+      if (decode_CABAC_bit(decoder, &sigModel[sigCtx[n]])) {
+        scanPos[nCoefficients++] = n;
+        inferSbDcSigCoeffFlag = false;
+      }
+    }
+
+    if (n==0) { // otherwise, the last coefficient was the DC coefficient
+      if (inferSbDcSigCoeffFlag ||
+          decode_CABAC_bit(decoder, &sigModel[sigCtx[0]])) {
+        scanPos[nCoefficients++] = 0;
+      }
+    }
+
+    if (nCoefficients==0) {
+      continue;
+    }
+
+
+    // --- greater1 / greater2 flags ---
+
+    int ctxSet = (i==0 || chroma) ? 0 : 2;
+    if (c1==0) { ctxSet++; }
+    c1=1;
+
+    int16_t baseLevel[16];
+    int firstGreater1 = -1;
+
+    int nGreater1Flags = libde265_min(8,nCoefficients);
+    for (int c=0;c<nGreater1Flags;c++) {
+      int greater1_flag = decode_CABAC_bit(decoder, &greater1Model[ctxSet*4 + c1]);
+      baseLevel[c] = 1+greater1_flag;
+
+      if (greater1_flag) {
+        c1=0;
+        if (firstGreater1<0) { firstGreater1=c; }
+      }
+      else if (c1>0 && c1<3) {
+        c1++;
+      }
+    }
+
+    for (int c=nGreater1Flags;c<nCoefficients;c++) {
+      baseLevel[c] = 1;
+    }
+
+    if (firstGreater1>=0) {
+      baseLevel[firstGreater1] += decode_CABAC_bit(decoder, &greater2Model[ctxSet]);
+    }
+
+
+    // --- signs, all in one go ---
+
+    bool signHidden = (signHiding && scanPos[0]-scanPos[nCoefficients-1] > 3);
+    int  nSigns = nCoefficients - signHidden;
+
+    uint32_t signs = decode_CABAC_FL_bypass(decoder, nSigns);
+    signs <<= 32-nSigns;
+
+
+    // --- remaining levels ---
+
+    int riceParam = 0;
+    int sumAbsLevel = 0;
+
+    for (int c=0;c<nCoefficients;c++) {
+      int level = baseLevel[c];
+
+      // only coefficients at the maximum base level have a remaining level
+      int maxBaseLevel = (c>=8) ? 1 : (c==firstGreater1) ? 3 : 2;
+
+      if (level == maxBaseLevel) {
+        int coeff_abs_level_remaining = decode_coeff_abs_level_remaining(decoder, riceParam);
+
+        if (level + coeff_abs_level_remaining > 3*(1<<riceParam)) {
+          riceParam = libde265_min(riceParam+1, 4);
+        }
+
+        level += coeff_abs_level_remaining;
+      }
+
+      int16_t currCoeff = level;
+      if (signs & 0x80000000) {
+        currCoeff = -currCoeff;
+      }
+      signs <<= 1;
+
+      if (signHidden) {
+        sumAbsLevel += level;
+
+        if (c==nCoefficients-1 && (sumAbsLevel & 1)) {
+          currCoeff = -currCoeff;
+        }
+      }
+
+      coeffList[nCoeff] = currCoeff;
+      coeffPos [nCoeff] = table.coeffPos[i][scanPos[c]];
+      nCoeff++;
+    }
+  }
+
+  return nCoeff;
+}
+
+
+#define RESIDUAL_PARSERS(log2,scan) \
+  { decode_residual_coefficients<log2,scan,false>, decode_residual_coefficients<log2,scan,true> }
+
+const residual_coefficients_func residual_coefficients_parser[4][3][2] = {
+  { RESIDUAL_PARSERS(2,0), RESIDUAL_PARSERS(2,1), RESIDUAL_PARSERS(2,2) },
+  { RESIDUAL_PARSERS(3,0), RESIDUAL_PARSERS(3,1), RESIDUAL_PARSERS(3,2) },
+  { RESIDUAL_PARSERS(4,0), RESIDUAL_PARSERS(4,1), RESIDUAL_PARSERS(4,2) },
+  { RESIDUAL_PARSERS(5,0), RESIDUAL_PARSERS(5,1), RESIDUAL_PARSERS(5,2) }
+};
+
+#undef RESIDUAL_PARSERS
+
+
+int residual_coding(thread_context* tctx,
+                    int x0, int y0,  // position of TU in frame
+                    int log2TrafoSize,
+                    int cIdx)
+{
+  set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_residual);
+
+  logtrace(LogSlice,"- residual_coding x0:%d y0:%d log2TrafoSize:%d cIdx:%d\n",x0,y0,log2TrafoSize,cIdx);
+
+  //slice_segment_header* shdr = tctx->shdr;
+
+  de265_image* img = tctx->img;
+  const seq_parameter_set& sps = img->get_sps();
+  const pic_parameter_set& pps = img->get_pps();
+
+  enum PredMode PredMode = img->get_pred_mode(x0,y0);
+
+  if (cIdx==0) {
+    img->set_nonzero_coefficient(x0,y0,log2TrafoSize);
+  }
+
+
+  if (pps.transform_skip_enabled_flag &&
+      !tctx->cu_transquant_bypass_flag &&
+      (log2TrafoSize <= pps.Log2MaxTransformSkipSize))
+    {
+      tctx->transform_skip_flag[cIdx] = decode_transform_skip_flag(tctx,cIdx);
+    }
+  else
+    {
+      tctx->transform_skip_flag[cIdx] = 0;
+    }
+
+
+  tctx->explicit_rdpcm_flag = false;
+
+  if (PredMode == MODE_INTER && sps.range_extension.explicit_rdpcm_enabled_flag &&
+      ( tctx->transform_skip_flag[cIdx] || tctx->cu_transquant_bypass_flag))
+    {
+      tctx->explicit_rdpcm_flag = decode_explicit_rdpcm_flag(tctx,cIdx);
+      if (tctx->explicit_rdpcm_flag) {
+        tctx->explicit_rdpcm_dir = decode_explicit_rdpcm_dir(tctx,cIdx);
+      }
+
+      //printf("EXPLICIT RDPCM %d;%d\n",x0,y0);
+    }
+  else
+    {
+      tctx->explicit_rdpcm_flag = false;
+    }
+
+
+
+  // sbType for persistent_rice_adaptation_enabled_flag
+
+  int sbType = (cIdx==0) ? 2 : 0;
+  if (tctx->transform_skip_flag[cIdx] || tctx->cu_transquant_bypass_flag) {
+    sbType++;
+  }
+
+
+  // --- decode position of last coded coefficient ---
+
+  int last_significant_coeff_x_prefix =
+    decode_last_significant_coeff_prefix(tctx,log2TrafoSize,cIdx,
+                                         &tctx->ctx_model[CONTEXT_MODEL_LAST_SIGNIFICANT_COEFFICIENT_X_PREFIX]);
+
+  int last_significant_coeff_y_prefix =
+    decode_last_significant_coeff_prefix(tctx,log2TrafoSize,cIdx,
+                                         &tctx->ctx_model[CONTEXT_MODEL_LAST_SIGNIFICANT_COEFFICIENT_Y_PREFIX]);
+
+
+  // TODO: we can combine both FL-bypass calls into one, but the gain may be limited...
+
+  int LastSignificantCoeffX;
+  if (last_significant_coeff_x_prefix > 3) {
+    int nBits = (last_significant_coeff_x_prefix>>1)-1;
+    int last_significant_coeff_x_suffix = decode_CABAC_FL_bypass(&tctx->cabac_decoder,nBits);
+
+    LastSignificantCoeffX =
+      ((2+(last_significant_coeff_x_prefix & 1)) << nBits) + last_significant_coeff_x_suffix;
+  }
+  else {
+    LastSignificantCoeffX = last_significant_coeff_x_prefix;
+  }
+
+  int LastSignificantCoeffY;
+  if (last_significant_coeff_y_prefix > 3) {
+    int nBits = (last_significant_coeff_y_prefix>>1)-1;
+    int last_significant_coeff_y_suffix = decode_CABAC_FL_bypass(&tctx->cabac_decoder,nBits);
+
+    LastSignificantCoeffY =
+      ((2+(last_significant_coeff_y_prefix & 1)) << nBits) + last_significant_coeff_y_suffix;
+  }
+  else {
+    LastSignificantCoeffY = last_significant_coeff_y_prefix;
+  }
+
+
+
+  // --- determine scanIdx ---
+
+  int scanIdx;
+
+  if (PredMode == MODE_INTRA) {
+    if (cIdx==0) {
+      scanIdx = get_intra_scan_idx(log2TrafoSize, img->get_IntraPredMode(x0,y0),  cIdx, &sps);
+      //printf("luma scan idx=%d <- intra mode=%d\n",scanIdx, img->get_IntraPredMode(x0,y0));
+    }
+    else {
+      scanIdx = get_intra_scan_idx(log2TrafoSize, img->get_IntraPredModeC(x0,y0), cIdx, &sps);
+      //printf("chroma scan idx=%d <- intra mode=%d chroma:%d trsize:%d\n",scanIdx,
+      //       img->get_IntraPredModeC(x0,y0), sps->chroma_format_idc, 1<<log2TrafoSize);
+    }
+  }
+  else {
+    scanIdx=0;
+  }
+
+  if (scanIdx==2) {
+    std::swap(LastSignificantCoeffX, LastSignificantCoeffY);
+  }
+
+  logtrace(LogSlice,"LastSignificantCoeff: x=%d;y=%d\n",LastSignificantCoeffX,LastSignificantCoeffY);
+
+  // --- find last sub block and last scan pos ---
+
+  scan_position lastScanP = get_scan_position(LastSignificantCoeffX, LastSignificantCoeffY,
+                                              scanIdx, log2TrafoSize);
+
+  int lastScanPos  = lastScanP.scanPos;
+  int lastSubBlock = lastScanP.subBlock;
+
+
+  tctx->lastSubBlock[cIdx] = lastSubBlock;
+
+
+  // --- decode coefficients ---
+
+  bool transformSkipContext = (sps.range_extension.transform_skip_context_enabled_flag &&
+                               (tctx->cu_transquant_bypass_flag || tctx->transform_skip_flag[cIdx]));
+
+  bool signHiding = pps.sign_data_hiding_flag;
+  if (tctx->cu_transquant_bypass_flag || tctx->explicit_rdpcm_flag) {
+    signHiding = false;
+  }
+  else if (PredMode == MODE_INTRA &&
+           sps.range_extension.implicit_rdpcm_enabled_flag &&
+           tctx->transform_skip_flag[cIdx]) {
+    IntraPredMode predModeIntra;
+    if (cIdx==0) predModeIntra = img->get_IntraPredMode(x0,y0);
+    else         predModeIntra = img->get_IntraPredModeC(x0,y0);
+
+    if (predModeIntra == 10 || predModeIntra == 26) {
+      signHiding = false;
+    }
+  }
+
+  uint8_t* StatCoeff = NULL;
+  if (sps.range_extension.persistent_rice_adaptation_enabled_flag) {
+    StatCoeff = &tctx->StatCoeff[sbType];
+  }
+
+  if (!transformSkipContext && StatCoeff==NULL) {
+    tctx->nCoeff[cIdx] =
+      residual_coefficients_parser[log2TrafoSize-2][scanIdx][cIdx ? 1 : 0](&tctx->cabac_decoder,
+                                                                          &tctx->ctx_model[0],
+                                                                          lastSubBlock, lastScanPos,
+                                                                          signHiding,
+                                                                          tctx->coeffList[cIdx],
+                                                                          tctx->coeffPos[cIdx]);
+  }
+  else {
+    tctx->nCoeff[cIdx] =
+      decode_residual_coefficients_generic(&tctx->cabac_decoder, &tctx->ctx_model[0],
+                                           log2TrafoSize, cIdx, scanIdx,
+                                           lastSubBlock, lastScanPos,
+                                           signHiding, transformSkipContext, StatCoeff,
+                                           tctx->coeffList[cIdx], tctx->coeffPos[cIdx]);
+  }
+
+  tctx->ctb_num_coefficients += tctx->nCoeff[cIdx];
+
   return DE265_OK;
 }
 
@@ -3450,7 +3775,10 @@ static void decode_TU(thread_context* tctx,
         intraPredMode = INTRA_DC;
       }
 
-      decode_intra_prediction(img, x0,y0, intraPredMode, nT, cIdx);
+      {
+        stage_timer timer(tctx->timing, STAGE_INTRA_PREDICTION);
+        decode_intra_prediction(img, x0,y0, intraPredMode, nT, cIdx);
+      }
 
 
       residualDpcm = sps.range_extension.implicit_rdpcm_enabled_flag &&
@@ -3467,6 +3795,8 @@ static void decode_TU(thread_context* tctx,
       }
     }
 
+  stage_timer timer(tctx->timing, STAGE_RESIDUAL);
+
   if (cbf) {
     scale_coefficients(tctx, x0,y0, xCUBase,yCUBase, nT, cIdx,
                        tctx->transform_skip_flag[cIdx], cuPredMode==MODE_INTRA, residualDpcm);
@@ -3480,6 +3810,7 @@ static void decode_TU(thread_context* tctx,
     // --- cross-component-prediction when CBF==0 ---
 
     tctx->nCoeff[cIdx] = 0;
+    tctx->lastSubBlock[cIdx] = 0;
     residualDpcm=0;
 
     scale_coefficients(tctx, x0,y0, xCUBase,yCUBase, nT, cIdx,
@@ -3529,6 +3860,8 @@ static int decode_res_scale_sign_flag(thread_context* tctx, int cIdxMinus1)
 
 static void read_cross_comp_pred(thread_context* tctx, int cIdxMinus1)
 {
+  set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_residual);
+
   int log2_res_scale_abs_plus1 = decode_log2_res_scale_abs_plus1(tctx,cIdxMinus1);
   int ResScaleVal;
 
@@ -3562,6 +3895,8 @@ int read_transform_unit(thread_context* tctx,
   assert(cbf_cr != -1);
   assert(cbf_luma != -1);
 
+  tctx->ctb_num_TUs++;
+
   const seq_parameter_set& sps = tctx->img->get_sps();
 
   const int ChromaArrayType = sps.ChromaArrayType;
@@ -3611,6 +3946,8 @@ int read_transform_unit(thread_context* tctx,
           !tctx->cu_transquant_bypass_flag && !tctx->IsCuChromaQpOffsetCoded ) {
         logtrace(LogSlice,"# cu_chroma_qp_offset_flag\n");
 
+        set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_delta_QP);
+
         int cu_chroma_qp_offset_flag = decode_CABAC_bit(&tctx->cabac_decoder,
                                                         &tctx->ctx_model[CONTEXT_MODEL_CU_CHROMA_QP_OFFSET_FLAG]);
 
@@ -3986,6 +4323,8 @@ const char* part_mode_name(enum PartMode pm)
 void read_mvd_coding(thread_context* tctx,
                      int x0,int y0, int refList)
 {
+  set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_MVD);
+
   int abs_mvd_greater0_flag[2];
   abs_mvd_greater0_flag[0] = decode_CABAC_bit(&tctx->cabac_decoder,
                                               &tctx->ctx_model[CONTEXT_MODEL_ABS_MVD_GREATER01_FLAG+0]);
@@ -4075,6 +4414,8 @@ void read_prediction_unit(thread_context* tctx,
   tctx->motion.merge_flag = merge_flag;
 
   if (merge_flag) {
+    tctx->stats.num_PUs_merge++;
+
     int merge_idx = decode_merge_idx(tctx);
 
     logtrace(LogSlice,"prediction unit %d,%d, merge mode, index: %d\n",x0,y0,merge_idx);
@@ -4082,6 +4423,8 @@ void read_prediction_unit(thread_context* tctx,
     tctx->motion.merge_idx = merge_idx;
   }
   else { // no merge flag
+    tctx->stats.num_PUs_AMVP++;
+
     enum InterPredIdc inter_pred_idc;
 
     if (shdr->slice_type == SLICE_TYPE_B) {
@@ -4133,6 +4476,8 @@ void read_prediction_unit(thread_context* tctx,
 
 
 
+  stage_timer timer(tctx->timing, STAGE_INTER_PREDICTION);
+
   decode_prediction_unit(tctx->decctx, tctx->shdr, tctx->img, tctx->motion,
                          xC,yC,xB,yB, nCS, nPbW,nPbH, partIdx);
 }
@@ -4185,8 +4530,8 @@ void read_pcm_samples_internal(thread_context* tctx, int x0, int y0, int log2CbS
 static void read_pcm_samples(thread_context* tctx, int x0, int y0, int log2CbSize)
 {
   bitreader br;
-  br.data            = tctx->cabac_decoder.bitstream_curr;
-  br.bytes_remaining = tctx->cabac_decoder.bitstream_end - tctx->cabac_decoder.bitstream_curr;
+  br.data            = get_CABAC_bitstream_position(&tctx->cabac_decoder);
+  br.bytes_remaining = tctx->cabac_decoder.bitstream_end - br.data;
   br.nextbits = 0;
   br.nextbits_cnt = 0;
 
@@ -4208,7 +4553,13 @@ static void read_pcm_samples(thread_context* tctx, int x0, int y0, int log2CbSiz
   }
 
   prepare_for_CABAC(&br);
-  tctx->cabac_decoder.bitstream_curr = br.data;
+
+#ifdef DE265_BIT_ACCOUNTING
+  tctx->cabac_decoder.bits[de265_bits_PCM] +=
+    (br.data - get_CABAC_bitstream_position(&tctx->cabac_decoder)) << (3+CABAC_BIT_SHIFT);
+#endif
+
+  set_CABAC_bitstream_position(&tctx->cabac_decoder, br.data);
   init_CABAC_decoder_2(&tctx->cabac_decoder);
 }
 
@@ -4295,6 +4646,7 @@ void read_coding_unit(thread_context* tctx,
 
   if (cu_skip_flag) {
     read_prediction_unit_SKIP(tctx,x0,y0,nCbS,nCbS);
+    tctx->stats.num_PUs_skip++;
 
     img->set_PartMode(x0,y0, PART_2Nx2N); // need this for deblocking filter
     img->set_pred_mode(x0,y0,log2CbSize, MODE_SKIP);
@@ -4306,6 +4658,8 @@ void read_coding_unit(thread_context* tctx,
     // DECODE
 
     int nCS_L = 1<<log2CbSize;
+
+    stage_timer timer(tctx->timing, STAGE_INTER_PREDICTION);
     decode_prediction_unit(tctx->decctx,tctx->shdr,tctx->img,tctx->motion,
                            x0,y0, 0,0, nCS_L, nCS_L,nCS_L, 0);
   }
@@ -4344,9 +4698,12 @@ void read_coding_unit(thread_context* tctx,
     bool pcm_flag = false;
 
     if (cuPredMode == MODE_INTRA) {
+      tctx->stats.num_PUs_intra += (PartMode == PART_NxN ? 4 : 1);
+
       if (PartMode == PART_2Nx2N && sps.pcm_enabled_flag &&
           log2CbSize >= sps.Log2MinIpcmCbSizeY &&
           log2CbSize <= sps.Log2MaxIpcmCbSizeY) {
+        set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_CU_header);
         pcm_flag = decode_CABAC_term_bit(&tctx->cabac_decoder);
       }
 
@@ -4398,12 +4755,9 @@ void read_coding_unit(thread_context* tctx,
               int availableB = availableB0 || (j>0); // top candidate always available for bottom blk
 
 
-
-              int PUidx = (x>>sps.Log2MinPUSize) + (y>>sps.Log2MinPUSize)*sps.PicWidthInMinPUs;
-
               enum IntraPredMode candModeList[3];
 
-              fillIntraPredModeCandidates(candModeList,x,y,PUidx,
+              fillIntraPredModeCandidates(candModeList,x,y,
                                           availableA, availableB, img);
 
               for (int i=0;i<3;i++)
@@ -4435,7 +4789,7 @@ void read_coding_unit(thread_context* tctx,
 
               logtrace(LogSlice,"IntraPredMode[%d][%d] = %d (log2blk:%d)\n",x,y,IntraPredMode, log2IntraPredSize);
 
-              img->set_IntraPredMode(PUidx, log2IntraPredSize,
+              img->set_IntraPredMode(x,y, log2IntraPredSize,
                                      (enum IntraPredMode)IntraPredMode);
 
               idx++;
@@ -4573,6 +4927,29 @@ void read_coding_unit(thread_context* tctx,
       }
     } // !pcm
   }
+
+  // picture statistics (the QP is final after the transform tree)
+
+  picture_stats& stats = tctx->stats;
+  const int area = 1<<(2*(log2CbSize-3));
+  stats.num_CUs[log2CbSize-3]++;
+  stats.QP_area_sum += tctx->currentQPY * area;
+  stats.area        += area;
+
+#ifdef DE265_BIT_ACCOUNTING
+  // the bits since the previous CU (including SAO and split flags) belong to this CU
+
+  CU_bits& cuBits = img->get_CU_bits(x0,y0);
+  CABAC_decoder* decoder = &tctx->cabac_decoder;
+
+  for (int i=0;i<de265_num_bit_categories;i++) {
+    cuBits.bits[i] = decoder->bits[i];
+    stats.bits[i] += decoder->bits[i];
+    decoder->bits[i] = 0;
+  }
+
+  cuBits.log2CbSize = log2CbSize;
+#endif
 }
 
 
@@ -4733,7 +5110,27 @@ enum DecodeResult decode_substream(thread_context* tctx,
       return Decode_Error;
     }
 
-    read_coding_tree_unit(tctx);
+    de265_ctb_cost* cost = tctx->img->get_ctb_cost_ptr(ctbx+ctby*ctbW);
+
+    const int64_t ctbBitStart = CABAC_bit_position(&tctx->cabac_decoder);
+    int64_t ctbStartTime = 0;
+    if (cost) {
+      tctx->ctb_num_TUs = 0;
+      tctx->ctb_num_coefficients = 0;
+      ctbStartTime = stage_timing::now();
+    }
+
+    {
+      stage_timer timer(tctx->timing, STAGE_CTU);
+      read_coding_tree_unit(tctx);
+    }
+
+    if (cost) {
+      cost->time_ns = stage_timing::now() - ctbStartTime;
+      cost->bits    = CABAC_bit_position(&tctx->cabac_decoder) - ctbBitStart;
+      cost->num_TUs = tctx->ctb_num_TUs;
+      cost->num_coefficients = tctx->ctb_num_coefficients;
+    }
 
 
     // save CABAC-model for WPP (except in last CTB row)
@@ -4754,6 +5151,8 @@ enum DecodeResult decode_substream(thread_context* tctx,
 
     // end of slice segment ?
 
+    set_CABAC_bit_category(&tctx->cabac_decoder, de265_bits_other);
+
     int end_of_slice_segment_flag = decode_CABAC_term_bit(&tctx->cabac_decoder);
     //printf("end-of-slice flag: %d\n", end_of_slice_segment_flag);
 
@@ -4934,6 +5333,10 @@ void thread_task_slice_segment::work()
 
   /*enum DecodeResult result =*/ decode_substream(tctx, false, data->firstSliceSubstream);
 
+  tctx->decctx->add_stage_timing(tctx->timing);
+  tctx->collect_remaining_bits();
+  img->add_stats(tctx->stats);
+
   state = Finished;
   tctx->sliceunit->finished_threads.increase_progress(1);
   img->thread_finishes(this);
@@ -4985,6 +5388,10 @@ void thread_task_ctb_row::work()
   /*enum DecodeResult result =*/
   decode_substream(tctx, true, firstIndependentSubstream);
 
+  tctx->decctx->add_stage_timing(tctx->timing);
+  tctx->collect_remaining_bits();
+  img->add_stats(tctx->stats);
+
   // mark progress on remaining CTBs in row (in case of decoder error and early termination)
 
   // TODO: what about slices that end properly in the middle of a CTB row?
@@ -5037,7 +5444,8 @@ de265_error read_slice_segment_data(thread_context* tctx)
 
     if (substream>0) {
       if (substream-1 >= tctx->shdr->entry_point_offset.size() ||
-          tctx->cabac_decoder.bitstream_curr - tctx->cabac_decoder.bitstream_start -2 /* -2 because of CABAC init */
+          get_CABAC_bitstream_position(&tctx->cabac_decoder)
+          - tctx->cabac_decoder.bitstream_start -2 /* -2 because of CABAC init */
           != tctx->shdr->entry_point_offset[substream-1]) {
         tctx->decctx->add_warning(DE265_WARNING_INCORRECT_ENTRY_POINT_OFFSET, true);
       }
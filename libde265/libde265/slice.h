@@ -284,6 +284,30 @@ bool alloc_and_init_significant_coeff_ctxIdx_lookupTable();
 void free_significant_coeff_ctxIdx_lookupTable();
 
 
+/* Parsing of the coefficients in residual_coding(), after the position of the
+   last significant coefficient has been decoded. The decoded coefficients are
+   stored as values and raster positions, the number of coefficients is returned.
+ */
+typedef int (*residual_coefficients_func)(CABAC_decoder* decoder,
+                                          context_model* model,
+                                          int lastSubBlock, int lastScanPos,
+                                          bool signHiding,
+                                          int16_t* coeffList, int16_t* coeffPos);
+
+// specialized parsers, index with [log2TrafoSize-2][scanIdx][cIdx ? 1 : 0]
+extern const residual_coefficients_func residual_coefficients_parser[4][3][2];
+
+// handles all cases, including the range-extension coding tools
+int decode_residual_coefficients_generic(CABAC_decoder* decoder,
+                                         context_model* model,
+                                         int log2TrafoSize, int cIdx, int scanIdx,
+                                         int lastSubBlock, int lastScanPos,
+                                         bool signHiding,
+                                         bool transformSkipContext,
+                                         uint8_t* StatCoeff,
+                                         int16_t* coeffList, int16_t* coeffPos);
+
+
 class thread_task_ctb_row : public thread_task
 {
 public:
@@ -248,6 +248,10 @@ de265_error seq_parameter_set::read(error_queue* errqueue, bitreader* br)
     return DE265_ERROR_CODED_PARAMETER_OUT_OF_RANGE;
   }
 
+  if ((int64_t)pic_width_in_luma_samples * pic_height_in_luma_samples > MAX_PICTURE_SAMPLES) {
+    return DE265_ERROR_CODED_PARAMETER_OUT_OF_RANGE;
+  }
+
   conformance_window_flag = get_bits(br,1);
 
   if (conformance_window_flag) {
@@ -39,6 +39,10 @@ class error_queue;
 #define MAX_PICTURE_WIDTH  70000
 #define MAX_PICTURE_HEIGHT 70000
 
+// Limits the number of samples such that all per-picture sizes and
+// addresses (also in bytes, with 16 bit samples) fit into an 'int'.
+#define MAX_PICTURE_SAMPLES (1<<28)  // 16384 x 16384
+
 enum {
   CHROMA_MONO = 0,
   CHROMA_420 = 1,
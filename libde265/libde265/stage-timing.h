@@ -0,0 +1,111 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * Authors: Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STAGE_TIMING_H
+#define STAGE_TIMING_H
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef HAVE_STDINT_H
+#include <stdint.h>
+#endif
+#ifdef HAVE_CSTDINT
+#include <cstdint>
+#endif
+
+#include <chrono>
+
+
+enum decoder_stage {
+  STAGE_NAL_PARSING,
+  STAGE_SLICE_HEADER,
+  STAGE_CTU,               // complete CTU decoding, includes the following three stages
+  STAGE_INTER_PREDICTION,
+  STAGE_RESIDUAL,
+  STAGE_INTRA_PREDICTION,
+  STAGE_DEBLOCKING,
+  STAGE_SAO,
+  STAGE_HASH_CHECK,
+  NUM_DECODER_STAGES
+};
+
+
+/* Accumulated time per decoding stage. Each thread sums into its own object
+   (the thread_context for CTU decoding, a local one in the filter tasks), which
+   is added to the decoder totals when the thread finishes its task.
+   When 'enabled' is false, the timers do not read the clock.
+ */
+class stage_timing
+{
+ public:
+  stage_timing() : enabled(false) { clear(); }
+
+  void clear() {
+    for (int i=0;i<NUM_DECODER_STAGES;i++) { time_ns[i]=0; }
+  }
+
+  void add(const stage_timing& t) {
+    for (int i=0;i<NUM_DECODER_STAGES;i++) { time_ns[i] += t.time_ns[i]; }
+  }
+
+  static int64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>
+      (std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  bool    enabled;
+  int64_t time_ns[NUM_DECODER_STAGES];
+};
+
+
+// Adds the time until stop() or the end of the scope to the stage.
+
+class stage_timer
+{
+ public:
+  stage_timer(stage_timing& t, enum decoder_stage s) : timing(t), stage(s) {
+    running = timing.enabled;
+    if (running) { start = stage_timing::now(); }
+  }
+
+  ~stage_timer() { stop(); }
+
+  void stop() {
+    if (running) {
+      timing.time_ns[stage] += stage_timing::now() - start;
+      running = false;
+    }
+  }
+
+ private:
+  stage_timing& timing;
+  enum decoder_stage stage;
+  bool    running;
+  int64_t start;
+
+  stage_timer(const stage_timer&); // not allowed
+  const stage_timer& operator=(const stage_timer&); // not allowed
+};
+
+#endif
@@ -0,0 +1,170 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * Authors: Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "task-trace.h"
+#include "stage-timing.h"
+
+#include <string.h>
+
+
+task_trace_buffer::task_trace_buffer()
+  : count(0)
+{
+  for (int i=0;i<max_chunks;i++) {
+    chunks[i] = NULL;
+  }
+
+  dropped = 0;
+}
+
+
+task_trace_buffer::~task_trace_buffer()
+{
+  for (int i=0;i<max_chunks;i++) {
+    delete[] chunks[i];
+  }
+}
+
+
+void task_trace_buffer::add(task_event_type type, const char* name, int ctbAddrRS, int progress)
+{
+  const int n = count.load(std::memory_order_relaxed);
+
+  const int chunk = n / chunk_size;
+  if (chunk >= max_chunks) {
+    dropped++;
+    return;
+  }
+
+  if (chunks[chunk]==NULL) {
+    chunks[chunk] = new task_event[chunk_size];
+  }
+
+  task_event& ev = chunks[chunk][n % chunk_size];
+  ev.time_ns   = stage_timing::now();
+  ev.type      = type;
+  ev.progress  = progress;
+  ev.ctbAddrRS = ctbAddrRS;
+
+  if (name) {
+    strncpy(ev.name, name, sizeof(ev.name)-1);
+    ev.name[sizeof(ev.name)-1] = 0;
+  }
+  else {
+    ev.name[0] = 0;
+  }
+
+  count.store(n+1, std::memory_order_release);
+}
+
+
+
+task_trace::task_trace()
+{
+  buffers = NULL;
+  num_buffers = 0;
+  start_time_ns = 0;
+}
+
+
+task_trace::~task_trace()
+{
+  for (int i=0;i<num_buffers;i++) {
+    delete buffers[i];
+  }
+
+  delete[] buffers;
+}
+
+
+void task_trace::init(int num_threads)
+{
+  if (num_buffers==0) {
+    start_time_ns = stage_timing::now();
+  }
+
+  // when the worker threads are restarted, keep the events recorded so far
+
+  if (num_threads <= num_buffers) {
+    return;
+  }
+
+  task_trace_buffer** newBuffers = new task_trace_buffer*[num_threads];
+  for (int i=0;i<num_threads;i++) {
+    newBuffers[i] = (i<num_buffers ? buffers[i] : new task_trace_buffer);
+  }
+
+  delete[] buffers;
+  buffers = newBuffers;
+  num_buffers = num_threads;
+}
+
+
+bool task_trace::write_chrome_trace(FILE* fh) const
+{
+  fprintf(fh,"{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+  int nDropped = 0;
+
+  for (int t=0;t<num_buffers;t++) {
+    const task_trace_buffer* buf = buffers[t];
+
+    fprintf(fh,"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+            "\"args\":{\"name\":\"worker %d\"}},\n", t+1, t);
+
+    // A task may still be running while we write the trace. Those are left open,
+    // the viewer shows them until the end of the trace.
+
+    const int n = buf->get_count();
+    for (int i=0;i<n;i++) {
+      const task_event& ev = buf->get(i);
+      const double ts = (ev.time_ns - start_time_ns) * 0.001;  // microseconds
+
+      switch (ev.type) {
+      case TASK_EVENT_BEGIN:
+        fprintf(fh,"{\"name\":\"%s\",\"ph\":\"B\",\"pid\":1,\"tid\":%d,\"ts\":%.3f},\n",
+                ev.name, t+1, ts);
+        break;
+      case TASK_EVENT_END:
+        fprintf(fh,"{\"ph\":\"E\",\"pid\":1,\"tid\":%d,\"ts\":%.3f},\n", t+1, ts);
+        break;
+      case TASK_EVENT_BLOCK:
+        fprintf(fh,"{\"name\":\"blocked\",\"cat\":\"wait\",\"ph\":\"B\",\"pid\":1,\"tid\":%d,"
+                "\"ts\":%.3f,\"args\":{\"ctb\":%d,\"progress\":%d}},\n",
+                t+1, ts, ev.ctbAddrRS, ev.progress);
+        break;
+      case TASK_EVENT_UNBLOCK:
+        fprintf(fh,"{\"ph\":\"E\",\"pid\":1,\"tid\":%d,\"ts\":%.3f},\n", t+1, ts);
+        break;
+      }
+    }
+
+    nDropped += buf->get_num_dropped();
+  }
+
+  // the last entry without a trailing comma
+
+  fprintf(fh,"{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+          "\"args\":{\"name\":\"libde265 (%d events dropped)\"}}\n]}\n", nDropped);
+
+  return !ferror(fh);
+}
@@ -0,0 +1,115 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * Authors: Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TASK_TRACE_H
+#define TASK_TRACE_H
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef HAVE_STDINT_H
+#include <stdint.h>
+#endif
+#ifdef HAVE_CSTDINT
+#include <cstdint>
+#endif
+
+#include <stdio.h>
+#include <atomic>
+
+
+enum task_event_type {
+  TASK_EVENT_BEGIN,
+  TASK_EVENT_END,
+  TASK_EVENT_BLOCK,   // task waits for the progress of a CTB
+  TASK_EVENT_UNBLOCK
+};
+
+struct task_event
+{
+  int64_t time_ns;
+  int16_t type;    // task_event_type
+  int16_t progress;
+  int32_t ctbAddrRS;
+  char    name[48];  // only for TASK_EVENT_BEGIN
+};
+
+
+/* Events of one worker thread. Only the worker thread writes, the events are
+   published by incrementing 'count', such that they can be read from another
+   thread at any time without locking. The memory is allocated in chunks and
+   never moved. When all chunks are full, further events are dropped.
+ */
+class task_trace_buffer
+{
+ public:
+  task_trace_buffer();
+  ~task_trace_buffer();
+
+  void add(task_event_type type, const char* name=NULL, int ctbAddrRS=-1, int progress=0);
+
+  int  get_count() const { return count.load(std::memory_order_acquire); }
+  const task_event& get(int i) const { return chunks[i / chunk_size][i % chunk_size]; }
+
+  int  get_num_dropped() const { return dropped; }
+
+ private:
+  enum { chunk_size = 4096, max_chunks = 1024 };
+
+  task_event* chunks[max_chunks];
+  std::atomic<int> count;
+  int dropped;
+
+  task_trace_buffer(const task_trace_buffer&); // not allowed
+  const task_trace_buffer& operator=(const task_trace_buffer&); // not allowed
+};
+
+
+/* Timeline of the tasks executed by the worker threads, one buffer per thread.
+   write_chrome_trace() writes the events in the Chrome trace-event JSON format,
+   which can be viewed in chrome://tracing or Perfetto.
+ */
+class task_trace
+{
+ public:
+  task_trace();
+  ~task_trace();
+
+  void init(int num_threads);  // before the worker threads are started
+  bool is_enabled() const { return num_buffers>0; }
+
+  task_trace_buffer* get_buffer(int thread_idx) { return buffers[thread_idx]; }
+
+  bool write_chrome_trace(FILE* fh) const;
+
+ private:
+  task_trace_buffer** buffers;
+  int num_buffers;
+
+  int64_t start_time_ns;
+
+  task_trace(const task_trace&); // not allowed
+  const task_trace& operator=(const task_trace&); // not allowed
+};
+
+#endif
@@ -193,6 +193,12 @@ static THREAD_RESULT_TYPE THREAD_CALLING_CONVENTION worker_thread(THREAD_PARAM_T
 
   de265_mutex_lock(&pool->mutex);
 
+  task_trace_buffer* trace = NULL;
+  if (pool->trace) {
+    trace = pool->trace->get_buffer(pool->next_thread_idx);
+  }
+  pool->next_thread_idx++;
+
   while(true) {
 
     // wait until we can pick a task or until the pool has been stopped
@@ -230,8 +236,17 @@ static THREAD_RESULT_TYPE THREAD_CALLING_CONVENTION worker_thread(THREAD_PARAM_T
 
     // execute the task
 
+    if (trace) {
+      task->trace = trace;
+      trace->add(TASK_EVENT_BEGIN, task->name().c_str());
+    }
+
     task->work();
 
+    if (trace) {
+      trace->add(TASK_EVENT_END);
+    }
+
     // end processing and check if this was the last task to be processed
 
     de265_mutex_lock(&pool->mutex);
@@ -244,7 +259,7 @@ static THREAD_RESULT_TYPE THREAD_CALLING_CONVENTION worker_thread(THREAD_PARAM_T
 }
 
 
-de265_error start_thread_pool(thread_pool* pool, int num_threads)
+de265_error start_thread_pool(thread_pool* pool, int num_threads, task_trace* trace)
 {
   de265_error err = DE265_OK;
 
@@ -263,6 +278,13 @@ de265_error start_thread_pool(thread_pool* pool, int num_threads)
   de265_mutex_lock(&pool->mutex);
   pool->num_threads_working = 0;
   pool->stopped = false;
+
+  if (trace) {
+    trace->init(num_threads);
+  }
+
+  pool->trace = trace;
+  pool->next_thread_idx = 0;
   de265_mutex_unlock(&pool->mutex);
 
   // start worker threads
@@ -35,6 +35,8 @@
 #include <string>
 #include <atomic>
 
+#include "libde265/task-trace.h"
+
 #ifndef _WIN32
 #include <pthread.h>
 
@@ -101,11 +103,13 @@ private:
 class thread_task
 {
 public:
-  thread_task() : state(Queued) { }
+  thread_task() : state(Queued), trace(NULL) { }
   virtual ~thread_task() { }
 
   enum { Queued, Running, Blocked, Finished } state;
 
+  task_trace_buffer* trace; // of the executing worker thread, NULL if not tracing
+
   virtual void work() = 0;
 
   virtual std::string name() const { return "noname"; }
@@ -135,12 +139,15 @@ class thread_pool
   int ctbx[MAX_THREADS]; // the CTB the thread is working on
   int ctby[MAX_THREADS];
 
+  task_trace* trace;  // NULL if not tracing
+  int next_thread_idx;
+
   de265_mutex  mutex;
   de265_cond   cond_var;
 };
 
 
-de265_error start_thread_pool(thread_pool* pool, int num_threads);
+de265_error start_thread_pool(thread_pool* pool, int num_threads, task_trace* trace=NULL);
 void        stop_thread_pool(thread_pool* pool); // do not process remaining tasks
 
 void        add_task(thread_pool* pool, thread_task* task); // TOCO: can make thread_task const
@@ -211,10 +211,20 @@ void decode_quantization_parameters(thread_context* tctx, int xC,int yC,
 
 
 
+// Which coefficients of a block can be non-zero. Derived from the residual_coding()
+// output, used to select cheaper transform variants.
+enum coeff_sparsity {
+  coeffs_dense,
+  coeffs_topleft4x4, // all coefficients in the top-left 4x4 sub-block
+  coeffs_dc_only
+};
+
+
 template <class pixel_t>
 void transform_coefficients(acceleration_functions* acceleration,
                             int16_t* coeff, int coeffStride, int nT, int trType,
-                            pixel_t* dst, int dstStride, int bit_depth)
+                            pixel_t* dst, int dstStride, int bit_depth,
+                            coeff_sparsity sparsity = coeffs_dense)
 {
   logtrace(LogTransform,"transform --- trType: %d nT: %d\n",trType,nT);
 
@@ -223,6 +233,14 @@ void transform_coefficients(acceleration_functions* acceleration,
 
     acceleration->transform_4x4_dst_add<pixel_t>(dst, coeff, dstStride, bit_depth);
 
+  } else if (sparsity==coeffs_dc_only) {
+
+    acceleration->transform_dc_add<pixel_t>(Log2(nT)-2, dst, coeff, dstStride, bit_depth);
+
+  } else if (sparsity==coeffs_topleft4x4 && nT>4) {
+
+    acceleration->transform_topleft4x4_add<pixel_t>(Log2(nT)-2, dst, coeff, dstStride, bit_depth);
+
   } else {
 
     /**/ if (nT==4)  { acceleration->transform_add<pixel_t>(0,dst,coeff,dstStride, bit_depth); }
@@ -241,6 +259,26 @@ void transform_coefficients(acceleration_functions* acceleration,
 }
 
 
+// Fused variant of transform_coefficients(): 'levels' are not dequantized yet, this is
+// done within the inverse transform (flat scaling list only).
+template <class pixel_t>
+void transform_coefficients_dequant(const acceleration_functions* acceleration,
+                                    int16_t* levels, int nT, int trType, int fact, int shift,
+                                    pixel_t* dst, int dstStride, int bit_depth)
+{
+  logtrace(LogTransform,"transform (fused dequant) --- trType: %d nT: %d\n",trType,nT);
+
+  if (trType==1) {
+    acceleration->transform_4x4_dst_dequant_add<pixel_t>(dst, levels, dstStride, fact, shift, bit_depth);
+  } else {
+    /**/ if (nT==4)  { acceleration->transform_dequant_add<pixel_t>(0,dst,levels,dstStride,fact,shift,bit_depth); }
+    else if (nT==8)  { acceleration->transform_dequant_add<pixel_t>(1,dst,levels,dstStride,fact,shift,bit_depth); }
+    else if (nT==16) { acceleration->transform_dequant_add<pixel_t>(2,dst,levels,dstStride,fact,shift,bit_depth); }
+    else             { acceleration->transform_dequant_add<pixel_t>(3,dst,levels,dstStride,fact,shift,bit_depth); }
+  }
+}
+
+
 // TODO: make this an accelerated function
 void cross_comp_pred(const thread_context* tctx, int32_t* residual, int nT)
 {
@@ -268,6 +306,15 @@ void transform_coefficients_explicit(thread_context* tctx,
 {
   logtrace(LogTransform,"transform --- trType: %d nT: %d\n",trType,nT);
 
+  // Chroma without cross-component prediction does not need the residual,
+  // transform and add it to the prediction in one step.
+
+  if (cIdx != 0 && tctx->ResScaleVal == 0) {
+    transform_coefficients(&tctx->decctx->acceleration, coeff, coeffStride, nT, trType,
+                           dst, dstStride, bit_depth);
+    return;
+  }
+
   const acceleration_functions* acceleration = &tctx->decctx->acceleration;
 
   int32_t residual_buffer[32*32];
@@ -459,7 +506,34 @@ void scale_coefficients_internal(thread_context* tctx,
 
     // --- inverse quantization ---
 
-    if (sps.scaling_list_enable_flag==0) {
+    // When available, dequantization with a flat scaling list is fused into the inverse
+    // transform. The coefficient buffer then receives the plain coefficient levels.
+    // Sparse blocks use the specialized transforms instead.
+
+    coeff_sparsity sparsity = coeffs_dense;
+    if (tctx->nCoeff[cIdx]==1 && tctx->coeffPos[cIdx][0]==0) {
+      sparsity = coeffs_dc_only;
+    }
+    else if (tctx->lastSubBlock[cIdx]==0) {
+      sparsity = coeffs_topleft4x4;
+    }
+
+    bool fusedDequant = (sparsity==coeffs_dense &&
+                         sps.scaling_list_enable_flag==0 &&
+                         !transform_skip_flag &&
+                         !pps.range_extension.cross_component_prediction_enabled_flag &&
+                         tctx->decctx->acceleration.has_transform_dequant_add<pixel_t>());
+    int dequantFact=0, dequantShift=0;
+
+    if (fusedDequant) {
+      dequantShift = bdShift - 4;  // see below
+      dequantFact  = levelScale[qP%6] << (qP/6);
+
+      for (int i=0;i<tctx->nCoeff[cIdx];i++) {
+        tctx->coeffBuf[ tctx->coeffPos[cIdx][i] ] = tctx->coeffList[cIdx][i];
+      }
+    }
+    else if (sps.scaling_list_enable_flag==0) {
 
       //const int m_x_y = 16;
       const int m_x_y = 1;
@@ -601,7 +675,11 @@ void scale_coefficients_internal(thread_context* tctx,
       assert(rdpcmMode==0);
 
 
-      if (tctx->img->get_pps().range_extension.cross_component_prediction_enabled_flag) {
+      if (fusedDequant) {
+        transform_coefficients_dequant(&tctx->decctx->acceleration, coeff, nT, trType,
+                                       dequantFact, dequantShift, pred, stride, bit_depth);
+      }
+      else if (tctx->img->get_pps().range_extension.cross_component_prediction_enabled_flag) {
         // cross-component-prediction: transform to residual buffer and add in a separate step
 
         transform_coefficients_explicit(tctx, coeff, coeffStride, nT, trType,
@@ -609,7 +687,7 @@ void scale_coefficients_internal(thread_context* tctx,
       }
       else {
         transform_coefficients(&tctx->decctx->acceleration, coeff, coeffStride, nT, trType,
-                               pred, stride, bit_depth);
+                               pred, stride, bit_depth, sparsity);
       }
     }
   }
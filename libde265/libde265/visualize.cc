@@ -289,6 +289,21 @@ void draw_line(uint8_t *img, int stride, uint32_t color, int pixelSize,
   }
 }
 
+/* Unless DE265_DECODER_PARAM_KEEP_FULL_MOTION_INFO is set, decoded pictures only keep
+   the motion on the 16x16 grid (see de265_image::compress_motion_info()).
+   Returns NULL if there is no motion information at all.
+ */
+static const PBMotion* get_PB_motion(const de265_image *srcimg, int x, int y)
+{
+  if (srcimg->has_full_motion_info())
+    return &srcimg->get_mv_info(x, y);
+
+  if (srcimg->has_compressed_motion_info())
+    return &srcimg->get_compressed_mv_info(x, y);
+
+  return NULL;
+}
+
 void draw_PB_block(const de265_image *srcimg, uint8_t *img, int stride,
                    int x0, int y0, int w, int h, enum DrawMode what, uint32_t color, int pixelSize)
 {
@@ -306,7 +321,11 @@ void draw_PB_block(const de265_image *srcimg, uint8_t *img, int stride,
   }
   else if (what == PBMotionVectors)
   {
-    const PBMotion &mvi = srcimg->get_mv_info(x0, y0);
+    const PBMotion *motion = get_PB_motion(srcimg, x0, y0);
+    if (motion == NULL)
+      return;
+
+    const PBMotion &mvi = *motion;
     int x = x0 + w / 2;
     int y = y0 + h / 2;
     if (mvi.predFlag[0])
@@ -326,7 +345,11 @@ void draw_PB_block(const de265_image *srcimg, uint8_t *img, int stride,
   }
   else if (what == PBMotionColor)
   {
-    const PBMotion &mvi = srcimg->get_mv_info(x0, y0);
+    const PBMotion *motion = get_PB_motion(srcimg, x0, y0);
+    if (motion == NULL)
+      return;
+
+    const PBMotion &mvi = *motion;
 
     uint32_t color = 0x007F7FFF;
     if (mvi.predFlag[0])
@@ -631,3 +654,93 @@ LIBDE265_API void draw_Tiles(const de265_image *img, uint8_t *dst, int stride, i
     }
   }
 }
+
+static uint32_t get_ctb_cost_value(const de265_ctb_cost &cost, int measure)
+{
+  switch (measure)
+  {
+  case CTB_Cost_Bits:
+    return cost.bits;
+  case CTB_Cost_TUs:
+    return cost.num_TUs;
+  case CTB_Cost_Coefficients:
+    return cost.num_coefficients;
+  case CTB_Cost_Time:
+  default:
+    return cost.time_ns;
+  }
+}
+
+// blue (cheap) - green - yellow - red (expensive)
+static uint32_t heatmap_color(float f)
+{
+  int r, g, b;
+
+  if (f < 1.0f / 3)
+  {
+    r = 0;
+    g = 255 * 3 * f;
+    b = 255 * (1 - 3 * f);
+  }
+  else if (f < 2.0f / 3)
+  {
+    r = 255 * 3 * (f - 1.0f / 3);
+    g = 255;
+    b = 0;
+  }
+  else
+  {
+    r = 255;
+    g = 255 * (1 - 3 * (f - 2.0f / 3));
+    b = 0;
+  }
+
+  return (r << 16) | (g << 8) | b;
+}
+
+LIBDE265_API void draw_CTB_cost(const de265_image *img, uint8_t *dst, int stride,
+                                int measure, int pixelSize)
+{
+  if (!img->has_ctb_costs())
+  {
+    return;
+  }
+
+  const seq_parameter_set &sps = img->get_sps();
+
+  // scale to the most expensive CTB of the picture
+
+  uint32_t maxValue = 0;
+  for (int ctb = 0; ctb < img->number_of_ctbs(); ctb++)
+  {
+    maxValue = std::max(maxValue, get_ctb_cost_value(img->get_ctb_cost(ctb), measure));
+  }
+
+  if (maxValue == 0)
+  {
+    return;
+  }
+
+  // blend the heatmap 1:1 over the picture, such that the content remains visible
+
+  for (int ctby = 0; ctby < sps.PicHeightInCtbsY; ctby++)
+    for (int ctbx = 0; ctbx < sps.PicWidthInCtbsY; ctbx++)
+    {
+      int ctbAddrRS = ctbx + ctby * sps.PicWidthInCtbsY;
+      float f = get_ctb_cost_value(img->get_ctb_cost(ctbAddrRS), measure) / (float)maxValue;
+      uint32_t color = heatmap_color(f);
+
+      int x0 = ctbx << sps.Log2CtbSizeY;
+      int y0 = ctby << sps.Log2CtbSizeY;
+      int w = std::min(1 << sps.Log2CtbSizeY, sps.pic_width_in_luma_samples - x0);
+      int h = std::min(1 << sps.Log2CtbSizeY, sps.pic_height_in_luma_samples - y0);
+
+      for (int y = y0; y < y0 + h; y++)
+        for (int x = x0; x < x0 + w; x++)
+          for (int i = 0; i < pixelSize; i++)
+          {
+            uint8_t *p = &dst[y * stride + x * pixelSize + i];
+            *p = (*p + ((color >> (i * 8)) & 0xFF) + 1) >> 1;
+          }
+    }
+}
@@ -44,6 +44,18 @@ extern "C"
     LIBDE265_API void draw_Slices(const de265_image *img, uint8_t *dst, int stride, int pixelSize);
     LIBDE265_API void draw_Tiles(const de265_image *img, uint8_t *dst, int stride, int pixelSize);
 
+    // Heatmap of the decoding cost per CTB (requires DE265_DECODER_PARAM_CTB_COST),
+    // scaled to the maximum of the picture. 'measure' is one of CTB_cost_measure.
+    enum CTB_cost_measure
+    {
+        CTB_Cost_Bits,
+        CTB_Cost_Time,
+        CTB_Cost_TUs,
+        CTB_Cost_Coefficients
+    };
+
+    LIBDE265_API void draw_CTB_cost(const de265_image *img, uint8_t *dst, int stride, int measure, int pixelSize);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,651 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "x86/avx2-dct.h"
+#include "libde265/fallback-dct.h"
+#include "libde265/util.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <immintrin.h> // AVX2
+
+
+/* All inverse transforms are computed as two matrix multiplications
+   (vertical pass into an int16 intermediate, horizontal pass into the output)
+   with _mm256_madd_epi16 on pairs of matrix rows. For the larger DCTs, the
+   even/odd symmetry of the basis functions halves the number of multiplications:
+   with E (O) the sum over the even (odd) basis functions,
+   out[i] = E[i] + O[i] and out[nT-1-i] = E[i] - O[i].
+   The results are bit-exact to the fallback implementations in fallback-dct.cc.
+
+   Coefficient rows/columns beyond the last non-zero coefficient are skipped in
+   both passes, which makes the common sparse blocks considerably cheaper.
+ */
+
+
+// Transform matrix rows interleaved into int16 pairs:
+//   full: pairs[j*nT+i]     = (M[2j][i],   M[2j+1][i])
+//   even: pairs[j*nT/2+i]   = (M[4j][i],   M[4j+2][i]),  i < nT/2
+//   odd:  pairs[j*nT/2+i]   = (M[4j+1][i], M[4j+3][i]),  i < nT/2
+
+struct transform_pair_tables
+{
+  ALIGNED_32(int32_t dst4 [2*4]);
+  ALIGNED_32(int32_t dct4 [2*4]);
+  ALIGNED_32(int32_t dct8 [4*8]);
+
+  ALIGNED_32(int32_t dct8_even [2*4]);
+  ALIGNED_32(int32_t dct8_odd  [2*4]);
+  ALIGNED_32(int32_t dct16_even[4*8]);
+  ALIGNED_32(int32_t dct16_odd [4*8]);
+  ALIGNED_32(int32_t dct32_even[8*16]);
+  ALIGNED_32(int32_t dct32_odd [8*16]);
+
+  transform_pair_tables() {
+    fill(dst4,  2, 4, &mat_8_357[0][0], 4, 1, 0,1);
+    fill(dct4,  2, 4, &mat_dct[0][0],  32, 8, 0,1);
+    fill(dct8,  4, 8, &mat_dct[0][0],  32, 4, 0,1);
+
+    fill(dct8_even,  8/4,  8/2, &mat_dct[0][0], 32, 4, 0,2);
+    fill(dct8_odd,   8/4,  8/2, &mat_dct[0][0], 32, 4, 1,2);
+    fill(dct16_even,16/4, 16/2, &mat_dct[0][0], 32, 2, 0,2);
+    fill(dct16_odd, 16/4, 16/2, &mat_dct[0][0], 32, 2, 1,2);
+    fill(dct32_even,32/4, 32/2, &mat_dct[0][0], 32, 1, 0,2);
+    fill(dct32_odd, 32/4, 32/2, &mat_dct[0][0], 32, 1, 1,2);
+  }
+
+  // Pair j combines the matrix rows 'first + j*2*step' and 'first + j*2*step + step'.
+  static void fill(int32_t* pairs, int nPairs, int width,
+                   const int8_t* mat, int matStride, int fact, int first, int step)
+  {
+    for (int j=0;j<nPairs;j++)
+      for (int i=0;i<width;i++) {
+        int k = first + j*2*step;
+        uint16_t m0 = (uint16_t)(int16_t)mat[ k      *fact*matStride + i];
+        uint16_t m1 = (uint16_t)(int16_t)mat[(k+step)*fact*matStride + i];
+        pairs[j*width+i] = (int32_t)(m0 | (uint32_t(m1)<<16));
+      }
+  }
+};
+
+static const transform_pair_tables pair_tables;
+
+
+static inline int32_t load_pair(const int16_t* p)
+{
+  int32_t v;
+  memcpy(&v,p,sizeof(v));
+  return v;
+}
+
+
+// --- coefficient input, optionally dequantized on the fly ---
+
+struct dequant_none
+{
+  inline __m128i load8(const int16_t* p) const { return _mm_loadu_si128((const __m128i*)p); }
+  inline __m128i load4(const int16_t* p) const { return _mm_loadl_epi64((const __m128i*)p); }
+};
+
+struct dequant_flat
+{
+  dequant_flat(int fact, int shift)
+  {
+    m_fact   = _mm256_set1_epi32(fact);
+    m_offset = _mm256_set1_epi32(1<<(shift-1));
+    m_shift  = _mm_cvtsi32_si128(shift);
+  }
+
+  // Clip3(-32768,32767, (level*fact + offset) >> shift), the saturation is done by the packing
+  inline __m128i load8(const int16_t* p) const {
+    __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)p));
+    v = _mm256_sra_epi32(_mm256_add_epi32(_mm256_mullo_epi32(v, m_fact), m_offset), m_shift);
+    return _mm_packs_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v,1));
+  }
+
+  inline __m128i load4(const int16_t* p) const {
+    __m128i v = _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)p));
+    v = _mm_mullo_epi32(v, _mm256_castsi256_si128(m_fact));
+    v = _mm_sra_epi32(_mm_add_epi32(v, _mm256_castsi256_si128(m_offset)), m_shift);
+    return _mm_packs_epi32(v,v);
+  }
+
+  __m256i m_fact, m_offset;
+  __m128i m_shift;
+};
+
+
+// --- output of the second pass ---
+
+struct output_residual
+{
+  output_residual(int32_t* dst, int nT) : m_dst(dst), m_nT(nT) { }
+
+  inline void put8(int y,int x, __m256i r) {
+    _mm256_storeu_si256((__m256i*)(m_dst + y*m_nT + x), r);
+  }
+
+  inline void put4(int y, __m128i r) {
+    _mm_storeu_si128((__m128i*)(m_dst + y*4), r);
+  }
+
+  int32_t* m_dst;
+  int m_nT;
+};
+
+struct output_add_8
+{
+  output_add_8(uint8_t* dst, ptrdiff_t stride) : m_dst(dst), m_stride(stride) { }
+
+  inline void put8(int y,int x, __m256i r) {
+    uint8_t* p = m_dst + y*m_stride + x;
+    __m256i s = _mm256_add_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)p)), r);
+    __m128i s16 = _mm_packs_epi32(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s,1));
+    _mm_storel_epi64((__m128i*)p, _mm_packus_epi16(s16,s16));
+  }
+
+  inline void put4(int y, __m128i r) {
+    uint8_t* p = m_dst + y*m_stride;
+    int32_t pix;
+    memcpy(&pix,p,4);
+    __m128i s = _mm_add_epi32(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(pix)), r);
+    s = _mm_packs_epi32(s,s);
+    pix = _mm_cvtsi128_si32(_mm_packus_epi16(s,s));
+    memcpy(p,&pix,4);
+  }
+
+  uint8_t* m_dst;
+  ptrdiff_t m_stride;
+};
+
+// 'clipResidual' clips the residual to 16 bit before adding it (as done for the DST)
+template <bool clipResidual>
+struct output_add_16
+{
+  output_add_16(uint16_t* dst, ptrdiff_t stride, int bit_depth) : m_dst(dst), m_stride(stride) {
+    m_max = _mm256_set1_epi32((1<<bit_depth)-1);
+  }
+
+  inline void put8(int y,int x, __m256i r) {
+    uint16_t* p = m_dst + y*m_stride + x;
+    if (clipResidual) {
+      r = _mm256_max_epi32(_mm256_min_epi32(r, _mm256_set1_epi32(32767)), _mm256_set1_epi32(-32768));
+    }
+    __m256i s = _mm256_add_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)p)), r);
+    s = _mm256_min_epi32(s, m_max); // the lower clipping at 0 is done by the packing
+    _mm_storeu_si128((__m128i*)p, _mm_packus_epi32(_mm256_castsi256_si128(s),
+                                                   _mm256_extracti128_si256(s,1)));
+  }
+
+  inline void put4(int y, __m128i r) {
+    uint16_t* p = m_dst + y*m_stride;
+    if (clipResidual) {
+      r = _mm_max_epi32(_mm_min_epi32(r, _mm_set1_epi32(32767)), _mm_set1_epi32(-32768));
+    }
+    __m128i s = _mm_add_epi32(_mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)p)), r);
+    s = _mm_min_epi32(s, _mm256_castsi256_si128(m_max));
+    _mm_storel_epi64((__m128i*)p, _mm_packus_epi32(s,s));
+  }
+
+  uint16_t* m_dst;
+  ptrdiff_t m_stride;
+  __m256i m_max;
+};
+
+
+// --- 4x4 DCT / DST ---
+
+template <class Input, class Output>
+static inline void inverse_transform_4x4_avx2(const int32_t* pairs,
+                                              const int16_t* coeffs, const Input& in,
+                                              int coeffMin, int coeffMax, int bdShift,
+                                              Output& out)
+{
+  // vertical pass, g[i][c] = sum_j M[j][i] * coeffs[j][c]
+
+  const __m128i r0 = in.load4(coeffs+ 0);
+  const __m128i r1 = in.load4(coeffs+ 4);
+  const __m128i r2 = in.load4(coeffs+ 8);
+  const __m128i r3 = in.load4(coeffs+12);
+
+  const __m128i c01 = _mm_unpacklo_epi16(r0,r1);
+  const __m128i c23 = _mm_unpacklo_epi16(r2,r3);
+
+  const __m128i rnd1 = _mm_set1_epi32(1<<(7-1));
+  const __m128i cmin = _mm_set1_epi32(coeffMin);
+  const __m128i cmax = _mm_set1_epi32(coeffMax);
+
+  ALIGNED_16(int16_t g[4*4]);
+
+  for (int i=0;i<4;i+=2) {
+    __m128i a = _mm_add_epi32(_mm_madd_epi16(_mm_set1_epi32(pairs[  i]), c01),
+                              _mm_madd_epi16(_mm_set1_epi32(pairs[4+i]), c23));
+    __m128i b = _mm_add_epi32(_mm_madd_epi16(_mm_set1_epi32(pairs[  i+1]), c01),
+                              _mm_madd_epi16(_mm_set1_epi32(pairs[4+i+1]), c23));
+
+    a = _mm_srai_epi32(_mm_add_epi32(a, rnd1), 7);
+    b = _mm_srai_epi32(_mm_add_epi32(b, rnd1), 7);
+    a = _mm_max_epi32(_mm_min_epi32(a, cmax), cmin);
+    b = _mm_max_epi32(_mm_min_epi32(b, cmax), cmin);
+
+    _mm_store_si128((__m128i*)(g+i*4), _mm_packs_epi32(a,b));
+  }
+
+
+  // horizontal pass, out[y][i] = sum_j M[j][i] * g[y][j]
+
+  const __m128i m01 = _mm_load_si128((const __m128i*)(pairs+0));
+  const __m128i m23 = _mm_load_si128((const __m128i*)(pairs+4));
+  const __m128i rnd2  = _mm_set1_epi32(1<<(bdShift-1));
+  const __m128i shift = _mm_cvtsi32_si128(bdShift);
+
+  for (int y=0;y<4;y++) {
+    __m128i s = _mm_add_epi32(_mm_madd_epi16(_mm_set1_epi32(load_pair(g+y*4  )), m01),
+                              _mm_madd_epi16(_mm_set1_epi32(load_pair(g+y*4+2)), m23));
+
+    out.put4(y, _mm_sra_epi32(_mm_add_epi32(s, rnd2), shift));
+  }
+}
+
+
+// --- 8x8, 16x16, 32x32 DCT ---
+
+template <int nT, class Input, class Output>
+static inline void inverse_transform_avx2(const int32_t* fullPairs,
+                                          const int32_t* evenPairs, const int32_t* oddPairs,
+                                          const int16_t* coeffs, const Input& in,
+                                          int coeffMin, int coeffMax, int bdShift,
+                                          Output& out)
+{
+  const int nChunks = nT/8;
+
+  // The horizontal pass of the 16x16 and 32x32 transforms also uses the even/odd
+  // decomposition. For this, the columns of g are stored in the order 0,2,1,3, 4,6,5,7, ...
+  // such that even and odd column pairs can be loaded as one 32 bit word.
+  const bool evenOddH = (nT>=16);
+
+
+  // bounding box of the non-zero coefficients
+
+  const __m128i zero = _mm_setzero_si128();
+  __m128i colOr[nChunks];
+  for (int k=0;k<nChunks;k++) { colOr[k] = zero; }
+
+  int lastRow = -1;
+  for (int r=0;r<nT;r++) {
+    __m128i rowOr = zero;
+    for (int k=0;k<nChunks;k++) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(coeffs + r*nT + 8*k));
+      colOr[k] = _mm_or_si128(colOr[k], v);
+      rowOr    = _mm_or_si128(rowOr, v);
+    }
+
+    if (!_mm_testz_si128(rowOr,rowOr)) { lastRow = r; }
+  }
+
+  int lastCol = -1;
+  for (int k=nChunks-1;k>=0;k--) {
+    int nonzero = ~_mm_movemask_epi8(_mm_cmpeq_epi16(colOr[k], zero)) & 0xFFFF;
+    if (nonzero) {
+      int lane=7;
+      while ((nonzero & (3<<(2*lane)))==0) { lane--; }
+
+      lastCol = 8*k + lane;
+      break;
+    }
+  }
+
+
+  // vertical pass, g[i][c] = sum_j M[j][i] * coeffs[j][c]
+
+  ALIGNED_32(int16_t g[nT*nT]);
+
+  const int nEvenRows  = (lastRow+4)/4;  // number of row pairs (4j,4j+2) with 4j <= lastRow
+  const int nOddRows   = (lastRow+3)/4;  // number of row pairs (4j+1,4j+3) with 4j+1 <= lastRow
+  const int nColChunks = (lastCol+8)/8;
+
+  const __m256i rnd1 = _mm256_set1_epi32(1<<(7-1));
+  const __m256i cmin = _mm256_set1_epi32(coeffMin);
+  const __m256i cmax = _mm256_set1_epi32(coeffMax);
+  const __m128i colOrder = _mm_setr_epi8(0,1,4,5,2,3,6,7, 8,9,12,13,10,11,14,15);
+
+  for (int k=0;k<nColChunks;k++) {
+    __m256i evenRows[nT/4];
+    __m256i oddRows [nT/4];
+
+    for (int j=0;j<nEvenRows;j++) {
+      __m128i r0 = in.load8(coeffs + (4*j  )*nT + 8*k);
+      __m128i r1 = in.load8(coeffs + (4*j+2)*nT + 8*k);
+      evenRows[j] = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi16(r0,r1)),
+                                            _mm_unpackhi_epi16(r0,r1), 1);
+    }
+
+    for (int j=0;j<nOddRows;j++) {
+      __m128i r0 = in.load8(coeffs + (4*j+1)*nT + 8*k);
+      __m128i r1 = in.load8(coeffs + (4*j+3)*nT + 8*k);
+      oddRows[j] = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi16(r0,r1)),
+                                           _mm_unpackhi_epi16(r0,r1), 1);
+    }
+
+    for (int i=0;i<nT/2;i++) {
+      __m256i e = rnd1;
+      for (int j=0;j<nEvenRows;j++) {
+        e = _mm256_add_epi32(e, _mm256_madd_epi16(_mm256_set1_epi32(evenPairs[j*nT/2+i]), evenRows[j]));
+      }
+
+      __m256i o = _mm256_setzero_si256();
+      for (int j=0;j<nOddRows;j++) {
+        o = _mm256_add_epi32(o, _mm256_madd_epi16(_mm256_set1_epi32(oddPairs[j*nT/2+i]), oddRows[j]));
+      }
+
+      __m256i a = _mm256_srai_epi32(_mm256_add_epi32(e,o), 7);
+      __m256i b = _mm256_srai_epi32(_mm256_sub_epi32(e,o), 7);
+      a = _mm256_max_epi32(_mm256_min_epi32(a, cmax), cmin);
+      b = _mm256_max_epi32(_mm256_min_epi32(b, cmax), cmin);
+
+      __m128i ga = _mm_packs_epi32(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a,1));
+      __m128i gb = _mm_packs_epi32(_mm256_castsi256_si128(b), _mm256_extracti128_si256(b,1));
+      if (evenOddH) {
+        ga = _mm_shuffle_epi8(ga, colOrder);
+        gb = _mm_shuffle_epi8(gb, colOrder);
+      }
+
+      _mm_store_si128((__m128i*)(g +       i *nT + 8*k), ga);
+      _mm_store_si128((__m128i*)(g + (nT-1-i)*nT + 8*k), gb);
+    }
+  }
+
+
+  // horizontal pass, out[y][i] = sum_j M[j][i] * g[y][j]
+  // Columns of g beyond 'lastCol' are zero and are never read.
+
+  const __m256i rnd2  = _mm256_set1_epi32(1<<(bdShift-1));
+  const __m128i shift = _mm_cvtsi32_si128(bdShift);
+
+  if (!evenOddH) {
+    const int nColPairs = (lastCol+2)/2;
+
+    for (int y=0;y<nT;y++) {
+      __m256i s[nChunks];
+      for (int k=0;k<nChunks;k++) { s[k] = rnd2; }
+
+      for (int j=0;j<nColPairs;j++) {
+        const __m256i gPair = _mm256_set1_epi32(load_pair(g + y*nT + 2*j));
+
+        for (int k=0;k<nChunks;k++) {
+          s[k] = _mm256_add_epi32(s[k],
+                                  _mm256_madd_epi16(gPair,
+                                                    _mm256_load_si256((const __m256i*)(fullPairs + j*nT + 8*k))));
+        }
+      }
+
+      for (int k=0;k<nChunks;k++) {
+        out.put8(y, 8*k, _mm256_sra_epi32(s[k], shift));
+      }
+    }
+  }
+  else {
+    const int nEvenCols = (lastCol+4)/4;
+    const int nOddCols  = (lastCol+3)/4;
+    const int nHalfChunks = nT/16;
+
+    const __m256i reverse = _mm256_setr_epi32(7,6,5,4,3,2,1,0);
+
+    for (int y=0;y<nT;y++) {
+      __m256i e[nHalfChunks], o[nHalfChunks];
+      for (int k=0;k<nHalfChunks;k++) { e[k] = rnd2; o[k] = _mm256_setzero_si256(); }
+
+      for (int j=0;j<nEvenCols;j++) {
+        const __m256i gPair = _mm256_set1_epi32(load_pair(g + y*nT + 4*j));
+
+        for (int k=0;k<nHalfChunks;k++) {
+          e[k] = _mm256_add_epi32(e[k],
+                                  _mm256_madd_epi16(gPair,
+                                                    _mm256_load_si256((const __m256i*)(evenPairs + j*nT/2 + 8*k))));
+        }
+      }
+
+      for (int j=0;j<nOddCols;j++) {
+        const __m256i gPair = _mm256_set1_epi32(load_pair(g + y*nT + 4*j+2));
+
+        for (int k=0;k<nHalfChunks;k++) {
+          o[k] = _mm256_add_epi32(o[k],
+                                  _mm256_madd_epi16(gPair,
+                                                    _mm256_load_si256((const __m256i*)(oddPairs + j*nT/2 + 8*k))));
+        }
+      }
+
+      for (int k=0;k<nHalfChunks;k++) {
+        __m256i a = _mm256_sra_epi32(_mm256_add_epi32(e[k],o[k]), shift);
+        __m256i b = _mm256_sra_epi32(_mm256_sub_epi32(e[k],o[k]), shift);
+
+        out.put8(y, 8*k, a);
+        out.put8(y, nT-8-8*k, _mm256_permutevar8x32_epi32(b, reverse));
+      }
+    }
+  }
+}
+
+
+template <int nT, class Input, class Output>
+static inline void inverse_dct_avx2(const int16_t* coeffs, const Input& in,
+                                    int coeffMin, int coeffMax, int bdShift,
+                                    Output& out)
+{
+  switch (nT) {
+  case 4:  inverse_transform_4x4_avx2(pair_tables.dct4, coeffs,in, coeffMin,coeffMax,bdShift, out); break;
+  case 8:
+    inverse_transform_avx2<8> (pair_tables.dct8, pair_tables.dct8_even, pair_tables.dct8_odd,
+                               coeffs,in, coeffMin,coeffMax,bdShift, out);
+    break;
+  case 16:
+    inverse_transform_avx2<16>(NULL, pair_tables.dct16_even, pair_tables.dct16_odd,
+                               coeffs,in, coeffMin,coeffMax,bdShift, out);
+    break;
+  case 32:
+    inverse_transform_avx2<32>(NULL, pair_tables.dct32_even, pair_tables.dct32_odd,
+                               coeffs,in, coeffMin,coeffMax,bdShift, out);
+    break;
+  }
+}
+
+
+// --- int32 residual ---
+
+void transform_idst_4x4_avx2(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits)
+{
+  output_residual out(dst,4);
+  inverse_transform_4x4_avx2(pair_tables.dst4, coeffs, dequant_none(),
+                             -(1<<max_coeff_bits), (1<<max_coeff_bits)-1, bdShift, out);
+}
+
+template <int nT>
+static void transform_idct_avx2(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits)
+{
+  output_residual out(dst,nT);
+  inverse_dct_avx2<nT>(coeffs, dequant_none(),
+                       -(1<<max_coeff_bits), (1<<max_coeff_bits)-1, bdShift, out);
+}
+
+void transform_idct_4x4_avx2(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits)
+{
+  transform_idct_avx2<4>(dst,coeffs,bdShift,max_coeff_bits);
+}
+
+void transform_idct_8x8_avx2(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits)
+{
+  transform_idct_avx2<8>(dst,coeffs,bdShift,max_coeff_bits);
+}
+
+void transform_idct_16x16_avx2(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits)
+{
+  transform_idct_avx2<16>(dst,coeffs,bdShift,max_coeff_bits);
+}
+
+void transform_idct_32x32_avx2(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits)
+{
+  transform_idct_avx2<32>(dst,coeffs,bdShift,max_coeff_bits);
+}
+
+
+// --- add to 8 bit prediction ---
+
+void transform_4x4_dst_add_8_avx2(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
+{
+  output_add_8 out(dst,stride);
+  inverse_transform_4x4_avx2(pair_tables.dst4, coeffs, dequant_none(), -32768,32767, 20-8, out);
+}
+
+void transform_4x4_add_8_avx2(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
+{
+  output_add_8 out(dst,stride);
+  inverse_dct_avx2<4>(coeffs, dequant_none(), -32768,32767, 20-8, out);
+}
+
+void transform_8x8_add_8_avx2(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
+{
+  output_add_8 out(dst,stride);
+  inverse_dct_avx2<8>(coeffs, dequant_none(), -32768,32767, 20-8, out);
+}
+
+void transform_16x16_add_8_avx2(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
+{
+  output_add_8 out(dst,stride);
+  inverse_dct_avx2<16>(coeffs, dequant_none(), -32768,32767, 20-8, out);
+}
+
+void transform_32x32_add_8_avx2(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
+{
+  output_add_8 out(dst,stride);
+  inverse_dct_avx2<32>(coeffs, dequant_none(), -32768,32767, 20-8, out);
+}
+
+
+// --- add to high bit-depth prediction ---
+
+void transform_4x4_dst_add_16_avx2(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth)
+{
+  output_add_16<true> out(dst,stride,bit_depth);
+  inverse_transform_4x4_avx2(pair_tables.dst4, coeffs, dequant_none(), -32768,32767, 20-bit_depth, out);
+}
+
+void transform_4x4_add_16_avx2(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth)
+{
+  output_add_16<false> out(dst,stride,bit_depth);
+  inverse_dct_avx2<4>(coeffs, dequant_none(), -32768,32767, 20-bit_depth, out);
+}
+
+void transform_8x8_add_16_avx2(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth)
+{
+  output_add_16<false> out(dst,stride,bit_depth);
+  inverse_dct_avx2<8>(coeffs, dequant_none(), -32768,32767, 20-bit_depth, out);
+}
+
+void transform_16x16_add_16_avx2(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth)
+{
+  output_add_16<false> out(dst,stride,bit_depth);
+  inverse_dct_avx2<16>(coeffs, dequant_none(), -32768,32767, 20-bit_depth, out);
+}
+
+void transform_32x32_add_16_avx2(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth)
+{
+  output_add_16<false> out(dst,stride,bit_depth);
+  inverse_dct_avx2<32>(coeffs, dequant_none(), -32768,32767, 20-bit_depth, out);
+}
+
+
+// --- fused dequantization + transform + add ---
+
+void transform_4x4_dst_dequant_add_8_avx2(uint8_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                          int fact, int shift)
+{
+  output_add_8 out(dst,stride);
+  inverse_transform_4x4_avx2(pair_tables.dst4, levels, dequant_flat(fact,shift),
+                             -32768,32767, 20-8, out);
+}
+
+void transform_4x4_dequant_add_8_avx2(uint8_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                      int fact, int shift)
+{
+  output_add_8 out(dst,stride);
+  inverse_dct_avx2<4>(levels, dequant_flat(fact,shift), -32768,32767, 20-8, out);
+}
+
+void transform_8x8_dequant_add_8_avx2(uint8_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                      int fact, int shift)
+{
+  output_add_8 out(dst,stride);
+  inverse_dct_avx2<8>(levels, dequant_flat(fact,shift), -32768,32767, 20-8, out);
+}
+
+void transform_16x16_dequant_add_8_avx2(uint8_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                        int fact, int shift)
+{
+  output_add_8 out(dst,stride);
+  inverse_dct_avx2<16>(levels, dequant_flat(fact,shift), -32768,32767, 20-8, out);
+}
+
+void transform_32x32_dequant_add_8_avx2(uint8_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                        int fact, int shift)
+{
+  output_add_8 out(dst,stride);
+  inverse_dct_avx2<32>(levels, dequant_flat(fact,shift), -32768,32767, 20-8, out);
+}
+
+
+void transform_4x4_dst_dequant_add_16_avx2(uint16_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                           int fact, int shift, int bit_depth)
+{
+  output_add_16<true> out(dst,stride,bit_depth);
+  inverse_transform_4x4_avx2(pair_tables.dst4, levels, dequant_flat(fact,shift),
+                             -32768,32767, 20-bit_depth, out);
+}
+
+void transform_4x4_dequant_add_16_avx2(uint16_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                       int fact, int shift, int bit_depth)
+{
+  output_add_16<false> out(dst,stride,bit_depth);
+  inverse_dct_avx2<4>(levels, dequant_flat(fact,shift), -32768,32767, 20-bit_depth, out);
+}
+
+void transform_8x8_dequant_add_16_avx2(uint16_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                       int fact, int shift, int bit_depth)
+{
+  output_add_16<false> out(dst,stride,bit_depth);
+  inverse_dct_avx2<8>(levels, dequant_flat(fact,shift), -32768,32767, 20-bit_depth, out);
+}
+
+void transform_16x16_dequant_add_16_avx2(uint16_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                         int fact, int shift, int bit_depth)
+{
+  output_add_16<false> out(dst,stride,bit_depth);
+  inverse_dct_avx2<16>(levels, dequant_flat(fact,shift), -32768,32767, 20-bit_depth, out);
+}
+
+void transform_32x32_dequant_add_16_avx2(uint16_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                         int fact, int shift, int bit_depth)
+{
+  output_add_16<false> out(dst,stride,bit_depth);
+  inverse_dct_avx2<32>(levels, dequant_flat(fact,shift), -32768,32767, 20-bit_depth, out);
+}
@@ -0,0 +1,74 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef AVX2_DCT_H
+#define AVX2_DCT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// --- inverse transforms into an int32 residual (cross-component prediction) ---
+
+void transform_idst_4x4_avx2(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits);
+void transform_idct_4x4_avx2(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits);
+void transform_idct_8x8_avx2(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits);
+void transform_idct_16x16_avx2(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits);
+void transform_idct_32x32_avx2(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits);
+
+// --- inverse transforms adding to the prediction ---
+
+void transform_4x4_dst_add_8_avx2(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
+void transform_4x4_add_8_avx2(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
+void transform_8x8_add_8_avx2(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
+void transform_16x16_add_8_avx2(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
+void transform_32x32_add_8_avx2(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
+
+void transform_4x4_dst_add_16_avx2(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+void transform_4x4_add_16_avx2(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+void transform_8x8_add_16_avx2(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+void transform_16x16_add_16_avx2(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+void transform_32x32_add_16_avx2(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+
+// --- fused dequantization (flat scaling list) + inverse transform + add ---
+
+void transform_4x4_dst_dequant_add_8_avx2(uint8_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                          int fact, int shift);
+void transform_4x4_dequant_add_8_avx2(uint8_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                      int fact, int shift);
+void transform_8x8_dequant_add_8_avx2(uint8_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                      int fact, int shift);
+void transform_16x16_dequant_add_8_avx2(uint8_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                        int fact, int shift);
+void transform_32x32_dequant_add_8_avx2(uint8_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                        int fact, int shift);
+
+void transform_4x4_dst_dequant_add_16_avx2(uint16_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                           int fact, int shift, int bit_depth);
+void transform_4x4_dequant_add_16_avx2(uint16_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                       int fact, int shift, int bit_depth);
+void transform_8x8_dequant_add_16_avx2(uint16_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                       int fact, int shift, int bit_depth);
+void transform_16x16_dequant_add_16_avx2(uint16_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                         int fact, int shift, int bit_depth);
+void transform_32x32_dequant_add_16_avx2(uint16_t *dst, const int16_t *levels, ptrdiff_t stride,
+                                         int fact, int shift, int bit_depth);
+
+#endif
@@ -21,6 +21,9 @@
 
 #include "x86/sse-dct.h"
 #include "libde265/util.h"
+#include "libde265/fallback-dct.h"
+
+#include <string.h>
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -7092,3 +7095,219 @@ void ff_hevc_transform_32x32_add_10_sse4(uint8_t *_dst, const int16_t *coeffs,
 }
 #endif
 
+
+// --- sparse coefficient blocks ---
+
+#if HAVE_SSE4_1
+
+static inline int dc_residual(int16_t dc, int bit_depth)
+{
+  int postShift = 20-bit_depth;
+  int g = Clip3(-32768,32767, (64*dc + (1<<6))>>7);
+  return (64*g + (1<<(postShift-1)))>>postShift;
+}
+
+template <int nT>
+static inline void transform_dc_add_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
+{
+  int out = dc_residual(coeffs[0], 8);
+
+  // saturated add and subtract of the (clipped) residual magnitude
+  const __m128i add = _mm_set1_epi8((char)Clip3(0,255, out));
+  const __m128i sub = _mm_set1_epi8((char)Clip3(0,255,-out));
+
+  for (int y=0;y<nT;y++) {
+    uint8_t* p = dst+y*stride;
+
+    if (nT==4) {
+      int32_t pix;
+      memcpy(&pix,p,4);
+      __m128i v = _mm_subs_epu8(_mm_adds_epu8(_mm_cvtsi32_si128(pix), add), sub);
+      pix = _mm_cvtsi128_si32(v);
+      memcpy(p,&pix,4);
+    }
+    else if (nT==8) {
+      __m128i v = _mm_loadl_epi64((const __m128i*)p);
+      _mm_storel_epi64((__m128i*)p, _mm_subs_epu8(_mm_adds_epu8(v, add), sub));
+    }
+    else {
+      for (int x=0;x<nT;x+=16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p+x));
+        _mm_storeu_si128((__m128i*)(p+x), _mm_subs_epu8(_mm_adds_epu8(v, add), sub));
+      }
+    }
+  }
+}
+
+void transform_4x4_dc_add_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
+{
+  transform_dc_add_8_sse4<4>(dst,coeffs,stride);
+}
+
+void transform_8x8_dc_add_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
+{
+  transform_dc_add_8_sse4<8>(dst,coeffs,stride);
+}
+
+void transform_16x16_dc_add_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
+{
+  transform_dc_add_8_sse4<16>(dst,coeffs,stride);
+}
+
+void transform_32x32_dc_add_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
+{
+  transform_dc_add_8_sse4<32>(dst,coeffs,stride);
+}
+
+
+template <int nT>
+static inline void transform_dc_add_16_sse4(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride,
+                                            int bit_depth)
+{
+  int out = dc_residual(coeffs[0], bit_depth);
+
+  const __m128i add  = _mm_set1_epi16((short)Clip3(0,65535, out));
+  const __m128i sub  = _mm_set1_epi16((short)Clip3(0,65535,-out));
+  const __m128i maxv = _mm_set1_epi16((short)((1<<bit_depth)-1));
+
+  for (int y=0;y<nT;y++) {
+    uint16_t* p = dst+y*stride;
+
+    if (nT==4) {
+      __m128i v = _mm_loadl_epi64((const __m128i*)p);
+      v = _mm_min_epu16(_mm_subs_epu16(_mm_adds_epu16(v, add), sub), maxv);
+      _mm_storel_epi64((__m128i*)p, v);
+    }
+    else {
+      for (int x=0;x<nT;x+=8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p+x));
+        v = _mm_min_epu16(_mm_subs_epu16(_mm_adds_epu16(v, add), sub), maxv);
+        _mm_storeu_si128((__m128i*)(p+x), v);
+      }
+    }
+  }
+}
+
+void transform_4x4_dc_add_16_sse4(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth)
+{
+  transform_dc_add_16_sse4<4>(dst,coeffs,stride,bit_depth);
+}
+
+void transform_8x8_dc_add_16_sse4(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth)
+{
+  transform_dc_add_16_sse4<8>(dst,coeffs,stride,bit_depth);
+}
+
+void transform_16x16_dc_add_16_sse4(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth)
+{
+  transform_dc_add_16_sse4<16>(dst,coeffs,stride,bit_depth);
+}
+
+void transform_32x32_dc_add_16_sse4(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth)
+{
+  transform_dc_add_16_sse4<32>(dst,coeffs,stride,bit_depth);
+}
+
+
+// The first four DCT basis functions of the 8, 16, and 32 point transforms,
+// interleaved into int16 pairs (M[0][i],M[1][i]) and (M[2][i],M[3][i]).
+
+struct topleft4x4_tables
+{
+  ALIGNED_16(int32_t pairs01[3][32]);
+  ALIGNED_16(int32_t pairs23[3][32]);
+
+  topleft4x4_tables() {
+    for (int s=0;s<3;s++) {
+      int nT   = 8<<s;
+      int fact = 4>>s;
+
+      for (int i=0;i<nT;i++) {
+        pairs01[s][i] = pair(mat_dct[0*fact][i], mat_dct[1*fact][i]);
+        pairs23[s][i] = pair(mat_dct[2*fact][i], mat_dct[3*fact][i]);
+      }
+    }
+  }
+
+  static int32_t pair(int a,int b) { return (int32_t)((uint16_t)a | ((uint32_t)(uint16_t)b<<16)); }
+};
+
+static const topleft4x4_tables topleft4x4;
+
+
+template <int nT>
+static inline void transform_topleft4x4_add_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
+{
+  const int sizeIdx = (nT==8 ? 0 : nT==16 ? 1 : 2);
+  const int32_t* pairs01 = topleft4x4.pairs01[sizeIdx];
+  const int32_t* pairs23 = topleft4x4.pairs23[sizeIdx];
+
+  // vertical pass over the four non-zero columns, g[i][c] = sum_j M[j][i] * coeffs[j][c]
+
+  const __m128i c01 = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(coeffs)),
+                                         _mm_loadl_epi64((const __m128i*)(coeffs+nT)));
+  const __m128i c23 = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(coeffs+2*nT)),
+                                         _mm_loadl_epi64((const __m128i*)(coeffs+3*nT)));
+  const __m128i rnd1 = _mm_set1_epi32(1<<(7-1));
+
+  ALIGNED_16(int16_t g[32*4]);
+
+  for (int i=0;i<nT;i+=2) {
+    __m128i a = _mm_add_epi32(_mm_madd_epi16(_mm_set1_epi32(pairs01[i]), c01),
+                              _mm_madd_epi16(_mm_set1_epi32(pairs23[i]), c23));
+    __m128i b = _mm_add_epi32(_mm_madd_epi16(_mm_set1_epi32(pairs01[i+1]), c01),
+                              _mm_madd_epi16(_mm_set1_epi32(pairs23[i+1]), c23));
+
+    a = _mm_srai_epi32(_mm_add_epi32(a, rnd1), 7);
+    b = _mm_srai_epi32(_mm_add_epi32(b, rnd1), 7);
+
+    _mm_store_si128((__m128i*)(g+i*4), _mm_packs_epi32(a,b));
+  }
+
+
+  // horizontal pass, out[y][i] = sum_j M[j][i] * g[y][j], j<4
+
+  const __m128i rnd2 = _mm_set1_epi32(1<<(12-1));
+
+  for (int y=0;y<nT;y++) {
+    int32_t g01,g23;
+    memcpy(&g01, g+y*4,   4);
+    memcpy(&g23, g+y*4+2, 4);
+
+    const __m128i gPair01 = _mm_set1_epi32(g01);
+    const __m128i gPair23 = _mm_set1_epi32(g23);
+
+    uint8_t* p = dst+y*stride;
+
+    for (int x=0;x<nT;x+=8) {
+      __m128i lo = _mm_add_epi32(_mm_madd_epi16(gPair01, _mm_load_si128((const __m128i*)(pairs01+x))),
+                                 _mm_madd_epi16(gPair23, _mm_load_si128((const __m128i*)(pairs23+x))));
+      __m128i hi = _mm_add_epi32(_mm_madd_epi16(gPair01, _mm_load_si128((const __m128i*)(pairs01+x+4))),
+                                 _mm_madd_epi16(gPair23, _mm_load_si128((const __m128i*)(pairs23+x+4))));
+
+      lo = _mm_srai_epi32(_mm_add_epi32(lo, rnd2), 12);
+      hi = _mm_srai_epi32(_mm_add_epi32(hi, rnd2), 12);
+
+      __m128i pix = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(p+x)));
+      pix = _mm_adds_epi16(pix, _mm_packs_epi32(lo,hi));
+      _mm_storel_epi64((__m128i*)(p+x), _mm_packus_epi16(pix,pix));
+    }
+  }
+}
+
+void transform_8x8_topleft4x4_add_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
+{
+  transform_topleft4x4_add_8_sse4<8>(dst,coeffs,stride);
+}
+
+void transform_16x16_topleft4x4_add_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
+{
+  transform_topleft4x4_add_8_sse4<16>(dst,coeffs,stride);
+}
+
+void transform_32x32_topleft4x4_add_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
+{
+  transform_topleft4x4_add_8_sse4<32>(dst,coeffs,stride);
+}
+
+#endif
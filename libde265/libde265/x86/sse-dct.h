@@ -32,4 +32,20 @@ void ff_hevc_transform_8x8_add_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdi
 void ff_hevc_transform_16x16_add_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
 void ff_hevc_transform_32x32_add_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
 
+// sparse coefficient blocks (only DC / only top-left 4x4)
+
+void transform_4x4_dc_add_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
+void transform_8x8_dc_add_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
+void transform_16x16_dc_add_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
+void transform_32x32_dc_add_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
+
+void transform_4x4_dc_add_16_sse4(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+void transform_8x8_dc_add_16_sse4(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+void transform_16x16_dc_add_16_sse4(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+void transform_32x32_dc_add_16_sse4(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+
+void transform_8x8_topleft4x4_add_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
+void transform_16x16_topleft4x4_add_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
+void transform_32x32_topleft4x4_add_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
+
 #endif
@@ -0,0 +1,343 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "x86/sse-intrapred.h"
+#include "libde265/util.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <emmintrin.h> // SSE2
+#include <tmmintrin.h> // SSSE3
+
+#if HAVE_SSE4_1
+#include <smmintrin.h> // SSE4.1
+#endif
+
+
+// defined in intrapred.cc
+extern const int intraPredAngle_table[1+34];
+extern const int invAngle_table[25-10];
+
+
+/* All functions are bit-exact to the scalar versions in intrapred.h and support
+   the block sizes nT = 4, 8, 16, 32. The border array must be readable up to
+   16 samples beyond its last valid entry (2*nT), which is always the case for the
+   reference sample buffers of size 4*MAX_INTRA_PRED_BLOCK_SIZE+1.
+ */
+
+
+static inline void store_row(uint8_t* dst, __m128i v, int n)
+{
+  if (n==4)      { *((uint32_t*)dst) = _mm_cvtsi128_si32(v); }
+  else if (n==8) { _mm_storel_epi64((__m128i*)dst, v); }
+  else           { _mm_storeu_si128((__m128i*)dst, v); }
+}
+
+
+void intra_prediction_sample_filtering_8_sse(uint8_t* pF, const uint8_t* p, int nT)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i two  = _mm_set1_epi16(2);
+
+  // The last group of 8 overwrites pF[2*nT], which is restored below.
+
+  for (int i=-(2*nT-1) ; i<=2*nT-1 ; i+=8) {
+    __m128i a = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(p+i-1)), zero);
+    __m128i b = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(p+i  )), zero);
+    __m128i c = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(p+i+1)), zero);
+
+    __m128i s = _mm_add_epi16(_mm_add_epi16(a,c), _mm_add_epi16(_mm_add_epi16(b,b), two));
+    s = _mm_srli_epi16(s, 2);
+
+    _mm_storel_epi64((__m128i*)(pF+i), _mm_packus_epi16(s,s));
+  }
+
+  pF[-2*nT] = p[-2*nT];
+  pF[ 2*nT] = p[ 2*nT];
+}
+
+
+void intra_prediction_planar_8_sse(uint8_t* dst, ptrdiff_t dstStride, int nT, int cIdx,
+                                   const uint8_t* border)
+{
+  const __m128i zero = _mm_setzero_si128();
+
+  const int shift = Log2(nT)+1;
+  const int topRight   = border[ 1+nT];
+  const int bottomLeft = border[-1-nT];
+
+  // For each group of 8 columns, keep the part of the sum that does not depend on the
+  // left sample. All intermediate values fit into 16 bit (max. 63*255*2+32 for nT=32).
+
+  __m128i base[4], delta[4], weightLeft[4];
+
+  const int nGroups = (nT+7)/8;
+  for (int g=0;g<nGroups;g++) {
+    __m128i top = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(border+1+8*g)), zero);
+    __m128i x   = _mm_add_epi16(_mm_set_epi16(7,6,5,4,3,2,1,0), _mm_set1_epi16(8*g));
+
+    weightLeft[g] = _mm_sub_epi16(_mm_set1_epi16(nT-1), x);
+
+    // y=0: (x+1)*topRight + (nT-1)*top[x] + bottomLeft + nT
+    base[g] = _mm_mullo_epi16(_mm_add_epi16(x, _mm_set1_epi16(1)), _mm_set1_epi16(topRight));
+    base[g] = _mm_add_epi16(base[g], _mm_mullo_epi16(top, _mm_set1_epi16(nT-1)));
+    base[g] = _mm_add_epi16(base[g], _mm_set1_epi16(bottomLeft + nT));
+
+    delta[g] = _mm_sub_epi16(_mm_set1_epi16(bottomLeft), top);
+  }
+
+  for (int y=0;y<nT;y++) {
+    __m128i left = _mm_set1_epi16(border[-1-y]);
+
+    __m128i v[4];
+    for (int g=0;g<nGroups;g++) {
+      v[g] = _mm_add_epi16(base[g], _mm_mullo_epi16(weightLeft[g], left));
+      v[g] = _mm_srli_epi16(v[g], shift);
+      base[g] = _mm_add_epi16(base[g], delta[g]);
+    }
+
+    if (nT<=8) {
+      store_row(dst+y*dstStride, _mm_packus_epi16(v[0],v[0]), nT);
+    }
+    else {
+      for (int g=0;g<nGroups;g+=2) {
+        store_row(dst+y*dstStride+8*g, _mm_packus_epi16(v[g],v[g+1]), 16);
+      }
+    }
+  }
+}
+
+
+static inline int sum_samples(const uint8_t* p, int n)
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i sum;
+
+  if (n==4) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    sum = _mm_sad_epu8(_mm_cvtsi32_si128(v), zero);
+  }
+  else if (n==8) {
+    sum = _mm_sad_epu8(_mm_loadl_epi64((const __m128i*)p), zero);
+  }
+  else {
+    sum = zero;
+    for (int i=0;i<n;i+=16) {
+      sum = _mm_add_epi64(sum, _mm_sad_epu8(_mm_loadu_si128((const __m128i*)(p+i)), zero));
+    }
+    sum = _mm_add_epi64(sum, _mm_srli_si128(sum,8));
+  }
+
+  return _mm_cvtsi128_si32(sum);
+}
+
+
+void intra_prediction_DC_8_sse(uint8_t* dst, ptrdiff_t dstStride, int nT, int cIdx,
+                               const uint8_t* border)
+{
+  const int Log2_nT = Log2(nT);
+
+  int dcVal = sum_samples(border+1, nT) + sum_samples(border-nT, nT);
+  dcVal += nT;
+  dcVal >>= Log2_nT+1;
+
+  const __m128i dc = _mm_set1_epi8((char)dcVal);
+
+  for (int y=0;y<nT;y++) {
+    for (int x=0;x<nT;x+=16) {
+      store_row(dst+y*dstStride+x, dc, nT);
+    }
+  }
+
+  if (cIdx==0 && nT<32) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i dc3  = _mm_set1_epi16(3*dcVal+2);
+
+    for (int x=0;x<nT;x+=8) {
+      __m128i top = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(border+1+x)), zero);
+      __m128i v = _mm_srli_epi16(_mm_add_epi16(top, dc3), 2);
+      store_row(dst+x, _mm_packus_epi16(v,v), nT==4 ? 4 : 8);
+    }
+
+    dst[0] = (border[-1] + 2*dcVal + border[1] +2) >> 2;
+
+    for (int y=1;y<nT;y++) { dst[y*dstStride] = (border[-y-1] + 3*dcVal+2)>>2; }
+  }
+}
+
+
+// Interpolate nT rows of the (vertical) angular prediction from the projected reference row.
+static void angular_rows(uint8_t* dst, ptrdiff_t dstStride,
+                         const uint8_t* ref, int intraPredAngle, int nT)
+{
+  const __m128i rnd = _mm_set1_epi16(16);
+
+  for (int y=0;y<nT;y++) {
+    const int iIdx = ((y+1)*intraPredAngle)>>5;
+    const int iFact= ((y+1)*intraPredAngle)&31;
+
+    // byte pairs (32-iFact, iFact); iFact==0 yields the plain copy
+    const __m128i w = _mm_set1_epi16((int16_t)((iFact<<8) | (32-iFact)));
+
+    const uint8_t* r = ref+iIdx+1;
+    uint8_t* out = dst+y*dstStride;
+
+    if (nT<=8) {
+      __m128i a = _mm_loadl_epi64((const __m128i*)(r));
+      __m128i b = _mm_loadl_epi64((const __m128i*)(r+1));
+      __m128i v = _mm_maddubs_epi16(_mm_unpacklo_epi8(a,b), w);
+      v = _mm_srli_epi16(_mm_add_epi16(v,rnd), 5);
+      store_row(out, _mm_packus_epi16(v,v), nT);
+    }
+    else {
+      for (int x=0;x<nT;x+=16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(r+x));
+        __m128i b = _mm_loadu_si128((const __m128i*)(r+x+1));
+        __m128i lo = _mm_maddubs_epi16(_mm_unpacklo_epi8(a,b), w);
+        __m128i hi = _mm_maddubs_epi16(_mm_unpackhi_epi8(a,b), w);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo,rnd), 5);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi,rnd), 5);
+        _mm_storeu_si128((__m128i*)(out+x), _mm_packus_epi16(lo,hi));
+      }
+    }
+  }
+}
+
+
+static void transpose_8x8(uint8_t* dst, ptrdiff_t dstStride, const uint8_t* src, ptrdiff_t srcStride)
+{
+  __m128i a0 = _mm_loadl_epi64((const __m128i*)(src+0*srcStride));
+  __m128i a1 = _mm_loadl_epi64((const __m128i*)(src+1*srcStride));
+  __m128i a2 = _mm_loadl_epi64((const __m128i*)(src+2*srcStride));
+  __m128i a3 = _mm_loadl_epi64((const __m128i*)(src+3*srcStride));
+  __m128i a4 = _mm_loadl_epi64((const __m128i*)(src+4*srcStride));
+  __m128i a5 = _mm_loadl_epi64((const __m128i*)(src+5*srcStride));
+  __m128i a6 = _mm_loadl_epi64((const __m128i*)(src+6*srcStride));
+  __m128i a7 = _mm_loadl_epi64((const __m128i*)(src+7*srcStride));
+
+  __m128i b0 = _mm_unpacklo_epi8(a0,a1);
+  __m128i b1 = _mm_unpacklo_epi8(a2,a3);
+  __m128i b2 = _mm_unpacklo_epi8(a4,a5);
+  __m128i b3 = _mm_unpacklo_epi8(a6,a7);
+
+  __m128i c0 = _mm_unpacklo_epi16(b0,b1);
+  __m128i c1 = _mm_unpackhi_epi16(b0,b1);
+  __m128i c2 = _mm_unpacklo_epi16(b2,b3);
+  __m128i c3 = _mm_unpackhi_epi16(b2,b3);
+
+  __m128i d0 = _mm_unpacklo_epi32(c0,c2);
+  __m128i d1 = _mm_unpackhi_epi32(c0,c2);
+  __m128i d2 = _mm_unpacklo_epi32(c1,c3);
+  __m128i d3 = _mm_unpackhi_epi32(c1,c3);
+
+  _mm_storel_epi64((__m128i*)(dst+0*dstStride), d0);
+  _mm_storel_epi64((__m128i*)(dst+1*dstStride), _mm_srli_si128(d0,8));
+  _mm_storel_epi64((__m128i*)(dst+2*dstStride), d1);
+  _mm_storel_epi64((__m128i*)(dst+3*dstStride), _mm_srli_si128(d1,8));
+  _mm_storel_epi64((__m128i*)(dst+4*dstStride), d2);
+  _mm_storel_epi64((__m128i*)(dst+5*dstStride), _mm_srli_si128(d2,8));
+  _mm_storel_epi64((__m128i*)(dst+6*dstStride), d3);
+  _mm_storel_epi64((__m128i*)(dst+7*dstStride), _mm_srli_si128(d3,8));
+}
+
+
+// (8.4.4.2.6)
+void intra_prediction_angular_8_sse(uint8_t* dst, ptrdiff_t dstStride,
+                                    bool disableIntraBoundaryFilter, int intraPredMode,
+                                    int nT, int cIdx, const uint8_t* border)
+{
+  // ref[-nT .. 2*nT], plus overread of the 16-sample loads
+  // cleared, since the overread samples are not all written
+  ALIGNED_16(uint8_t) ref_mem[32 + 2*32+1 + 32] = { 0 };
+  uint8_t* ref = &ref_mem[32];
+
+  const int intraPredAngle = intraPredAngle_table[intraPredMode];
+
+  if (intraPredMode >= 18) {
+
+    memcpy(ref, border, nT+1);
+
+    if (intraPredAngle<0) {
+      int invAngle = invAngle_table[intraPredMode-11];
+
+      if ((nT*intraPredAngle)>>5 < -1) {
+        for (int x=(nT*intraPredAngle)>>5; x<=-1; x++) {
+          ref[x] = border[0-((x*invAngle+128)>>8)];
+        }
+      }
+    } else {
+      memcpy(ref+nT+1, border+nT+1, nT);
+    }
+
+    angular_rows(dst,dstStride, ref, intraPredAngle, nT);
+
+    if (intraPredMode==26 && cIdx==0 && nT<32 && !disableIntraBoundaryFilter) {
+      for (int y=0;y<nT;y++) {
+        dst[0+y*dstStride] = Clip1_8bit(border[1] + ((border[-1-y] - border[0])>>1));
+      }
+    }
+  }
+  else {
+
+    for (int x=0;x<=nT;x++)
+      { ref[x] = border[-x]; }
+
+    if (intraPredAngle<0) {
+      int invAngle = invAngle_table[intraPredMode-11];
+
+      if ((nT*intraPredAngle)>>5 < -1) {
+        for (int x=(nT*intraPredAngle)>>5; x<=-1; x++) {
+          ref[x] = border[((x*invAngle+128)>>8)];
+        }
+      }
+    } else {
+      for (int x=nT+1; x<=2*nT;x++) {
+        ref[x] = border[-x];
+      }
+    }
+
+    // predict transposed block and write it back column-wise
+
+    ALIGNED_16(uint8_t) tmp[32*32];
+    angular_rows(tmp,nT, ref, intraPredAngle, nT);
+
+    if (nT==4) {
+      for (int y=0;y<4;y++)
+        for (int x=0;x<4;x++)
+          dst[x+y*dstStride] = tmp[y+x*4];
+    }
+    else {
+      for (int y=0;y<nT;y+=8)
+        for (int x=0;x<nT;x+=8)
+          transpose_8x8(dst+x+y*dstStride, dstStride, tmp+y+x*nT, nT);
+    }
+
+    if (intraPredMode==10 && cIdx==0 && nT<32 && !disableIntraBoundaryFilter) {
+      for (int x=0;x<nT;x++) {
+        dst[x] = Clip1_8bit(border[-1] + ((border[1+x] - border[0])>>1));
+      }
+    }
+  }
+}
@@ -0,0 +1,37 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SSE_INTRAPRED_H
+#define SSE_INTRAPRED_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+void intra_prediction_sample_filtering_8_sse(uint8_t* pF, const uint8_t* p, int nT);
+void intra_prediction_planar_8_sse(uint8_t* dst, ptrdiff_t dstStride, int nT, int cIdx,
+                                   const uint8_t* border);
+void intra_prediction_DC_8_sse(uint8_t* dst, ptrdiff_t dstStride, int nT, int cIdx,
+                               const uint8_t* border);
+void intra_prediction_angular_8_sse(uint8_t* dst, ptrdiff_t dstStride,
+                                    bool disableIntraBoundaryFilter, int intraPredMode,
+                                    int nT, int cIdx, const uint8_t* border);
+
+#endif
@@ -25,11 +25,16 @@
 #include "x86/sse.h"
 #include "x86/sse-motion.h"
 #include "x86/sse-dct.h"
+#include "x86/sse-intrapred.h"
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 
+#if HAVE_AVX2
+#include "x86/avx2-dct.h"
+#endif
+
 #ifdef __GNUC__
 #include <cpuid.h>
 #endif
@@ -57,6 +62,26 @@ void init_acceleration_functions_sse(struct acceleration_functions* accel)
   int have_SSE    = !!(edx & (1<<25));
   int have_SSE4_1 = !!(ecx & (1<<19));
 
+  // AVX2 also needs OS support for saving the YMM registers (OSXSAVE + XCR0 bits 1,2)
+  int have_AVX2 = 0;
+  if ((ecx & (1<<27)) && (ecx & (1<<28))) {
+    uint32_t xcr0, ebx7=0;
+
+#ifdef _MSC_VER
+    xcr0 = (uint32_t)_xgetbv(0);
+    __cpuidex((int *)regs, 7, 0);
+    ebx7 = regs[1];
+#else
+    uint32_t edx_xcr0, eax7, ecx7, edx7;
+    __asm__ ("xgetbv" : "=a"(xcr0), "=d"(edx_xcr0) : "c"(0));
+    if (__get_cpuid_max(0, NULL) >= 7) {
+      __cpuid_count(7, 0, eax7, ebx7, ecx7, edx7);
+    }
+#endif
+
+    have_AVX2 = ((xcr0 & 6) == 6) && (ebx7 & (1<<5));
+  }
+
   // printf("MMX:%d SSE:%d SSE4_1:%d\n",have_MMX,have_SSE,have_SSE4_1);
 
   if (have_SSE) {
@@ -98,6 +123,65 @@ void init_acceleration_functions_sse(struct acceleration_functions* accel)
     accel->transform_add_8[1] = ff_hevc_transform_8x8_add_8_sse4;
     accel->transform_add_8[2] = ff_hevc_transform_16x16_add_8_sse4;
     accel->transform_add_8[3] = ff_hevc_transform_32x32_add_8_sse4;
+
+    accel->transform_dc_add_8[0] = transform_4x4_dc_add_8_sse4;
+    accel->transform_dc_add_8[1] = transform_8x8_dc_add_8_sse4;
+    accel->transform_dc_add_8[2] = transform_16x16_dc_add_8_sse4;
+    accel->transform_dc_add_8[3] = transform_32x32_dc_add_8_sse4;
+    accel->transform_topleft4x4_add_8[1] = transform_8x8_topleft4x4_add_8_sse4;
+    accel->transform_topleft4x4_add_8[2] = transform_16x16_topleft4x4_add_8_sse4;
+    accel->transform_topleft4x4_add_8[3] = transform_32x32_topleft4x4_add_8_sse4;
+
+    accel->transform_dc_add_16[0] = transform_4x4_dc_add_16_sse4;
+    accel->transform_dc_add_16[1] = transform_8x8_dc_add_16_sse4;
+    accel->transform_dc_add_16[2] = transform_16x16_dc_add_16_sse4;
+    accel->transform_dc_add_16[3] = transform_32x32_dc_add_16_sse4;
+
+    accel->intra_prediction_sample_filtering_8 = intra_prediction_sample_filtering_8_sse;
+    accel->intra_prediction_planar_8  = intra_prediction_planar_8_sse;
+    accel->intra_prediction_DC_8      = intra_prediction_DC_8_sse;
+    accel->intra_prediction_angular_8 = intra_prediction_angular_8_sse;
+  }
+#endif
+
+#if HAVE_AVX2
+  if (have_AVX2) {
+    accel->transform_idst_4x4   = transform_idst_4x4_avx2;
+    accel->transform_idct_4x4   = transform_idct_4x4_avx2;
+    accel->transform_idct_8x8   = transform_idct_8x8_avx2;
+    accel->transform_idct_16x16 = transform_idct_16x16_avx2;
+    accel->transform_idct_32x32 = transform_idct_32x32_avx2;
+
+    accel->transform_4x4_dst_add_8 = transform_4x4_dst_add_8_avx2;
+    accel->transform_add_8[0] = transform_4x4_add_8_avx2;
+    accel->transform_add_8[1] = transform_8x8_add_8_avx2;
+    accel->transform_add_8[2] = transform_16x16_add_8_avx2;
+    accel->transform_add_8[3] = transform_32x32_add_8_avx2;
+
+    accel->transform_4x4_dst_add_16 = transform_4x4_dst_add_16_avx2;
+    accel->transform_add_16[0] = transform_4x4_add_16_avx2;
+    accel->transform_add_16[1] = transform_8x8_add_16_avx2;
+    accel->transform_add_16[2] = transform_16x16_add_16_avx2;
+    accel->transform_add_16[3] = transform_32x32_add_16_avx2;
+
+    // the AVX2 transforms skip all-zero rows and columns themselves
+    accel->transform_topleft4x4_add_8[0]  = transform_4x4_add_8_avx2;
+    accel->transform_topleft4x4_add_16[0] = transform_4x4_add_16_avx2;
+    accel->transform_topleft4x4_add_16[1] = transform_8x8_add_16_avx2;
+    accel->transform_topleft4x4_add_16[2] = transform_16x16_add_16_avx2;
+    accel->transform_topleft4x4_add_16[3] = transform_32x32_add_16_avx2;
+
+    accel->transform_4x4_dst_dequant_add_8 = transform_4x4_dst_dequant_add_8_avx2;
+    accel->transform_dequant_add_8[0] = transform_4x4_dequant_add_8_avx2;
+    accel->transform_dequant_add_8[1] = transform_8x8_dequant_add_8_avx2;
+    accel->transform_dequant_add_8[2] = transform_16x16_dequant_add_8_avx2;
+    accel->transform_dequant_add_8[3] = transform_32x32_dequant_add_8_avx2;
+
+    accel->transform_4x4_dst_dequant_add_16 = transform_4x4_dst_dequant_add_16_avx2;
+    accel->transform_dequant_add_16[0] = transform_4x4_dequant_add_16_avx2;
+    accel->transform_dequant_add_16[1] = transform_8x8_dequant_add_16_avx2;
+    accel->transform_dequant_add_16[2] = transform_16x16_dequant_add_16_avx2;
+    accel->transform_dequant_add_16[3] = transform_32x32_dequant_add_16_avx2;
   }
 #endif
 }
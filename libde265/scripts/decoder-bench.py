@@ -0,0 +1,258 @@
+#!/usr/bin/env python3
+"""
+H.265 video codec.
+Copyright (c) 2014 struktur AG, Dirk Farin <farin@struktur.de>
+
+This file is part of libde265.
+
+libde265 is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+libde265 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+
+End-to-end decoder throughput benchmark that runs offline. A fixed set of
+synthetic sequences (480p to 4K) is encoded with enc265 at a low and a high QP.
+Each stream is then decoded with dec265 with 1..N worker threads, and the frame
+rate, the scaling efficiency relative to one thread and the peak RSS are written
+as JSON, such that the results of two builds can be compared.
+
+Usage: decoder-bench.py [-s WxH]... [-f FRAMES] [-r RUNS] [-t MAXTHREADS]
+                        [-e ENC265] [-d DEC265] [-w WORKDIR] [-o OUT.json]
+                        [--stream FILE]... [-c BASELINE.json]
+
+enc265 can only write intra-coded streams with one slice per picture, without
+WPP or tiles (its low-delay mode is not usable yet). In these streams, only
+the in-loop filters run in parallel. To measure the scaling with inter
+prediction, WPP, tiles or multiple slices, add suitable streams (e.g. from the
+conformance suite) with --stream.
+
+The generated files are kept in the work directory and reused. The MD5 of each
+stream is part of the output to check that two runs used the same bitstreams.
+With -c, the frame rates are compared to the JSON output of an earlier run.
+"""
+import argparse
+import hashlib
+import json
+import os
+import platform
+import re
+import subprocess
+import sys
+import time
+
+DEFAULT_SIZES = ['832x480', '1280x720', '1920x1080', '3840x2160']
+
+# fast encoder settings, the quality of the streams does not matter here
+ENCODER_OPTIONS = [
+    '--sop-structure', 'intra',
+    '--CB-IntraPartMode', 'fixed',
+    '--TB-IntraPredMode', 'min-residual',
+    '--TB-RateEstimation', 'none',
+    '--min-cb-size', '8',
+    '--max-cb-size', '32',
+]
+
+# low QP: CABAC decoding dominates, high QP: prediction and in-loop filters
+CONFIGS = [
+    ('intra-qp22', ['-q', '22']),
+    ('intra-qp37', ['-q', '37']),
+]
+
+
+def write_yuv(filename, width, height, frames):
+    # A diagonal pattern with some texture, shifted in each frame. Each row is
+    # a slice of one long pattern, which keeps this fast even for 4K.
+    period = 251
+    pattern = bytes(((i * 7) ^ (i >> 3)) & 0xFF for i in range(width + period * (frames + 1)))
+    chroma = bytes([128]) * ((width // 2) * (height // 2))
+
+    with open(filename, 'wb') as f:
+        for frame in range(frames):
+            for y in range(height):
+                start = (y * 3 + frame * 5) % period
+                f.write(pattern[start:start + width])
+            f.write(chroma)
+            f.write(chroma)
+
+
+def md5sum(filename):
+    h = hashlib.md5()
+    with open(filename, 'rb') as f:
+        for block in iter(lambda: f.read(1 << 20), b''):
+            h.update(block)
+    return h.hexdigest()
+
+
+def run(cmd):
+    p = subprocess.run(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    if p.returncode != 0:
+        sys.exit('ERROR: %s failed' % ' '.join(cmd))
+
+
+def decode(dec265, stream, threads):
+    """ Returns the number of frames, the wall-clock time and the peak RSS in KiB. """
+    cmd = [dec265, '-q', '-t', str(threads), stream]
+    start = time.monotonic()
+    p = subprocess.Popen(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE,
+                         universal_newlines=True)
+    stderr = p.stderr.read()
+    _, status, rusage = os.wait4(p.pid, 0)
+    elapsed = time.monotonic() - start
+
+    if status != 0:
+        sys.exit('ERROR: %s failed' % ' '.join(cmd))
+
+    m = re.search(r'nFrames decoded: (\d+)', stderr)
+    if m is None:
+        sys.exit('ERROR: no frame count from %s' % ' '.join(cmd))
+
+    return int(m.group(1)), elapsed, rusage.ru_maxrss
+
+
+def generate_streams(args):
+    streams = []
+
+    for size in (args.size or DEFAULT_SIZES):
+        width, height = [int(v) for v in size.split('x')]
+
+        yuv = os.path.join(args.workdir, '%s-%d.yuv' % (size, args.frames))
+        if not os.path.exists(yuv):
+            print('generating %s' % yuv, file=sys.stderr)
+            write_yuv(yuv, width, height, args.frames)
+
+        for config, options in CONFIGS:
+            stream = os.path.join(args.workdir, '%s-%s-%d.bin' % (size, config, args.frames))
+            if not os.path.exists(stream):
+                print('encoding %s' % stream, file=sys.stderr)
+                run([args.enc265, '-i', yuv, '-o', stream,
+                     '-w', str(width), '-h', str(height), '-f', str(args.frames)]
+                    + ENCODER_OPTIONS + options)
+
+            streams.append({'name': '%s-%s' % (size, config), 'file': stream,
+                            'width': width, 'height': height, 'config': config})
+
+    for stream in (args.stream or []):
+        streams.append({'name': os.path.basename(stream), 'file': stream})
+
+    return streams
+
+
+def compare(report, baseline_file):
+    with open(baseline_file) as f:
+        baseline = json.load(f)
+
+    base_fps = {}
+    for stream in baseline['streams']:
+        for t in stream['threads']:
+            base_fps[(stream['name'], stream['md5'], t['threads'])] = t['fps']
+
+    print('%-24s %7s %10s %10s %8s' % ('stream', 'threads', 'base fps', 'fps', 'change'),
+          file=sys.stderr)
+
+    for stream in report['streams']:
+        for t in stream['threads']:
+            key = (stream['name'], stream['md5'], t['threads'])
+            if key not in base_fps:
+                continue  # not in the baseline or a different bitstream
+            print('%-24s %7d %10.2f %10.2f %+7.1f%%' %
+                  (stream['name'], t['threads'], base_fps[key], t['fps'],
+                   (t['fps'] / base_fps[key] - 1) * 100), file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='decoder throughput benchmark')
+    parser.add_argument('-s', '--size', action='append',
+                        help='picture size WxH (default: %s)' % ', '.join(DEFAULT_SIZES))
+    parser.add_argument('-f', '--frames', type=int, default=16,
+                        help='number of frames per generated stream (default: 16)')
+    parser.add_argument('-r', '--runs', type=int, default=3,
+                        help='number of decoding runs, the fastest is reported (default: 3)')
+    parser.add_argument('-t', '--max-threads', type=int, default=os.cpu_count() or 1,
+                        help='decode with 1..MAXTHREADS worker threads (default: number of CPUs)')
+    parser.add_argument('-e', '--enc265', default='./enc265/enc265',
+                        help='enc265 binary')
+    parser.add_argument('-d', '--dec265', default='./dec265/dec265',
+                        help='dec265 binary')
+    parser.add_argument('-w', '--workdir', default='decoder-bench',
+                        help='directory for the generated files')
+    parser.add_argument('-o', '--output', default='-',
+                        help='JSON output file (default: stdout)')
+    parser.add_argument('--stream', action='append',
+                        help='additional stream to decode')
+    parser.add_argument('-c', '--compare',
+                        help='JSON output of an earlier run to compare with')
+    args = parser.parse_args()
+
+    if not os.path.isdir(args.workdir):
+        os.makedirs(args.workdir)
+
+    results = []
+
+    for stream in generate_streams(args):
+        stream['md5'] = md5sum(stream['file'])
+        stream['threads'] = []
+
+        fps1 = None
+        for threads in range(1, args.max_threads + 1):
+            best = None
+            peak_rss = 0
+            for run_idx in range(args.runs):
+                frames, elapsed, rss = decode(args.dec265, stream['file'], threads)
+                peak_rss = max(peak_rss, rss)
+                if best is None or elapsed < best:
+                    best = elapsed
+
+            fps = frames / best
+            if fps1 is None:
+                fps1 = fps
+
+            stream['frames'] = frames
+            stream['threads'].append({
+                'threads': threads,
+                'seconds': round(best, 4),
+                'fps': round(fps, 2),
+                'speedup': round(fps / fps1, 3),
+                'efficiency': round(fps / fps1 / threads, 3),
+                'peak_rss_kib': peak_rss,
+            })
+
+            print('%-24s %2d threads %8.2f fps  eff %5.2f  %7d KiB' %
+                  (stream['name'], threads, fps, fps / fps1 / threads, peak_rss),
+                  file=sys.stderr)
+
+        del stream['file']
+        results.append(stream)
+
+    report = {
+        'host': {
+            'machine': platform.machine(),
+            'system': platform.system(),
+            'cpus': os.cpu_count(),
+        },
+        'frames': args.frames,
+        'runs': args.runs,
+        'streams': results,
+    }
+
+    if args.output == '-':
+        json.dump(report, sys.stdout, indent=2)
+        print()
+    else:
+        with open(args.output, 'w') as f:
+            json.dump(report, f, indent=2)
+            f.write('\n')
+
+    if args.compare:
+        compare(report, args.compare)
+
+
+if __name__ == '__main__':
+    main()
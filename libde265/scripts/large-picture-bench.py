@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""
+H.265 video codec.
+Copyright (c) 2014 struktur AG, Dirk Farin <farin@struktur.de>
+
+This file is part of libde265.
+
+libde265 is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+libde265 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+
+Decode very large pictures (8K, 16K) with small CTBs, such that the pictures
+have more than 65535 CTBs. For each size, a synthetic YUV sequence is generated
+and encoded with enc265 (fast settings). The stream is then decoded with dec265,
+the PSNR against the input is checked to make sure that the pictures were
+decoded correctly, and the best decoding time is reported.
+
+Usage: large-picture-bench.py [-s WxH]... [-c CTBSIZE] [-f FRAMES] [-r RUNS]
+                              [-t THREADS] [-e ENC265] [-d DEC265] [-w WORKDIR]
+
+The generated files are kept in the work directory and reused in later runs.
+"""
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+DEFAULT_SIZES = ['7680x4320', '15360x8640']
+
+ENCODER_OPTIONS = [
+    '--sop-structure', 'intra',
+    '--CB-IntraPartMode', 'fixed',
+    '--TB-IntraPredMode', 'min-residual',
+    '--TB-RateEstimation', 'none',
+    '--min-cb-size', '8',
+]
+
+MIN_PSNR = 25.0
+
+
+def write_yuv(filename, width, height, frames):
+    # A diagonal pattern with some texture, shifted in each frame. Each row is
+    # a slice of one long pattern, which keeps this fast even for 16K.
+    period = 251
+    pattern = bytes(((i * 7) ^ (i >> 3)) & 0xFF for i in range(width + period * (frames + 1)))
+    chroma = bytes([128]) * ((width // 2) * (height // 2))
+
+    with open(filename, 'wb') as f:
+        for frame in range(frames):
+            for y in range(height):
+                start = (y * 3 + frame * 5) % period
+                f.write(pattern[start:start + width])
+            f.write(chroma)
+            f.write(chroma)
+
+
+def run(cmd):
+    p = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL,
+                       universal_newlines=True)
+    if p.returncode != 0:
+        sys.exit('ERROR: %s failed' % ' '.join(cmd))
+    return p.stdout
+
+
+def decode_time(dec265, stream, options):
+    cmd = [dec265, '-q'] + options + [stream]
+    p = subprocess.Popen(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    _, status, rusage = os.wait4(p.pid, 0)
+    if status != 0:
+        sys.exit('ERROR: %s failed' % ' '.join(cmd))
+    return rusage.ru_utime + rusage.ru_stime
+
+
+def main():
+    parser = argparse.ArgumentParser(description='decode very large pictures')
+    parser.add_argument('-s', '--size', action='append',
+                        help='picture size WxH (default: %s)' % ', '.join(DEFAULT_SIZES))
+    parser.add_argument('-c', '--ctb-size', type=int, default=16, choices=[16, 32, 64],
+                        help='CTB size (default: 16)')
+    parser.add_argument('-f', '--frames', type=int, default=2,
+                        help='number of frames (default: 2)')
+    parser.add_argument('-r', '--runs', type=int, default=3,
+                        help='number of decoding runs (default: 3)')
+    parser.add_argument('-t', '--threads', type=int, default=0,
+                        help='number of decoder worker threads')
+    parser.add_argument('-e', '--enc265', default='./enc265/enc265',
+                        help='enc265 binary')
+    parser.add_argument('-d', '--dec265', default='./dec265/dec265',
+                        help='dec265 binary')
+    parser.add_argument('-w', '--workdir', default='large-picture-bench',
+                        help='directory for the generated files')
+    args = parser.parse_args()
+
+    if not os.path.isdir(args.workdir):
+        os.makedirs(args.workdir)
+
+    options = []
+    if args.threads > 0:
+        options = ['-t', str(args.threads)]
+
+    for size in (args.size or DEFAULT_SIZES):
+        width, height = [int(v) for v in size.split('x')]
+        ctbs = (((width + args.ctb_size - 1) // args.ctb_size) *
+                ((height + args.ctb_size - 1) // args.ctb_size))
+
+        name = os.path.join(args.workdir, '%s-%d-%d' % (size, args.ctb_size, args.frames))
+        yuv = name + '.yuv'
+        stream = name + '.bin'
+
+        if not os.path.exists(yuv):
+            print('generating %s' % yuv)
+            write_yuv(yuv, width, height, args.frames)
+
+        if not os.path.exists(stream):
+            print('encoding %s' % stream)
+            run([args.enc265, '-i', yuv, '-o', stream,
+                 '-w', str(width), '-h', str(height), '-f', str(args.frames),
+                 '--max-cb-size', str(args.ctb_size),
+                 '--max-tb-size', str(min(args.ctb_size, 32))] + ENCODER_OPTIONS)
+
+        # check that the decoded pictures match the input
+
+        out = run([args.dec265, '-q', '-m', yuv] + options + [stream])
+        m = re.search(r'^#total\s+(\S+)', out, re.MULTILINE)
+        if m is None:
+            sys.exit('ERROR: no PSNR output for %s' % stream)
+        psnr = float(m.group(1))
+
+        best = None
+        for run_idx in range(args.runs):
+            t = decode_time(args.dec265, stream, options)
+            if best is None or t < best:
+                best = t
+
+        print('%-11s %7d CTBs  PSNR %6.2f dB %s  %8.3f s  %7.1f MSamples/s' %
+              (size, ctbs, psnr, 'ok  ' if psnr >= MIN_PSNR else 'FAIL',
+               best, width * height * args.frames / best / 1e6))
+
+
+if __name__ == '__main__':
+    main()
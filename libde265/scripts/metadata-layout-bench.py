@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""
+H.265 video codec.
+Copyright (c) 2014 struktur AG, Dirk Farin <farin@struktur.de>
+
+This file is part of libde265.
+
+libde265 is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+libde265 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+
+Compare the raster and the CTB-major layout of the block metadata arrays.
+The layout is chosen at compile time, so this needs two builds of dec265, the
+second one configured with ENABLE_TILED_METADATA (cmake) or
+--enable-tiled-metadata (configure). For each stream, both decoders are run
+alternately and the best decoding time is reported. If 'perf' is available,
+the L1 and L2/LLC data cache misses are measured in an extra run.
+
+Usage: metadata-layout-bench.py [-r RUNS] [-t THREADS] RASTER-DEC265 TILED-DEC265 stream.bin...
+
+Use 1080p and 4K streams to see the effect, at small resolutions all the
+metadata fits into the caches anyway.
+"""
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+
+MODES = ['raster', 'tiled']
+
+PERF_EVENTS = ['L1-dcache-load-misses', 'LLC-load-misses']
+
+
+def decode_time(dec265, stream, options):
+    cmd = [dec265, '-q'] + options + [stream]
+    p = subprocess.Popen(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    _, status, rusage = os.wait4(p.pid, 0)
+    if status != 0:
+        sys.exit('ERROR: %s failed' % ' '.join(cmd))
+    return rusage.ru_utime + rusage.ru_stime
+
+
+def cache_misses(dec265, stream, options, events):
+    cmd = ['perf', 'stat', '-x', ',', '-e', ','.join(events),
+           dec265, '-q'] + options + [stream]
+    p = subprocess.run(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE,
+                       universal_newlines=True)
+
+    misses = {}
+    for line in p.stderr.splitlines():
+        fields = line.split(',')
+        if len(fields) > 2 and fields[2] in events:
+            try:
+                misses[fields[2]] = int(fields[0])
+            except ValueError:
+                pass  # '<not supported>' or '<not counted>'
+    return misses
+
+
+def main():
+    parser = argparse.ArgumentParser(description='compare metadata layouts')
+    parser.add_argument('-r', '--runs', type=int, default=5,
+                        help='number of decoding runs per mode (default: 5)')
+    parser.add_argument('-t', '--threads', type=int, default=0,
+                        help='number of decoder worker threads')
+    parser.add_argument('--no-perf', action='store_true',
+                        help='do not measure cache misses')
+    parser.add_argument('raster_dec265', help='dec265 built with the raster layout')
+    parser.add_argument('tiled_dec265', help='dec265 built with the tiled layout')
+    parser.add_argument('streams', nargs='+')
+    args = parser.parse_args()
+
+    decoders = {'raster': args.raster_dec265, 'tiled': args.tiled_dec265}
+
+    use_perf = not args.no_perf and shutil.which('perf') is not None
+
+    options = []
+    if args.threads > 0:
+        options = ['-t', str(args.threads)]
+
+    for stream in args.streams:
+        print('%s:' % stream)
+
+        # interleave the modes such that both see the same machine load
+        best = dict((name, None) for name in MODES)
+        for run in range(args.runs):
+            for name in MODES:
+                t = decode_time(decoders[name], stream, options)
+                if best[name] is None or t < best[name]:
+                    best[name] = t
+
+        for name in MODES:
+            line = '  %-8s %8.3f s' % (name, best[name])
+
+            if use_perf:
+                misses = cache_misses(decoders[name], stream, options, PERF_EVENTS)
+                for event in PERF_EVENTS:
+                    if event in misses:
+                        line += '  %s: %d' % (event, misses[event])
+
+            print(line)
+
+        print('  speedup  %8.3f' % (best['raster'] / best['tiled']))
+
+
+if __name__ == '__main__':
+    main()
@@ -55,7 +55,8 @@ VideoDecoder::VideoDecoder()
       mShowMotionVec(false),
       mShowMotionCol(true),
       mShowTiles(false),
-      mShowSlices(false)
+      mShowSlices(false),
+      mShowCTBCost(false)
 #ifdef HAVE_SWSCALE
       ,
       sws(NULL), width(0), height(0)
@@ -354,6 +355,11 @@ void VideoDecoder::show_frame(const de265_image *img)
     draw_Slices(img, ptr, bpl, 4);
   }
 
+  if (mShowCTBCost)
+  {
+    draw_CTB_cost(img, ptr, bpl, CTB_Cost_Time, 4);
+  }
+
   if (mShowTiles)
   {
     draw_Tiles(img, ptr, bpl, 4);
@@ -496,6 +502,18 @@ void VideoDecoder::showSlices(bool flag)
   mutex.unlock();
 }
 
+void VideoDecoder::showCTBCost(bool flag)
+{
+  mShowCTBCost = flag;
+
+  mutex.lock();
+  if (img != NULL)
+  {
+    show_frame(img);
+  }
+  mutex.unlock();
+}
+
 void VideoDecoder::init_decoder(const char *filename)
 {
   mFH = fopen(filename, "rb");
@@ -503,6 +521,8 @@ void VideoDecoder::init_decoder(const char *filename)
   //rbsp_buffer_init(&buf);
 
   ctx = de265_new_decoder();
+  de265_set_parameter_bool(ctx, DE265_DECODER_PARAM_KEEP_FULL_MOTION_INFO, 1); // needed for draw_Motion()
+  de265_set_parameter_bool(ctx, DE265_DECODER_PARAM_CTB_COST, 1); // needed for draw_CTB_cost()
   de265_start_worker_threads(ctx, 4); // start 4 background threads
 }
 
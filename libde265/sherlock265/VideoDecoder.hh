@@ -74,6 +74,7 @@ public slots:
   void showMotionCol(bool flag);
   void showTiles(bool flag);
   void showSlices(bool flag);
+  void showCTBCost(bool flag);
   void showDecodedImage(bool flag);
 
 signals:
@@ -109,6 +110,7 @@ private:
   bool mShowMotionCol;
   bool mShowTiles;
   bool mShowSlices;
+  bool mShowCTBCost;
 
   void decoder_loop();
 
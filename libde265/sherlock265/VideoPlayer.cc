@@ -97,6 +97,11 @@ VideoPlayer::VideoPlayer(const char *filename)
   QObject::connect(showSlicesButton, SIGNAL(toggled(bool)),
                    mDecoder, SLOT(showSlices(bool)));
 
+  QPushButton *showCTBCostButton = new QPushButton("CTB cost");
+  showCTBCostButton->setCheckable(true);
+  QObject::connect(showCTBCostButton, SIGNAL(toggled(bool)),
+                   mDecoder, SLOT(showCTBCost(bool)));
+
   QPushButton *showDecodedImageButton = new QPushButton("image");
   showDecodedImageButton->setCheckable(true);
   showDecodedImageButton->setChecked(true);
@@ -118,6 +123,7 @@ VideoPlayer::VideoPlayer(const char *filename)
   layout->addWidget(showIntraPredModeButton, 2, 3, 1, 1);
   layout->addWidget(showPBPredModeButton, 2, 4, 1, 1);
   layout->addWidget(showQuantPYButton, 2, 5, 1, 1);
+  layout->addWidget(showCTBCostButton, 2, 6, 1, 1);
   layout->addWidget(showMotionVecButton, 2, 6, 1, 1);
   setLayout(layout);
 
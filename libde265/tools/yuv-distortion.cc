@@ -27,34 +27,6 @@
 
 #include <libde265/quality.h>
 
-#if HAVE_VIDEOGFX
-#include <libvideogfx.hh>
-using namespace videogfx;
-#endif
-
-
-float ssim(const uint8_t* img1,
-           const uint8_t* img2,
-           int width, int height)
-{
-#if HAVE_VIDEOGFX
-  Bitmap<Pixel> ref, coded;
-  ref  .Create(width, height); // reference image
-  coded.Create(width, height); // coded image
-
-  for (int y=0;y<height;y++) {
-    memcpy(coded[y], img1 + y*width, width);
-    memcpy(ref[y],   img2 + y*width, width);
-  }
-
-  SSIM ssimAlgo;
-  return ssimAlgo.calcMSSIM(ref,coded);
-#else
-  return 0;
-#endif
-}
-
-
 int main(int argc, char** argv)
 {
   if (argc != 5) {
@@ -95,7 +67,7 @@ int main(int argc, char** argv)
       double curr_mse_y = MSE(yp_ref, width,  yp_cmp, width,  width, height);
       mse_y += curr_mse_y;
 
-      double curr_ssim_y = ssim(yp_ref, yp_cmp, width, height);
+      double curr_ssim_y = SSIM(yp_cmp, width, yp_ref, width, width, height);
       ssim_y += curr_ssim_y;
 
       printf("%4d %f %f\n",nFrames,PSNR(curr_mse_y),curr_ssim_y);